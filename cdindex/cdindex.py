@@ -21,22 +21,31 @@ except ImportError:
 if "READTHEDOCS" not in os.environ:
   try: 
     import cdindex._cdindex as _cdindex
+    import cdindex._cdindex_compact as _cdindex_compact
   except ImportError:
     import _cdindex
+    import _cdindex_compact
 
 try:
   import cdindex.time_utilities
 except ImportError:
   import time_utilities
 
+# the vertex orders of Graph.freeze, numbered as in the C extension
+_ORDERINGS = {None: 0, "time": 1, "degree": 2, "rcm": 3}
+
 class Graph:
   """Create a graph.
 
   This class defines a graph data structure on which to compute the cdindex and other
   functions that are made available through the module.
+
+  The computations release the GIL, so several Python threads can compute on
+  one graph at the same time. Adding vertices or edges while a computation is
+  running in another thread raises a RuntimeError.
   """  
   
-  def __init__(self, vertices=[], edges=[]):
+  def __init__(self, vertices=[], edges=[], arena=False, compact=False, names=True):
     """Initialize a new graph.
 
     Create a new graph for analysis. Vertices and edges can be added either when the graph
@@ -80,20 +89,188 @@ class Graph:
       [{"name": "0Z", "time": datetime.datetime(1992, 1, 1)}].
     edges : 
       List of edges with sources and targets, e.g., [{"source": "4Z", "target": "2Z"}].
+    arena : bool
+      Whether to take the memory for edges from large chunks rather than one
+      allocation per vertex, which uses less memory and makes freeing a large
+      graph (e.g., at interpreter exit) nearly instant.
+    compact : bool
+      Whether to store vertex ids and timestamps as 32 bit integers, which
+      nearly halves the memory taken by edges. Graphs of up to 2^32 vertices
+      with timestamps between -2^31 and 2^31 - 1 fit; adding anything else
+      raises a ValueError.
+    names : bool
+      Whether vertices have names of their own. With names=False, vertices
+      are named by their integer ids, 0, 1, 2, ... in the order they are
+      added, and no mapping between names and ids is kept. This saves two
+      dicts of Python objects per vertex, makes adding vertices and edges
+      cheaper, and lets arrays of ids (e.g., NumPy arrays) pass to the batch
+      functions without translation.
+    """
+
+    self._cdindex = _cdindex_compact if compact else _cdindex
+    self._graph = self._cdindex.Graph(arena)
+    self._frozen_graph = None
+    self._compressed_graph = None
+    self._vertex_name_crosswalk = {} if names else None
+    self._vertex_id_crosswalk = {} if names else None
+
+    # add vertices and edges (which may be any iterables, but only sized
+    # ones give a reserve hint)
+    if vertices or edges:
+      if hasattr(vertices, "__len__") and hasattr(edges, "__len__"):
+        self.reserve(len(vertices), len(edges))
+      self.bulk_load(vertices, edges)
+
+  def _has_vertex(self, name):
+    """Check whether a vertex name is in the graph."""
+    if self._vertex_name_crosswalk is None:
+      return isinstance(name, int) and 0 <= name < self._cdindex.get_vcount(self._graph)
+    return name in self._vertex_name_crosswalk
+
+  def _vertex_id(self, name):
+    """Translate a vertex name to its id in the C extension (KeyError if it is not in the graph)."""
+    if self._vertex_name_crosswalk is None:
+      if not self._has_vertex(name):
+        raise KeyError(name)
+      return name
+    return self._vertex_name_crosswalk[name]
+
+  def _vertex_ids(self, names):
+    """Translate vertex names to ids for the batch functions, which check the ids."""
+    if self._vertex_name_crosswalk is None:
+      return names
+    return [self._vertex_name_crosswalk[name] for name in names]
+
+  def _vertex_names(self, vertex_ids):
+    """Translate ids from the C extension to vertex names."""
+    if self._vertex_id_crosswalk is None:
+      return vertex_ids
+    return [self._vertex_id_crosswalk[vertex_id] for vertex_id in vertex_ids]
+
+  def reserve(self, vcount, ecount):
+    """Reserve memory for the vertices and edges the graph is expected to hold.
+
+    Storage grows as needed, so this is only a hint, but calling it before
+    adding many vertices and edges one at a time avoids most reallocations.
+
+    Parameters
+    ----------
+    vcount : int
+      The expected total number of vertices.
+    ecount : int
+      The expected total number of edges.
+
+    Negative counts raise a ValueError, and a vertex count too large to
+    allocate raises a MemoryError.
     """
+    self._cdindex.graph_reserve(self._graph, vcount, ecount)
+
+  def memory_usage(self):
+    """Report the memory taken by the vertices and edges of the graph.
+
+    Returns
+    -------
+    tuple
+      The bytes holding vertices and edges, and the bytes allocated for them
+      including spare capacity.
+    """
+    return self._cdindex.get_memory_usage(self._graph)
+
+  def bulk_load(self, vertices=[], edges=[]):
+    """Add many vertices and edges to the graph at once.
+
+    This function adds lists of vertices and edges, formatted as for the graph
+    constructor, in a single call to the C extension. It is much faster than
+    adding vertices and edges one by one. Edges may refer to vertices already
+    in the graph or to vertices in the same call. If any vertex or edge is
+    invalid, a ValueError is raised and the graph is left unchanged.
 
-    self._graph = _cdindex.Graph()
-    self._vertex_name_crosswalk = {}
-    self._vertex_id_crosswalk = {}
+    Parameters
+    ----------
+    vertices :
+      List of vertices with names and timestamps, e.g.,
+      [{"name": "0Z", "time": datetime.datetime(1992, 1, 1)}].
+    edges :
+      List of edges with sources and targets, e.g., [{"source": "4Z", "target": "2Z"}].
+    """
 
-    # add vertices
+    # assign ids to the new vertices
+    first_id = self.vcount()
+    new_names = {}
+    ids = []
+    timestamps = []
     for vertex in vertices:
-      self.add_vertex(vertex["name"], vertex["time"])
+      name, t = vertex["name"], vertex["time"]
+      if self._vertex_name_crosswalk is None:
+        if name != first_id + len(ids):
+          raise ValueError("Vertex ids must be added sequentially from 0")
+      elif name in self._vertex_name_crosswalk or name in new_names:
+        raise ValueError("Vertex already added to graph")
+      if isinstance(t, (int)) is False:
+        raise ValueError("Time (t) of vertex must be an integer or long")
+      new_names[name] = first_id + len(ids)
+      ids.append(first_id + len(ids))
+      timestamps.append(t)
+
+    # translate edge names to ids (without names, the ids are checked in C)
+    if self._vertex_name_crosswalk is None:
+      edge_ids = [(edge["source"], edge["target"]) for edge in edges]
+    else:
+      edge_ids = []
+      for edge in edges:
+        source_name, target_name = edge["source"], edge["target"]
+        source_id = self._vertex_name_crosswalk.get(source_name, new_names.get(source_name))
+        target_id = self._vertex_name_crosswalk.get(target_name, new_names.get(target_name))
+        if source_id is None or target_id is None:
+          raise ValueError("One or more vertices are not in the graph")
+        edge_ids.append((source_id, target_id))
+
+    # add the vertices and edges
+    self._frozen_graph = None
+    self._compressed_graph = None
+    self._cdindex.bulk_load_graph(self._graph, ids, timestamps, edge_ids)
+    if self._vertex_name_crosswalk is None:
+      return
+    for name, vertex_id in new_names.items():
+      self._vertex_name_crosswalk[name] = vertex_id
+      self._vertex_id_crosswalk[vertex_id] = name
+
+  def bulk_load_arrays(self, timestamps, edges, ids=None):
+    """Add many vertices and edges to the graph from arrays of integers.
+
+    This function is the counterpart of bulk_load for large data held in
+    arrays, e.g., NumPy arrays or pandas columns. The arrays are read through
+    the buffer protocol, without creating a Python object per vertex or edge,
+    and contiguous 64 bit arrays are used in place without copying. The new
+    vertices are named by their integer ids, which continue from vcount().
+
+    Parameters
+    ----------
+    timestamps :
+      An array of 32 or 64 bit integers with the timestamp of each new vertex.
+    edges :
+      An array of 32 or 64 bit integers with a source and a target id per edge,
+      shaped (ecount, 2) or flat. Edges may refer to vertices already in the
+      graph or to the new ones.
+    ids :
+      An array with the ids of the new vertices, which must be consecutive
+      from vcount(), or None to number them in order.
+    """
+    if self._vertex_name_crosswalk is None:
+      self._frozen_graph = None
+      self._compressed_graph = None
+      self._cdindex.bulk_load_arrays(self._graph, ids, timestamps, edges)
+      return
+    first_id = self.vcount()
+    new_ids = range(first_id, first_id + len(memoryview(timestamps)))
+    if not self._vertex_name_crosswalk.keys().isdisjoint(new_ids):
+      raise ValueError("Vertex already added to graph")
+    self._frozen_graph = None
+    self._compressed_graph = None
+    self._cdindex.bulk_load_arrays(self._graph, ids, timestamps, edges)
+    self._vertex_name_crosswalk.update(zip(new_ids, new_ids))
+    self._vertex_id_crosswalk.update(zip(new_ids, new_ids))
 
-    # add edges
-    for edge in edges:
-      self.add_edge(edge["source"], edge["target"])
-    
   def add_vertex(self, name, t):
     """Add a new vertex to the graph.
 
@@ -107,16 +284,21 @@ class Graph:
       The vertex timestamp.
     """
     vertex_id = self.vcount()
-    if name in self._vertex_name_crosswalk:
+    if self._vertex_name_crosswalk is None:
+      if name != vertex_id:
+        raise ValueError("Vertex ids must be added sequentially from 0")
+    elif name in self._vertex_name_crosswalk:
      raise ValueError("Vertex already added to graph")
-    else:
-      self._vertex_name_crosswalk[name] = vertex_id
-      self._vertex_id_crosswalk[vertex_id] = name
     if isinstance(t, (int)) is False:
       raise ValueError("Time (t) of vertex must be an integer or long")
 
-    # add the vertex
-    _cdindex.add_vertex(self._graph, vertex_id, t)
+    # add the vertex, and name it only once the C extension has accepted it
+    self._cdindex.add_vertex(self._graph, vertex_id, t)
+    self._frozen_graph = None
+    self._compressed_graph = None
+    if self._vertex_name_crosswalk is not None:
+      self._vertex_name_crosswalk[name] = vertex_id
+      self._vertex_id_crosswalk[vertex_id] = name
 
   def add_edge(self, source_name, target_name):
     """Add a new edge to the graph.
@@ -131,15 +313,131 @@ class Graph:
     target_name :
       The target vertex timestamp.
     """
-    if (source_name not in self._vertex_name_crosswalk
-        or target_name not in self._vertex_name_crosswalk):
+    if self._vertex_name_crosswalk is None:
+      source_id, target_id = source_name, target_name
+    elif (source_name not in self._vertex_name_crosswalk
+          or target_name not in self._vertex_name_crosswalk):
       raise ValueError("One or more vertices are not in the graph")
-    elif (target_name in self.out_edges(source_name)):
-      raise ValueError("The edge being added is already in the graph")
     else:
-      _cdindex.add_edge(self._graph,
-                        self._vertex_name_crosswalk[source_name],
-                        self._vertex_name_crosswalk[target_name])
+      source_id = self._vertex_name_crosswalk[source_name]
+      target_id = self._vertex_name_crosswalk[target_name]
+
+    # the C extension checks the ids and rejects edges already in the graph
+    self._cdindex.add_edge(self._graph, source_id, target_id)
+    self._frozen_graph = None
+    self._compressed_graph = None
+
+  def sort_adjacency(self):
+    """Sort the out edges of every vertex.
+
+    The cdindex and mcdindex computations are faster when the out edges of
+    each vertex are sorted. Graphs built with the constructor or a single call
+    to bulk_load are already sorted, but adding edges out of order afterward
+    falls back to slower scans until this function is called. Note that this
+    changes the order in which out_edges returns the edges of a vertex.
+    """
+    self._cdindex.sort_adjacency(self._graph)
+
+  def freeze(self, by_time=False, order=None):
+    """Freeze the graph for faster computation.
+
+    This function copies the graph into a read-only compressed sparse row
+    structure, in which the edges of all vertices are stored contiguously in
+    memory. Subsequent calls to cdindex, mcdindex, and iindex run on the frozen
+    copy. Adding a vertex or an edge discards the frozen copy, so freeze the
+    graph again once it is fully built.
+
+    Parameters
+    ----------
+    by_time : bool
+      Whether to order the in edges of each vertex by time and store their
+      timestamps alongside them. The citers within a t_delta are then found
+      with binary searches, which makes iindex take logarithmic time and
+      speeds up short horizons on highly cited vertices, at the cost of one
+      timestamp per edge. Snapshots saved from the graph keep the ordering.
+    order : str
+      The order in which to store the vertices of the frozen copy: None for
+      the order they were added in, "time" by timestamp, "degree" by
+      decreasing degree, or "rcm" (reverse Cuthill-McKee) to place vertices
+      near the vertices they cite and are cited by. Vertices keep their names
+      and ids; a better order only makes the traversals of large graphs hit
+      nearby memory. Snapshots saved from the graph keep the order.
+    """
+    if order not in _ORDERINGS:
+      raise ValueError("Unknown vertex order %r" % (order,))
+    self._frozen_graph = self._cdindex.freeze_graph(self._graph, by_time, _ORDERINGS[order])
+    self._compressed_graph = None
+
+  def compress(self):
+    """Compress the graph to save memory.
+
+    This function copies the graph into a read-only structure in which the
+    sorted neighbors of each vertex are stored as variable length gaps, which
+    usually takes a quarter of the memory of a frozen graph. Subsequent calls
+    to cdindex, mcdindex, iindex and the batch functions decode the neighbors
+    as they go on the compressed copy, which is slower than on a frozen graph
+    and always uses one thread. As with freeze, adding a vertex or an edge
+    discards the compressed copy, and the most recent of freeze and compress
+    is used.
+
+    Returns
+    -------
+    int
+      The bytes taken by the compressed copy.
+    """
+    self._compressed_graph = self._cdindex.compress_graph(self._graph)
+    self._frozen_graph = None
+    return self._cdindex.get_compressed_memory(self._compressed_graph)
+
+  def save_snapshot(self, path):
+    """Write the graph to a binary snapshot file.
+
+    The snapshot holds the frozen form of the graph and can be loaded almost
+    instantly with MappedGraph, which maps the file into memory instead of
+    reading it. Vertex names are not stored: in the snapshot, vertices are
+    numbered by their position in vertices().
+
+    Parameters
+    ----------
+    path : str
+      The file to write.
+    """
+    frozen_graph = self._frozen_graph
+    if frozen_graph is None:
+      frozen_graph = self._cdindex.freeze_graph(self._graph)
+    self._cdindex.save_frozen_graph(frozen_graph, path)
+
+  def arrays(self, by_time=False):
+    """Return the compressed sparse row arrays of the graph.
+
+    The arrays are those of the frozen copy of the graph (see freeze), which
+    is made if the graph is not frozen. They view the memory of the C
+    extension without copying it, and stay valid after the graph changes.
+    Vertices are numbered by their ids, in the order of vertices().
+
+    Parameters
+    ----------
+    by_time : bool
+      Whether to order the in edges of each vertex by time, as in freeze, when
+      the graph is not already frozen.
+
+    Returns
+    -------
+    dict
+      Read-only memoryviews of integers that can be wrapped without copying,
+      e.g., with numpy.asarray: "timestamps" (one per vertex), "in_offsets"
+      and "out_offsets" (vcount() + 1 each, the start of the edges of each
+      vertex), "in_edges" and "out_edges" (the neighbor ids), and "in_times"
+      (the timestamp of each in edge) if the in edges are ordered by time.
+      If the graph was frozen with an order, the arrays are indexed by
+      storage position and the neighbors are positions too: "public_ids"
+      gives the id at each position and "internal_ids" the position of each
+      id.
+    """
+    frozen_graph = self._frozen_graph
+    if frozen_graph is None:
+      frozen_graph = self._cdindex.freeze_graph(self._graph, by_time)
+    return self._cdindex.get_frozen_arrays(frozen_graph)
 
   def vcount(self):
     """Return the number of vertices in the graph.
@@ -153,7 +451,7 @@ class Graph:
     int
       The number of vertices.
     """
-    return _cdindex.get_vcount(self._graph)
+    return self._cdindex.get_vcount(self._graph)
 
   def _c_vertices(self):
     """Return the ids of the vertices in the graph from the C extension.
@@ -169,7 +467,7 @@ class Graph:
     list
       The vertices.
     """
-    return _cdindex.get_vertices(self._graph)
+    return self._cdindex.get_vertices(self._graph)
 
   def vertices(self):
     """Return the vertices in the graph.
@@ -183,6 +481,8 @@ class Graph:
     list
       The vertices.
     """
+    if self._vertex_name_crosswalk is None:
+      return range(self.vcount())
     return self._vertex_name_crosswalk.keys()
 
   def ecount(self):
@@ -197,7 +497,7 @@ class Graph:
     int
       The number of edges.
     """
-    return _cdindex.get_ecount(self._graph)
+    return self._cdindex.get_ecount(self._graph)
 
   def in_degree(self, name):
     """Return the in degree of the focal vertex.
@@ -217,8 +517,8 @@ class Graph:
     int
       The in degree centrality.
     """
-    return _cdindex.get_vertex_in_degree(self._graph,
-                                         self._vertex_name_crosswalk[name])
+    return self._cdindex.get_vertex_in_degree(self._graph,
+                                              self._vertex_id(name))
 
   def in_edges(self, name):
     """Return the in edges of the focal vertex.
@@ -238,9 +538,9 @@ class Graph:
     list
       The in edges.
     """
-    in_edges_ids = _cdindex.get_vertex_in_edges(self._graph,
-                                                self._vertex_name_crosswalk[name])
-    return [self._vertex_id_crosswalk[vertex_id] for vertex_id in in_edges_ids]
+    in_edges_ids = self._cdindex.get_vertex_in_edges(self._graph,
+                                                     self._vertex_id(name))
+    return self._vertex_names(in_edges_ids)
 
   def out_degree(self, name):
     """Return the out degree of the focal vertex.
@@ -260,8 +560,8 @@ class Graph:
     int
       The out degree centrality.
     """
-    return _cdindex.get_vertex_out_degree(self._graph,
-                                          self._vertex_name_crosswalk[name])
+    return self._cdindex.get_vertex_out_degree(self._graph,
+                                               self._vertex_id(name))
 
   def out_edges(self, name):
     """Return the out edges of the focal vertex.
@@ -281,9 +581,9 @@ class Graph:
     list
       The out edges.
     """
-    out_edges_ids = _cdindex.get_vertex_out_edges(self._graph,
-                                                  self._vertex_name_crosswalk[name])
-    return [self._vertex_id_crosswalk[vertex_id] for vertex_id in out_edges_ids]
+    out_edges_ids = self._cdindex.get_vertex_out_edges(self._graph,
+                                                       self._vertex_id(name))
+    return self._vertex_names(out_edges_ids)
 
   def timestamp(self, name):
     """Return the timestamp of the focal vertex.
@@ -300,8 +600,8 @@ class Graph:
     int
       The timestamp.
     """
-    return _cdindex.get_vertex_timestamp(self._graph,
-                                         self._vertex_name_crosswalk[name])
+    return self._cdindex.get_vertex_timestamp(self._graph,
+                                              self._vertex_id(name))
 
   def cdindex(self, name, t_delta):
     """Compute the CD index.
@@ -323,9 +623,18 @@ class Graph:
     """
     if isinstance(t_delta, (int)) is False:
       raise ValueError("Time delta (t_delta) must be an integer or long")
-    result = _cdindex.cdindex(self._graph,
-                              self._vertex_name_crosswalk[name],
-                              t_delta)
+    if self._frozen_graph is not None:
+      result = self._cdindex.frozen_cdindex(self._frozen_graph,
+                                            self._vertex_id(name),
+                                            t_delta)
+    elif self._compressed_graph is not None:
+      result = self._cdindex.compressed_cdindex(self._compressed_graph,
+                                                self._vertex_id(name),
+                                                t_delta)
+    else:
+      result = self._cdindex.cdindex(self._graph,
+                                     self._vertex_id(name),
+                                     t_delta)
     if math.isnan(result):
       return None
     else:
@@ -351,10 +660,19 @@ class Graph:
     """
     if isinstance(t_delta, (int)) is False:
       raise ValueError("Time delta (t_delta) must be an integer or long")
-    
-    result = _cdindex.mcdindex(self._graph,
-                               self._vertex_name_crosswalk[name],
-                               t_delta)
+
+    if self._frozen_graph is not None:
+      result = self._cdindex.frozen_mcdindex(self._frozen_graph,
+                                             self._vertex_id(name),
+                                             t_delta)
+    elif self._compressed_graph is not None:
+      result = self._cdindex.compressed_mcdindex(self._compressed_graph,
+                                                 self._vertex_id(name),
+                                                 t_delta)
+    else:
+      result = self._cdindex.mcdindex(self._graph,
+                                      self._vertex_id(name),
+                                      t_delta)
     if math.isnan(result):
       return None
     else:
@@ -380,10 +698,326 @@ class Graph:
     """
     if isinstance(t_delta, (int)) is False:
       raise ValueError("Time delta (t_delta) must be an integer or long")
-    return _cdindex.iindex(self._graph,
-                             self._vertex_name_crosswalk[name],
+    if self._frozen_graph is not None:
+      return self._cdindex.frozen_iindex(self._frozen_graph,
+                                         self._vertex_id(name),
+                                         t_delta)
+    if self._compressed_graph is not None:
+      return self._cdindex.compressed_iindex(self._compressed_graph,
+                                             self._vertex_id(name),
+                                             t_delta)
+    return self._cdindex.iindex(self._graph,
+                             self._vertex_id(name),
                              t_delta)
 
+  def cdindex_components(self, name, t_delta):
+    """Compute the components of the CD index and the derived indices.
+
+    One traversal gives the counts behind the CD index of a vertex at a
+    given t_delta, the CD index, the I index and the mCD index, which is
+    cheaper than calling cdindex, iindex and mcdindex in turn.
+
+    Parameters
+    ----------
+    t_delta : int
+      A time delta.
+
+    Returns
+    -------
+    dict
+      n_f, the number of "it" vertices citing the focal vertex but none of
+      its references, n_b, the number citing both, n_r, the number citing
+      only its references, and the cdindex, iindex and mcdindex (None for
+      the CD and mCD index where there are no "it" vertices).
+    """
+    return self._components(name, t_delta)
+
+  def _components(self, name, t_delta, cutoff=None):
+    """Compute the components of the CD index, as of a cutoff if one is given."""
+    if isinstance(t_delta, (int)) is False:
+      raise ValueError("Time delta (t_delta) must be an integer or long")
+    if self._frozen_graph is not None:
+      result = self._cdindex.frozen_cdindex_components(self._frozen_graph,
+                                                       self._vertex_id(name),
+                                                       t_delta, cutoff)
+    elif self._compressed_graph is not None:
+      result = self._cdindex.compressed_cdindex_components(self._compressed_graph,
+                                                           self._vertex_id(name),
+                                                           t_delta, cutoff)
+    else:
+      result = self._cdindex.cdindex_components(self._graph,
+                                                self._vertex_id(name),
+                                                t_delta, cutoff)
+    for key in ("cdindex", "mcdindex"):
+      if math.isnan(result[key]):
+        result[key] = None
+    return result
+
+  def cdindex_estimate(self, name, t_delta, tolerance=0.01, confidence=0.95,
+                       exact_below=10000, seed=1):
+    """Estimate the CD index from a sample of the vertices citing a vertex.
+
+    For vertices with a very large number of citers, the CD index can be
+    estimated from a sample much faster than it is computed. The direct
+    citers and the citers of the references are sampled separately, and the
+    samples grow until the confidence interval is within tolerance of the
+    estimate. Vertices with fewer than exact_below citers in the window, or
+    for which the sample would grow as large as the citers themselves, get
+    the exact value. Sampling runs on the frozen copy of the graph and is
+    fastest after freeze(by_time=True); on a graph that is not frozen the
+    exact value is returned.
+
+    Parameters
+    ----------
+    t_delta : int
+      A time delta.
+    tolerance : float
+      The largest half width of the confidence interval.
+    confidence : float
+      The confidence level of the interval.
+    exact_below : int
+      The number of citers below which the index is computed exactly.
+    seed : int
+      The seed of the sample; the same seed gives the same estimate.
+
+    Returns
+    -------
+    dict
+      The cdindex estimate, the lower and upper bounds of the interval,
+      whether the value is exact, and the number of citers sampled (or
+      classified, when exact). The index and bounds are None where there are
+      no "it" vertices.
+    """
+    if isinstance(t_delta, (int)) is False:
+      raise ValueError("Time delta (t_delta) must be an integer or long")
+    if self._frozen_graph is not None:
+      result = self._cdindex.frozen_cdindex_estimate(self._frozen_graph, self._vertex_id(name),
+                                                     t_delta, tolerance, confidence,
+                                                     exact_below, seed)
+    else:
+      components = self.cdindex_components(name, t_delta)
+      value = components["cdindex"]
+      return {"cdindex": value, "lower": value, "upper": value, "exact": True,
+              "sampled": components["n_f"] + components["n_b"] + components["n_r"]}
+    for key in ("cdindex", "lower", "upper"):
+      if math.isnan(result[key]):
+        result[key] = None
+    return result
+
+  def _batch(self, function, frozen_function, compressed_function, names, t_delta, threads,
+             cutoff=None):
+    """Compute a measure for many vertices with a batch function of the C extension."""
+    if isinstance(t_delta, (int)) is False:
+      raise ValueError("Time delta (t_delta) must be an integer or long")
+    if names is None:
+      ids = None
+    else:
+      ids = self._vertex_ids(names)
+    if self._frozen_graph is not None:
+      return frozen_function(self._frozen_graph, ids, t_delta, threads, cutoff)
+    if self._compressed_graph is not None:
+      return compressed_function(self._compressed_graph, ids, t_delta, threads, cutoff)
+    return function(self._graph, ids, t_delta, threads, cutoff)
+
+  def cdindex_batch(self, names, t_delta, threads=1):
+    """Compute the CD index for many vertices.
+
+    This function computes the CD index for each of a list of vertices at a
+    given t_delta in a single call to the C extension, which is much faster
+    than calling cdindex once per vertex. With more than one thread, vertices
+    are spread across threads, starting with the most expensive ones.
+
+    Parameters
+    ----------
+    names :
+      The vertex names, or None for every vertex in the graph (in the order
+      returned by vertices).
+    t_delta : int
+      A time delta.
+    threads : int
+      The number of threads to use, or 0 for one per processor.
+
+    Returns
+    -------
+    memoryview
+      A contiguous array of doubles, one per vertex, with nan where the CD
+      index is undefined. It can be wrapped without copying, e.g., with
+      numpy.asarray.
+    """
+    return self._batch(self._cdindex.cdindex_batch, self._cdindex.frozen_cdindex_batch,
+                       self._cdindex.compressed_cdindex_batch, names, t_delta, threads)
+
+  def mcdindex_batch(self, names, t_delta, threads=1):
+    """Compute the mCD index for many vertices.
+
+    This function computes the mCD index for each of a list of vertices at a
+    given t_delta in a single call to the C extension.
+
+    Parameters
+    ----------
+    names :
+      The vertex names, or None for every vertex in the graph (in the order
+      returned by vertices).
+    t_delta : int
+      A time delta.
+    threads : int
+      The number of threads to use, or 0 for one per processor.
+
+    Returns
+    -------
+    memoryview
+      A contiguous array of doubles, one per vertex, with nan where the mCD
+      index is undefined.
+    """
+    return self._batch(self._cdindex.mcdindex_batch, self._cdindex.frozen_mcdindex_batch,
+                       self._cdindex.compressed_mcdindex_batch, names, t_delta, threads)
+
+  def iindex_batch(self, names, t_delta, threads=1):
+    """Compute the I index for many vertices.
+
+    This function computes the I index for each of a list of vertices at a
+    given t_delta in a single call to the C extension.
+
+    Parameters
+    ----------
+    names :
+      The vertex names, or None for every vertex in the graph (in the order
+      returned by vertices).
+    t_delta : int
+      A time delta.
+    threads : int
+      The number of threads to use, or 0 for one per processor.
+
+    Returns
+    -------
+    memoryview
+      A contiguous array of 64 bit integers, one per vertex.
+    """
+    return self._batch(self._cdindex.iindex_batch, self._cdindex.frozen_iindex_batch,
+                       self._cdindex.compressed_iindex_batch, names, t_delta, threads)
+
+  def cdindex_multi_batch(self, names, t_deltas, threads=1):
+    """Compute the CD index for many vertices at several time deltas.
+
+    This function computes the CD index for each of a list of vertices at each
+    of several t_deltas. The "it" vertices of each focal vertex are gathered
+    and classified once for the longest t_delta, so asking for k horizons
+    costs about as much as asking for the longest one alone.
+
+    Parameters
+    ----------
+    names :
+      The vertex names, or None for every vertex in the graph (in the order
+      returned by vertices).
+    t_deltas : list of int
+      The time deltas.
+    threads : int
+      The number of threads to use, or 0 for one per processor.
+
+    Returns
+    -------
+    memoryview
+      A contiguous array of doubles with one row per vertex and one column per
+      t_delta, with nan where the CD index is undefined.
+    """
+    return self._multi_batch(names, t_deltas, threads)
+
+  def _multi_batch(self, names, t_deltas, threads, cutoff=None):
+    """Compute the CD index for many vertices at several time deltas, as of a cutoff if one is given."""
+    t_deltas = list(t_deltas)
+    for t_delta in t_deltas:
+      if isinstance(t_delta, (int)) is False:
+        raise ValueError("Time delta (t_delta) must be an integer or long")
+    if names is None:
+      ids = None
+    else:
+      ids = self._vertex_ids(names)
+    if self._frozen_graph is not None:
+      return self._cdindex.frozen_cdindex_multi_batch(self._frozen_graph, ids,
+                                                      t_deltas, threads, cutoff)
+    if self._compressed_graph is not None:
+      return self._cdindex.compressed_cdindex_multi_batch(self._compressed_graph, ids,
+                                                          t_deltas, threads, cutoff)
+    return self._cdindex.cdindex_multi_batch(self._graph, ids, t_deltas, threads, cutoff)
+
+  def cdindex_all(self, t_delta):
+    """Compute the CD index of every vertex in one sweep.
+
+    Rather than computing the CD index of each vertex on its own, this function
+    visits every citing vertex once and adds its contribution to each vertex it
+    counts toward, so the reference list of a citing vertex is read once
+    instead of once per vertex it cites. It gives the same results as
+    cdindex_batch(None, t_delta) with less total work, and is fastest on a
+    graph frozen with by_time=True. It uses one thread; a compressed graph is
+    swept in its uncompressed form.
+
+    Parameters
+    ----------
+    t_delta : int or list of int
+      A time delta, or several.
+
+    Returns
+    -------
+    memoryview
+      A contiguous array of doubles, one per vertex in the order returned by
+      vertices() (one row per vertex and one column per t_delta for a list),
+      with nan where the CD index is undefined.
+    """
+    return self._all(t_delta, False)
+
+  def _all(self, t_delta, counts, cutoff=None):
+    """Run the sweep of cdindex_all or cdindex_all_counts, as of a cutoff if one is given."""
+    if self._frozen_graph is not None:
+      function = self._cdindex.frozen_cdindex_all_counts if counts else self._cdindex.frozen_cdindex_all
+      return function(self._frozen_graph, t_delta, cutoff)
+    function = self._cdindex.cdindex_all_counts if counts else self._cdindex.cdindex_all
+    return function(self._graph, t_delta, cutoff)
+
+  def cdindex_all_counts(self, t_delta):
+    """Compute the components of the CD index of every vertex in one sweep.
+
+    This function runs the sweep of cdindex_all and returns the counts of
+    citing vertices it is computed from. For each vertex, n_f counts the
+    vertices in the window that cite it but none of its references, n_b those
+    citing it and one of its references, and n_r those citing one of its
+    references only. The CD index is (n_f - n_b) / (n_f + n_b + n_r).
+
+    Parameters
+    ----------
+    t_delta : int or list of int
+      A time delta, or several.
+
+    Returns
+    -------
+    tuple of memoryview
+      The n_f, n_b and n_r arrays of 64 bit integers, laid out as the result
+      of cdindex_all.
+    """
+    return self._all(t_delta, True)
+
+  def as_of(self, cutoff):
+    """Return a view of the graph as it stood at a cutoff time.
+
+    The view hides the vertices with timestamps after the cutoff along with
+    their edges, and gives the measures of the graph rebuilt from the
+    vertices up to it, whichever way the edges point in time. Nothing is
+    copied, so views at many cutoffs can be taken of one graph, e.g., to
+    backtest a measure at the end of each year. A view follows the graph:
+    it runs on the frozen or compressed copy if there is one when a measure
+    is taken.
+
+    Parameters
+    ----------
+    cutoff : int
+      The last timestamp of the view.
+
+    Returns
+    -------
+    GraphView
+      The view.
+    """
+    return GraphView(self, cutoff)
+
   def _is_graph_sane(self):
     """Test graph sanity.
 
@@ -395,7 +1029,370 @@ class Graph:
     bool
       True if successful, False otherwise.
     """
-    return _cdindex._is_graph_sane(self._graph)
+    return self._cdindex._is_graph_sane(self._graph)
+
+class GraphView:
+  """A graph as it stood at a cutoff time.
+
+  A view is taken with Graph.as_of or MappedGraph.as_of and has the measure
+  functions of the graph. Vertices with timestamps after the cutoff are
+  hidden with their edges: the single vertex functions raise a ValueError
+  for them, the batch functions and sweeps give nan (0 for the I index) in
+  their place, and they are not references of the visible vertices that
+  cite them. Windows of visible vertices end at the cutoff, so a t_delta
+  reaching past it counts only the citers up to the cutoff.
+  """
+
+  def __init__(self, graph, cutoff):
+    """Initialize a view of a graph as of a cutoff (see Graph.as_of)."""
+    if isinstance(cutoff, (int)) is False:
+      raise ValueError("Cutoff must be an integer or long")
+    self._graph = graph
+    self._cutoff = cutoff
+
+  def cutoff(self):
+    """Return the last timestamp of the view."""
+    return self._cutoff
+
+  def has_vertex(self, name):
+    """Check whether a vertex of the graph is visible in the view."""
+    return self._graph.timestamp(name) <= self._cutoff
+
+  def vertices(self):
+    """Return the vertices of the graph visible in the view."""
+    return [name for name in self._graph.vertices() if self.has_vertex(name)]
+
+  def vcount(self):
+    """Return the number of vertices visible in the view."""
+    return len(self.vertices())
+
+  def _check(self, name):
+    """Check that a vertex is visible before computing a measure."""
+    if not self.has_vertex(name):
+      raise ValueError("Vertex is not in the graph as of the cutoff")
+
+  def cdindex(self, name, t_delta):
+    """Compute the CD index as of the cutoff, as Graph.cdindex."""
+    return self.cdindex_components(name, t_delta)["cdindex"]
+
+  def mcdindex(self, name, t_delta):
+    """Compute the mCD index as of the cutoff, as Graph.mcdindex."""
+    return self.cdindex_components(name, t_delta)["mcdindex"]
+
+  def iindex(self, name, t_delta):
+    """Compute the I index as of the cutoff, as Graph.iindex."""
+    return self.cdindex_components(name, t_delta)["iindex"]
+
+  def cdindex_components(self, name, t_delta):
+    """Compute the components of the CD index as of the cutoff, as Graph.cdindex_components."""
+    self._check(name)
+    return self._graph._components(name, t_delta, self._cutoff)
+
+  def cdindex_estimate(self, name, t_delta, tolerance=0.01, confidence=0.95,
+                       exact_below=10000, seed=1):
+    """Estimate the CD index as of the cutoff from a sample, as Graph.cdindex_estimate."""
+    graph = self._graph
+    if graph._frozen_graph is None:
+      components = self.cdindex_components(name, t_delta)
+      value = components["cdindex"]
+      return {"cdindex": value, "lower": value, "upper": value, "exact": True,
+              "sampled": components["n_f"] + components["n_b"] + components["n_r"]}
+    if isinstance(t_delta, (int)) is False:
+      raise ValueError("Time delta (t_delta) must be an integer or long")
+    self._check(name)
+    result = graph._cdindex.frozen_cdindex_estimate(graph._frozen_graph, graph._vertex_id(name),
+                                                    t_delta, tolerance, confidence,
+                                                    exact_below, seed, self._cutoff)
+    for key in ("cdindex", "lower", "upper"):
+      if math.isnan(result[key]):
+        result[key] = None
+    return result
+
+  def cdindex_batch(self, names, t_delta, threads=1):
+    """Compute the CD index for many vertices as of the cutoff, as Graph.cdindex_batch."""
+    graph = self._graph
+    return graph._batch(graph._cdindex.cdindex_batch, graph._cdindex.frozen_cdindex_batch,
+                        graph._cdindex.compressed_cdindex_batch, names, t_delta, threads,
+                        self._cutoff)
+
+  def mcdindex_batch(self, names, t_delta, threads=1):
+    """Compute the mCD index for many vertices as of the cutoff, as Graph.mcdindex_batch."""
+    graph = self._graph
+    return graph._batch(graph._cdindex.mcdindex_batch, graph._cdindex.frozen_mcdindex_batch,
+                        graph._cdindex.compressed_mcdindex_batch, names, t_delta, threads,
+                        self._cutoff)
+
+  def iindex_batch(self, names, t_delta, threads=1):
+    """Compute the I index for many vertices as of the cutoff, as Graph.iindex_batch."""
+    graph = self._graph
+    return graph._batch(graph._cdindex.iindex_batch, graph._cdindex.frozen_iindex_batch,
+                        graph._cdindex.compressed_iindex_batch, names, t_delta, threads,
+                        self._cutoff)
+
+  def cdindex_multi_batch(self, names, t_deltas, threads=1):
+    """Compute the CD index for many vertices at several time deltas as of the cutoff, as Graph.cdindex_multi_batch."""
+    return self._graph._multi_batch(names, t_deltas, threads, self._cutoff)
+
+  def cdindex_all(self, t_delta):
+    """Compute the CD index of every vertex of the graph as of the cutoff in one sweep, as Graph.cdindex_all."""
+    return self._graph._all(t_delta, False, self._cutoff)
+
+  def cdindex_all_counts(self, t_delta):
+    """Compute the components of the CD index of every vertex as of the cutoff, as Graph.cdindex_all_counts."""
+    return self._graph._all(t_delta, True, self._cutoff)
+
+class MappedGraph:
+  """Load a graph from a binary snapshot file.
+
+  The file written by Graph.save_snapshot is mapped into memory read-only, so
+  loading takes no time regardless of the size of the graph, and processes
+  that map the same file share a single copy of it. The graph cannot be
+  modified, and vertices are identified by their number (their position in
+  vertices() of the graph that was saved).
+  """
+
+  def __init__(self, path, compact=False):
+    """Map a snapshot file.
+
+    Parameters
+    ----------
+    path : str
+      The snapshot file.
+    compact : bool
+      Whether the snapshot was saved from a compact graph. A snapshot only
+      maps with the id and timestamp widths it was saved with.
+    """
+    self._cdindex = _cdindex_compact if compact else _cdindex
+    self._frozen_graph = self._cdindex.map_frozen_graph(path)
+    self._vcount, self._ecount = self._cdindex.get_frozen_counts(self._frozen_graph)
+
+  def vcount(self):
+    """Return the number of vertices in the graph."""
+    return self._vcount
+
+  def arrays(self):
+    """Return the compressed sparse row arrays of the graph, as Graph.arrays.
+
+    The arrays view the mapped file and keep it mapped while they are alive.
+    """
+    return self._cdindex.get_frozen_arrays(self._frozen_graph)
+
+  def ecount(self):
+    """Return the number of edges in the graph."""
+    return self._ecount
+
+  def vertices(self):
+    """Return the vertex numbers of the graph."""
+    return range(self._vcount)
+
+  def timestamp(self, vertex):
+    """Return the timestamp of a vertex."""
+    return self._cdindex.get_frozen_vertex_timestamp(self._frozen_graph, self._vertex_id(vertex))
+
+  def cdindex_all(self, t_delta):
+    """Compute the CD index of every vertex in one sweep, as Graph.cdindex_all."""
+    return self._all(t_delta, False)
+
+  def cdindex_all_counts(self, t_delta):
+    """Compute the components of the CD index of every vertex, as Graph.cdindex_all_counts."""
+    return self._all(t_delta, True)
+
+  def _all(self, t_delta, counts, cutoff=None):
+    """Run the sweep over every vertex, as of a cutoff if one is given."""
+    if counts:
+      return self._cdindex.frozen_cdindex_all_counts(self._frozen_graph, t_delta, cutoff)
+    return self._cdindex.frozen_cdindex_all(self._frozen_graph, t_delta, cutoff)
+
+  def _vertex_id(self, vertex):
+    """Check a vertex number (ValueError if it is not in the graph)."""
+    if isinstance(vertex, (int)) is False or vertex < 0 or vertex >= self._vcount:
+      raise ValueError("One or more vertices are not in the graph")
+    return vertex
+
+  def _check(self, vertex, t_delta):
+    """Check a vertex number and time delta before computing a measure."""
+    if isinstance(t_delta, (int)) is False:
+      raise ValueError("Time delta (t_delta) must be an integer or long")
+    self._vertex_id(vertex)
+
+  def cdindex(self, vertex, t_delta):
+    """Compute the CD index of a vertex (None where it is undefined)."""
+    self._check(vertex, t_delta)
+    result = self._cdindex.frozen_cdindex(self._frozen_graph, vertex, t_delta)
+    return None if math.isnan(result) else result
+
+  def mcdindex(self, vertex, t_delta):
+    """Compute the mCD index of a vertex (None where it is undefined)."""
+    self._check(vertex, t_delta)
+    result = self._cdindex.frozen_mcdindex(self._frozen_graph, vertex, t_delta)
+    return None if math.isnan(result) else result
+
+  def iindex(self, vertex, t_delta):
+    """Compute the I index of a vertex."""
+    self._check(vertex, t_delta)
+    return self._cdindex.frozen_iindex(self._frozen_graph, vertex, t_delta)
+
+  def cdindex_components(self, vertex, t_delta):
+    """Compute the components of the CD index of a vertex, as Graph.cdindex_components."""
+    return self._components(vertex, t_delta)
+
+  def _components(self, vertex, t_delta, cutoff=None):
+    """Compute the components of the CD index, as of a cutoff if one is given."""
+    self._check(vertex, t_delta)
+    result = self._cdindex.frozen_cdindex_components(self._frozen_graph, vertex, t_delta, cutoff)
+    for key in ("cdindex", "mcdindex"):
+      if math.isnan(result[key]):
+        result[key] = None
+    return result
+
+  def cdindex_estimate(self, vertex, t_delta, tolerance=0.01, confidence=0.95,
+                       exact_below=10000, seed=1):
+    """Estimate the CD index of a vertex from a sample, as Graph.cdindex_estimate."""
+    self._check(vertex, t_delta)
+    result = self._cdindex.frozen_cdindex_estimate(self._frozen_graph, vertex, t_delta, tolerance,
+                                                   confidence, exact_below, seed)
+    for key in ("cdindex", "lower", "upper"):
+      if math.isnan(result[key]):
+        result[key] = None
+    return result
+
+  def cdindex_batch(self, vertices, t_delta, threads=1):
+    """Compute the CD index for many vertices (None for every vertex), as Graph.cdindex_batch."""
+    return self._batch(None, self._cdindex.frozen_cdindex_batch, None, vertices, t_delta, threads)
+
+  def mcdindex_batch(self, vertices, t_delta, threads=1):
+    """Compute the mCD index for many vertices (None for every vertex), as Graph.mcdindex_batch."""
+    return self._batch(None, self._cdindex.frozen_mcdindex_batch, None, vertices, t_delta, threads)
+
+  def iindex_batch(self, vertices, t_delta, threads=1):
+    """Compute the I index for many vertices (None for every vertex), as Graph.iindex_batch."""
+    return self._batch(None, self._cdindex.frozen_iindex_batch, None, vertices, t_delta, threads)
+
+  def cdindex_multi_batch(self, vertices, t_deltas, threads=1):
+    """Compute the CD index for many vertices at several time deltas, as Graph.cdindex_multi_batch."""
+    return self._multi_batch(vertices, t_deltas, threads)
+
+  def _batch(self, function, frozen_function, compressed_function, vertices, t_delta, threads,
+             cutoff=None):
+    """Run a frozen batch function, as of a cutoff if one is given (the graph is always frozen)."""
+    return frozen_function(self._frozen_graph, vertices, t_delta, threads, cutoff)
+
+  def _multi_batch(self, vertices, t_deltas, threads, cutoff=None):
+    """Run the multi batch function, as of a cutoff if one is given."""
+    return self._cdindex.frozen_cdindex_multi_batch(self._frozen_graph, vertices,
+                                                    list(t_deltas), threads, cutoff)
+
+  def as_of(self, cutoff):
+    """Return a view of the graph as it stood at a cutoff time, as Graph.as_of.
+
+    Parameters
+    ----------
+    cutoff : int
+      The last timestamp of the view.
+
+    Returns
+    -------
+    GraphView
+      The view, with vertices identified by number as in this graph.
+    """
+    return GraphView(self, cutoff)
+
+class StreamingGraph(Graph):
+  """Create a graph that keeps CD indices up to date as papers are added.
+
+  For each of a fixed set of time deltas, this graph keeps the running
+  numerator and denominator of the CD index of every vertex. Adding a paper
+  with add_paper only updates the vertices it cites and the vertices that cite
+  those, so cdindex at a tracked time delta is answered without computation.
+  Papers must be added with all of their references at once.
+  """
+
+  def __init__(self, t_deltas, vertices=[], edges=[], arena=False, compact=False, names=True):
+    """Initialize a new streaming graph.
+
+    Parameters
+    ----------
+    t_deltas : list of int
+      The time deltas to keep up to date.
+    vertices :
+      List of initial vertices, as for Graph.
+    edges :
+      List of initial edges, as for Graph.
+    arena : bool
+      Whether to use an arena for edges, as for Graph.
+    compact : bool
+      Whether to use 32 bit vertex ids and timestamps, as for Graph.
+    names : bool
+      Whether vertices have names of their own, as for Graph.
+    """
+    self._t_deltas = list(t_deltas)
+    for t_delta in self._t_deltas:
+      if isinstance(t_delta, (int)) is False:
+        raise ValueError("Time delta (t_delta) must be an integer or long")
+    self._stream = None
+    Graph.__init__(self, vertices, edges, arena, compact, names)
+    self._stream = self._cdindex.stream_new(self._graph, self._t_deltas)
+
+  def add_paper(self, name, t, references=[]):
+    """Add a vertex and its out edges, updating the affected CD indices.
+
+    Parameters
+    ----------
+    name :
+      The vertex name.
+    t : int
+      The vertex timestamp.
+    references :
+      The names of the vertices the new vertex cites.
+    """
+    if self._vertex_name_crosswalk is None:
+      if name != self.vcount():
+        raise ValueError("Vertex ids must be added sequentially from 0")
+    elif name in self._vertex_name_crosswalk:
+      raise ValueError("Vertex already added to graph")
+    if isinstance(t, (int)) is False:
+      raise ValueError("Time (t) of vertex must be an integer or long")
+    if not all(self._has_vertex(reference) for reference in references):
+      raise ValueError("One or more vertices are not in the graph")
+    self._frozen_graph = None
+    self._compressed_graph = None
+    vertex_id = self._cdindex.stream_add_vertex(self._stream, t,
+      [self._vertex_id(reference) for reference in references])
+    if self._vertex_name_crosswalk is not None:
+      self._vertex_name_crosswalk[name] = vertex_id
+      self._vertex_id_crosswalk[vertex_id] = name
+
+  def bulk_load(self, vertices=[], edges=[]):
+    """Add many vertices and edges, as Graph.bulk_load, and recompute every CD index."""
+    Graph.bulk_load(self, vertices, edges)
+    if self._stream is not None:
+      self._stream = self._cdindex.stream_new(self._graph, self._t_deltas)
+
+  def bulk_load_arrays(self, timestamps, edges, ids=None):
+    """Add many vertices and edges, as Graph.bulk_load_arrays, and recompute every CD index."""
+    Graph.bulk_load_arrays(self, timestamps, edges, ids)
+    if self._stream is not None:
+      self._stream = self._cdindex.stream_new(self._graph, self._t_deltas)
+
+  def add_vertex(self, name, t):
+    """Not supported: add vertices with add_paper."""
+    raise RuntimeError("Add vertices to a streaming graph with add_paper")
+
+  def add_edge(self, source_name, target_name):
+    """Not supported: add edges with their source in add_paper."""
+    raise RuntimeError("Add edges to a streaming graph with add_paper")
+
+  def cdindex(self, name, t_delta):
+    """Compute the CD index, as Graph.cdindex.
+
+    At a tracked time delta, the result is read from the running totals.
+    """
+    if t_delta in self._t_deltas:
+      result = self._cdindex.stream_cdindex(self._stream,
+                                            self._vertex_id(name),
+                                            self._t_deltas.index(t_delta))
+      return None if math.isnan(result) else result
+    return Graph.cdindex(self, name, t_delta)
 
 class RandomGraph(Graph):
   """Create a random graph.
@@ -442,6 +1439,40 @@ class RandomGraph(Graph):
     # initialize graph
     Graph.__init__(self, vertices, edges)
 
+def stats(compact=False):
+  """Get the counters of the CD index computations since the last reset.
+
+  The counters are only kept when the module is built with CDINDEX_STATS=1
+  in the environment; otherwise "enabled" is False and every count is zero.
+  Every CD index computation of the module is counted, including those made
+  for mCD indices, batches and streams, from any thread.
+
+  Parameters
+  ----------
+  compact : bool
+    Whether to get the counters of the compact (32 bit) module.
+
+  Returns
+  -------
+  dict
+    The number of calls; the totals of vertices whose in edges were scanned,
+    in edges scanned and in the time window, "it" vertices, membership
+    searches and intersections, and seconds; and the 50th, 90th and 99th
+    percentiles of the "it" set size (it_p50, ...) and of the seconds per
+    call (seconds_p50, ...), which are nan before the first call.
+  """
+  return (_cdindex_compact if compact else _cdindex).get_stats()
+
+def reset_stats(compact=False):
+  """Zero the counters of the CD index computations.
+
+  Parameters
+  ----------
+  compact : bool
+    Whether to reset the counters of the compact (32 bit) module.
+  """
+  (_cdindex_compact if compact else _cdindex).reset_stats()
+
 def main():
 
   return None
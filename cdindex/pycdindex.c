@@ -23,18 +23,341 @@
 #define PY3K
 #endif
 
+/* Access state of a Graph, kept as the context of its capsule. It is only
+   touched with the GIL held. Computations count as readers while they run
+   without the GIL, and a bulk load marks the graph as being written while it
+   runs without the GIL, so that mutations never overlap computations. */
+typedef struct GraphAccess {
+  long long int readers;
+  int writing;
+} GraphAccess;
+
 /* Destructor function for Graph */
 static void del_Graph(PyObject *obj) {
   free_graph(PyCapsule_GetPointer(obj,"Graph"));
   free(PyCapsule_GetPointer(obj,"Graph"));
+  free(PyCapsule_GetContext(obj));
 }
 
 /* Graph utility functions */
 static Graph *PyGraph_AsGraph(PyObject *obj) {
-  return (Graph *) PyCapsule_GetPointer(obj, "Graph");
+  Graph *g = (Graph *) PyCapsule_GetPointer(obj, "Graph");
+  GraphAccess *access;
+  if (g && (access = PyCapsule_GetContext(obj)) && access->writing) {
+    PyErr_SetString(PyExc_RuntimeError, "The graph is being modified by another thread");
+    return NULL;
+  }
+  return g;
+}
+static Graph *PyGraph_AsWritableGraph(PyObject *obj) {
+  Graph *g = PyGraph_AsGraph(obj);
+  GraphAccess *access;
+  if (g && (access = PyCapsule_GetContext(obj)) && access->readers > 0) {
+    PyErr_SetString(PyExc_RuntimeError, "The graph cannot be modified while computations are running on it");
+    return NULL;
+  }
+  return g;
+}
+static void PyGraph_BeginRead(PyObject *obj) {
+  GraphAccess *access = PyCapsule_GetContext(obj);
+  if (access) access->readers++;
+}
+static void PyGraph_EndRead(PyObject *obj) {
+  GraphAccess *access = PyCapsule_GetContext(obj);
+  if (access) access->readers--;
 }
 static PyObject *PyGraph_FromGraph(Graph *g, int must_free) {
-  return PyCapsule_New(g, "Graph", must_free ? del_Graph : NULL);
+  PyObject *capsule = PyCapsule_New(g, "Graph", must_free ? del_Graph : NULL);
+  GraphAccess *access = calloc(1, sizeof(GraphAccess));
+  if (capsule && !access) {
+    Py_DECREF(capsule);
+    return PyErr_NoMemory();
+  }
+  if (capsule)
+    PyCapsule_SetContext(capsule, access);
+  else
+    free(access);
+  return capsule;
+}
+
+/* Destructor function for FrozenGraph */
+static void del_FrozenGraph(PyObject *obj) {
+  free_frozen_graph(PyCapsule_GetPointer(obj,"FrozenGraph"));
+  free(PyCapsule_GetPointer(obj,"FrozenGraph"));
+}
+
+/* FrozenGraph utility functions */
+static FrozenGraph *PyFrozenGraph_AsFrozenGraph(PyObject *obj) {
+  return (FrozenGraph *) PyCapsule_GetPointer(obj, "FrozenGraph");
+}
+static PyObject *PyFrozenGraph_FromFrozenGraph(FrozenGraph *fg, int must_free) {
+  return PyCapsule_New(fg, "FrozenGraph", must_free ? del_FrozenGraph : NULL);
+}
+
+/* Destructor function for CompressedGraph */
+static void del_CompressedGraph(PyObject *obj) {
+  free_compressed_graph(PyCapsule_GetPointer(obj,"CompressedGraph"));
+  free(PyCapsule_GetPointer(obj,"CompressedGraph"));
+}
+
+/* CompressedGraph utility functions */
+static CompressedGraph *PyCompressedGraph_AsCompressedGraph(PyObject *obj) {
+  return (CompressedGraph *) PyCapsule_GetPointer(obj, "CompressedGraph");
+}
+static PyObject *PyCompressedGraph_FromCompressedGraph(CompressedGraph *cg, int must_free) {
+  return PyCapsule_New(cg, "CompressedGraph", must_free ? del_CompressedGraph : NULL);
+}
+
+/* Destructor function for Stream, which holds a reference to its graph */
+static void del_Stream(PyObject *obj) {
+  free_stream(PyCapsule_GetPointer(obj,"Stream"));
+  free(PyCapsule_GetPointer(obj,"Stream"));
+  Py_XDECREF((PyObject *) PyCapsule_GetContext(obj));
+}
+
+/* Batch measures */
+enum { BATCH_CDINDEX, BATCH_MCDINDEX, BATCH_IINDEX };
+
+/* Kinds of graph the batch functions run on */
+enum { BATCH_GRAPH, BATCH_FROZEN, BATCH_COMPRESSED };
+
+/* Set up a view of a graph as of an optional cutoff (None for the whole
+   graph). Returns 1 if the view is set, 0 if there is no cutoff and -1 with
+   an exception set if the cutoff is not an integer. */
+static int PyCutoff_AsView(PyObject *py_cutoff, Graph *g, FrozenGraph *fg, CompressedGraph *cg,
+                           GraphView *view) {
+  if (py_cutoff == NULL || py_cutoff == Py_None)
+    return 0;
+  view->graph = g;
+  view->frozen = fg;
+  view->compressed = cg;
+  view->cutoff = PyLong_AsLongLong(py_cutoff);
+  if (view->cutoff == -1 && PyErr_Occurred())
+    return -1;
+  return 1;
+}
+
+/* Get a buffer of 32 or 64 bit signed integers as an array of n long longs.
+   A contiguous 64 bit buffer is used in place; any other is converted into a
+   new array set in *copy (free with free). Release the view with
+   PyBuffer_Release once the array is no longer needed. */
+static long long int *PyIntBuffer_AsArray(PyObject *obj, const char *name, Py_buffer *view,
+                                          Py_ssize_t *n, long long int **copy) {
+  const char *format;
+  char code;
+
+  *copy = NULL;
+  if (PyObject_GetBuffer(obj, view, PyBUF_RECORDS_RO) < 0)
+    return NULL;
+  format = view->format ? view->format : "B";
+  if (*format == '@' || *format == '=' || *format == '<')
+    format++;
+  code = format[0];
+  if (format[1] != '\0' || (code != 'i' && code != 'l' && code != 'q') ||
+      (view->itemsize != 4 && view->itemsize != 8)) {
+    PyErr_Format(PyExc_TypeError, "%s must be an array of 32 or 64 bit signed integers", name);
+    PyBuffer_Release(view);
+    return NULL;
+  }
+  *n = view->itemsize > 0 ? view->len / view->itemsize : 0;
+  if (view->itemsize == 8 && PyBuffer_IsContiguous(view, 'C'))
+    return (long long int *) view->buf;
+
+  // gather the values in order, widening 32 bit ones
+  if (!(*copy = malloc((*n > 0 ? *n : 1) * sizeof(long long int)))) {
+    PyBuffer_Release(view);
+    PyErr_NoMemory();
+    return NULL;
+  }
+  if (view->itemsize == 8) {
+    if (PyBuffer_ToContiguous(*copy, view, view->len, 'C') < 0) {
+      free(*copy);
+      *copy = NULL;
+      PyBuffer_Release(view);
+      return NULL;
+    }
+  }
+  else {
+    int *values = PyBuffer_IsContiguous(view, 'C') ? view->buf : malloc((*n > 0 ? *n : 1) * sizeof(int));
+    if (!values || (values != view->buf && PyBuffer_ToContiguous(values, view, view->len, 'C') < 0)) {
+      if (!values)
+        PyErr_NoMemory();
+      free(*copy);
+      *copy = NULL;
+      PyBuffer_Release(view);
+      return NULL;
+    }
+    for (Py_ssize_t i = 0; i < *n; i++)
+      (*copy)[i] = values[i];
+    if (values != view->buf)
+      free(values);
+  }
+  return *copy;
+}
+
+/* Copy a sequence of vertex ids into a new array, checking they are in the graph */
+static long long int *PyIds_AsArray(PyObject *obj, long long int vcount, Py_ssize_t *n) {
+  PyObject *seq;
+  long long int *ids;
+
+  // arrays of integers are read without going through python objects
+  if (PyObject_CheckBuffer(obj)) {
+    Py_buffer view;
+    long long int *values, *copy;
+    if (!(values = PyIntBuffer_AsArray(obj, "ids", &view, n, &copy)))
+      return NULL;
+    if (!copy && !(ids = malloc((*n > 0 ? *n : 1) * sizeof(long long int)))) {
+      PyBuffer_Release(&view);
+      PyErr_NoMemory();
+      return NULL;
+    }
+    if (!copy)
+      memcpy(ids, values, *n * sizeof(long long int));
+    else
+      ids = copy;
+    PyBuffer_Release(&view);
+    for (Py_ssize_t i = 0; i < *n; i++) {
+      if (ids[i] < 0 || ids[i] >= vcount) {
+        PyErr_SetString(PyExc_ValueError, error_message(2));
+        free(ids);
+        return NULL;
+      }
+    }
+    return ids;
+  }
+
+  seq = PySequence_Fast(obj, "ids must be a sequence");
+  if (!seq)
+    return NULL;
+  *n = PySequence_Fast_GET_SIZE(seq);
+  ids = malloc((*n > 0 ? *n : 1) * sizeof(long long int));
+  if (!ids) {
+    Py_DECREF(seq);
+    PyErr_NoMemory();
+    return NULL;
+  }
+  for (Py_ssize_t i = 0; i < *n; i++) {
+    ids[i] = PyLong_AsLongLong(PySequence_Fast_GET_ITEM(seq, i));
+    if (ids[i] == -1 && PyErr_Occurred())
+      break;
+    if (ids[i] < 0 || ids[i] >= vcount) {
+      PyErr_SetString(PyExc_ValueError, error_message(2));
+      break;
+    }
+  }
+  Py_DECREF(seq);
+  if (PyErr_Occurred()) {
+    free(ids);
+    return NULL;
+  }
+  return ids;
+}
+
+/* Create a contiguous array of n 8 byte values ("d" for double, "q" for long long) */
+static PyObject *PyResultArray_New(Py_ssize_t n, const char *format, void **data) {
+  PyObject *bytes, *view, *result;
+
+  if (!(bytes = PyByteArray_FromStringAndSize(NULL, n * 8)))
+    return NULL;
+  *data = PyByteArray_AS_STRING(bytes);
+  view = PyMemoryView_FromObject(bytes);
+  Py_DECREF(bytes);
+  if (!view)
+    return NULL;
+  result = PyObject_CallMethod(view, "cast", "s", format);
+  Py_DECREF(view);
+  return result;
+}
+
+/* Shape a result array of n * k values into n rows of k, taking its reference
+   (memoryview cannot shape empty views, which are returned flat) */
+static PyObject *PyResultArray_Shape(PyObject *result, Py_ssize_t n, Py_ssize_t k, const char *format) {
+  PyObject *shaped;
+
+  if (!result || n == 0 || k == 0)
+    return result;
+  shaped = PyObject_CallMethod(result, "cast", "s", "B");
+  Py_DECREF(result);
+  if (!shaped)
+    return NULL;
+  result = PyObject_CallMethod(shaped, "cast", "s(nn)", format, n, k);
+  Py_DECREF(shaped);
+  return result;
+}
+
+/* A read-only one dimensional array in memory owned by another object, such as
+   the arrays of a frozen graph capsule. It exports the memory through the
+   buffer protocol and keeps its owner alive, so memoryviews and NumPy arrays
+   built on it view the C arrays without copying them. */
+typedef struct {
+  PyObject_HEAD
+  PyObject *owner;
+  void *data;
+  Py_ssize_t length;
+  Py_ssize_t itemsize;
+  char format[2];
+} CArrayObject;
+
+static void CArray_dealloc(PyObject *obj) {
+  Py_XDECREF(((CArrayObject *) obj)->owner);
+  PyObject_Del(obj);
+}
+
+static int CArray_GetBuffer(PyObject *obj, Py_buffer *view, int flags) {
+  CArrayObject *array = (CArrayObject *) obj;
+
+  if (flags & PyBUF_WRITABLE) {
+    PyErr_SetString(PyExc_BufferError, "The array is read-only");
+    view->obj = NULL;
+    return -1;
+  }
+  // empty arrays may have no memory, but a buffer needs an address
+  view->buf = array->data ? array->data : (void *) &array->length;
+  view->obj = obj;
+  Py_INCREF(obj);
+  view->len = array->length * array->itemsize;
+  view->readonly = 1;
+  view->itemsize = array->itemsize;
+  view->format = flags & PyBUF_FORMAT ? array->format : NULL;
+  view->ndim = 1;
+  view->shape = flags & PyBUF_ND ? &array->length : NULL;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &array->itemsize : NULL;
+  view->suboffsets = NULL;
+  view->internal = NULL;
+  return 0;
+}
+
+static PyBufferProcs CArray_as_buffer = {
+  .bf_getbuffer = CArray_GetBuffer,
+};
+
+static PyTypeObject CArrayType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+  .tp_name = "cdindex.CArray",
+  .tp_basicsize = sizeof(CArrayObject),
+  .tp_dealloc = CArray_dealloc,
+  .tp_as_buffer = &CArray_as_buffer,
+  .tp_flags = Py_TPFLAGS_DEFAULT,
+  .tp_doc = "A read-only view of an array of the cdindex library",
+};
+
+/* View n values of an array owned by owner as a memoryview ("q", "i" or "I") */
+static PyObject *PyCArray_View(PyObject *owner, void *data, Py_ssize_t n, Py_ssize_t itemsize, char format) {
+  CArrayObject *array;
+  PyObject *view;
+
+  if (!(array = PyObject_New(CArrayObject, &CArrayType)))
+    return NULL;
+  Py_INCREF(owner);
+  array->owner = owner;
+  array->data = data;
+  array->length = n;
+  array->itemsize = itemsize;
+  array->format[0] = format;
+  array->format[1] = '\0';
+  view = PyMemoryView_FromObject((PyObject *) array);
+  Py_DECREF(array);
+  return view;
 }
 
 /*******************************************************************************
@@ -42,11 +365,23 @@ static PyObject *PyGraph_FromGraph(Graph *g, int must_free) {
  ******************************************************************************/
 static PyObject *py_Graph(PyObject *self, PyObject *args) {
   Graph *g;
+  int use_arena = 0;
+
+  if (!PyArg_ParseTuple(args,"|p",&use_arena))
+    return NULL;
 
   // create a graph
   g = (Graph *) malloc(sizeof(Graph));
+  if (g == NULL)
+    return PyErr_NoMemory();
   g->vcount = 0;
   g->ecount = 0;
+  g->out_edges_sorted = true;
+  g->vcapacity = 0;
+  g->degree_hint = 0;
+  g->arena = NULL;
+  if (use_arena)
+    graph_use_arena(g);
 
   return PyGraph_FromGraph(g, 1);
 }
@@ -77,8 +412,12 @@ static PyObject *py_add_vertex(PyObject *self, PyObject *args) {
 
   if (!PyArg_ParseTuple(args,"OLL",&py_g, &ID, &TIMESTAMP))
     return NULL;
-  if (!(g = PyGraph_AsGraph(py_g)))
+  if (!(g = PyGraph_AsWritableGraph(py_g)))
+    return NULL;
+  if (!vertex_fits(ID, TIMESTAMP)) {
+    PyErr_SetString(PyExc_ValueError, error_message(7));
     return NULL;
+  }
 
   add_vertex(g, ID, TIMESTAMP);
 
@@ -90,15 +429,231 @@ static PyObject *py_add_vertex(PyObject *self, PyObject *args) {
  ******************************************************************************/
 static PyObject *py_add_edge(PyObject *self, PyObject *args) {
   long long int SOURCE_ID, TARGET_ID;
+  int error;
   Graph *g;
   PyObject *py_g;
 
   if (!PyArg_ParseTuple(args,"OLL",&py_g, &SOURCE_ID, &TARGET_ID))
     return NULL;
+  if (!(g = PyGraph_AsWritableGraph(py_g)))
+    return NULL;
+
+  // the endpoints and duplicates are checked once, in the library
+  if (!try_add_edge(g, SOURCE_ID, TARGET_ID, &error)) {
+    PyErr_SetString(PyExc_ValueError, error_message(error));
+    return NULL;
+  }
+
+  return Py_BuildValue("");
+}
+
+/*******************************************************************************
+ * Add many vertices and edges to the graph at once                            *
+ ******************************************************************************/
+static PyObject *py_bulk_load_graph(PyObject *self, PyObject *args) {
+  Graph *g;
+  PyObject *py_g, *py_ids, *py_timestamps, *py_edges;
+  PyObject *ids_seq = NULL, *timestamps_seq = NULL, *edges_seq = NULL;
+  long long int *ids = NULL, *timestamps = NULL;
+  Edge *edges = NULL;
+  Py_ssize_t vcount, ecount, i;
+  int error;
+  bool loaded;
+  GraphAccess *access;
+  PyObject *result = NULL;
+
+  if (!PyArg_ParseTuple(args,"OOOO",&py_g, &py_ids, &py_timestamps, &py_edges))
+    return NULL;
+  if (!(g = PyGraph_AsWritableGraph(py_g)))
+    return NULL;
+
+  ids_seq = PySequence_Fast(py_ids, "ids must be a sequence");
+  timestamps_seq = PySequence_Fast(py_timestamps, "timestamps must be a sequence");
+  edges_seq = PySequence_Fast(py_edges, "edges must be a sequence");
+  if (!ids_seq || !timestamps_seq || !edges_seq)
+    goto done;
+
+  vcount = PySequence_Fast_GET_SIZE(ids_seq);
+  ecount = PySequence_Fast_GET_SIZE(edges_seq);
+  if (PySequence_Fast_GET_SIZE(timestamps_seq) != vcount) {
+    PyErr_SetString(PyExc_ValueError, "ids and timestamps must have the same length");
+    goto done;
+  }
+
+  // copy the python sequences into c arrays
+  ids = malloc((vcount > 0 ? vcount : 1) * sizeof(long long int));
+  timestamps = malloc((vcount > 0 ? vcount : 1) * sizeof(long long int));
+  edges = malloc((ecount > 0 ? ecount : 1) * sizeof(Edge));
+  if (!ids || !timestamps || !edges) {
+    PyErr_NoMemory();
+    goto done;
+  }
+  for (i = 0; i < vcount; i++) {
+    ids[i] = PyLong_AsLongLong(PySequence_Fast_GET_ITEM(ids_seq, i));
+    timestamps[i] = PyLong_AsLongLong(PySequence_Fast_GET_ITEM(timestamps_seq, i));
+  }
+  for (i = 0; i < ecount; i++) {
+    if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(edges_seq, i), "LL",
+                          &edges[i].source_id, &edges[i].target_id))
+      goto done;
+  }
+  if (PyErr_Occurred())
+    goto done;
+
+  // the graph is marked as being written while the GIL is released
+  access = PyCapsule_GetContext(py_g);
+  if (access) access->writing = 1;
+  Py_BEGIN_ALLOW_THREADS
+  loaded = bulk_load_graph(g, vcount, ids, timestamps, ecount, edges, &error);
+  Py_END_ALLOW_THREADS
+  if (access) access->writing = 0;
+  if (!loaded) {
+    PyErr_SetString(PyExc_ValueError, error_message(error));
+    goto done;
+  }
+
+  result = Py_BuildValue("");
+
+done:
+  Py_XDECREF(ids_seq);
+  Py_XDECREF(timestamps_seq);
+  Py_XDECREF(edges_seq);
+  free(ids);
+  free(timestamps);
+  free(edges);
+  return result;
+}
+
+/*******************************************************************************
+ * Add many vertices and edges to the graph from arrays of integers            *
+ ******************************************************************************/
+static PyObject *py_bulk_load_arrays(PyObject *self, PyObject *args) {
+  Graph *g;
+  PyObject *py_g, *py_ids, *py_timestamps, *py_edges;
+  Py_buffer ids_view, timestamps_view, edges_view;
+  long long int *ids = NULL, *timestamps = NULL, *edge_ids = NULL;
+  long long int *ids_copy = NULL, *timestamps_copy = NULL, *edges_copy = NULL;
+  Py_ssize_t vcount = 0, tcount, ecount;
+  int error, has_ids = 0, has_timestamps = 0, has_edges = 0;
+  bool loaded;
+  GraphAccess *access;
+  PyObject *result = NULL;
+
+  if (!PyArg_ParseTuple(args,"OOOO",&py_g, &py_ids, &py_timestamps, &py_edges))
+    return NULL;
+  if (!(g = PyGraph_AsWritableGraph(py_g)))
+    return NULL;
+
+  // 64 bit contiguous arrays are used in place, others are converted
+  if (!(timestamps = PyIntBuffer_AsArray(py_timestamps, "timestamps", &timestamps_view,
+                                         &tcount, &timestamps_copy)))
+    goto done;
+  has_timestamps = 1;
+  if (!(edge_ids = PyIntBuffer_AsArray(py_edges, "edges", &edges_view, &ecount, &edges_copy)))
+    goto done;
+  has_edges = 1;
+  if (ecount % 2 != 0) {
+    PyErr_SetString(PyExc_ValueError, "edges must hold a source and a target for each edge");
+    goto done;
+  }
+
+  // None stands for the next ids of the graph, in order
+  if (py_ids == Py_None) {
+    vcount = tcount;
+    if (!(ids = ids_copy = malloc((vcount > 0 ? vcount : 1) * sizeof(long long int)))) {
+      PyErr_NoMemory();
+      goto done;
+    }
+    for (Py_ssize_t i = 0; i < vcount; i++)
+      ids[i] = g->vcount + i;
+  }
+  else {
+    if (!(ids = PyIntBuffer_AsArray(py_ids, "ids", &ids_view, &vcount, &ids_copy)))
+      goto done;
+    has_ids = 1;
+  }
+  if (tcount != vcount) {
+    PyErr_SetString(PyExc_ValueError, "ids and timestamps must have the same length");
+    goto done;
+  }
+
+  // the graph is marked as being written while the GIL is released
+  access = PyCapsule_GetContext(py_g);
+  if (access) access->writing = 1;
+  Py_BEGIN_ALLOW_THREADS
+  loaded = bulk_load_graph(g, vcount, ids, timestamps, ecount / 2, (Edge *) edge_ids, &error);
+  Py_END_ALLOW_THREADS
+  if (access) access->writing = 0;
+  if (!loaded) {
+    PyErr_SetString(PyExc_ValueError, error_message(error));
+    goto done;
+  }
+
+  result = Py_BuildValue("");
+
+done:
+  if (has_ids) PyBuffer_Release(&ids_view);
+  if (has_timestamps) PyBuffer_Release(&timestamps_view);
+  if (has_edges) PyBuffer_Release(&edges_view);
+  free(ids_copy);
+  free(timestamps_copy);
+  free(edges_copy);
+  return result;
+}
+
+/*******************************************************************************
+ * Reserve memory ahead of adding vertices and edges                           *
+ ******************************************************************************/
+static PyObject *py_graph_reserve(PyObject *self, PyObject *args) {
+  long long int VCOUNT, ECOUNT;
+  Graph *g;
+  PyObject *py_g;
+
+  if (!PyArg_ParseTuple(args,"OLL",&py_g, &VCOUNT, &ECOUNT))
+    return NULL;
+  if (!(g = PyGraph_AsWritableGraph(py_g)))
+    return NULL;
+  if (VCOUNT < 0 || ECOUNT < 0) {
+    PyErr_SetString(PyExc_ValueError, "The expected vertex and edge counts must not be negative");
+    return NULL;
+  }
+  if (!graph_reserve(g, VCOUNT, ECOUNT))
+    return PyErr_NoMemory();
+
+  return Py_BuildValue("");
+}
+
+/*******************************************************************************
+ * Get the memory taken by a graph                                             *
+ ******************************************************************************/
+static PyObject *py_get_memory_usage(PyObject *self, PyObject *args) {
+  long long int used, reserved;
+  Graph *g;
+  PyObject *py_g;
+
+  if (!PyArg_ParseTuple(args,"O",&py_g))
+    return NULL;
   if (!(g = PyGraph_AsGraph(py_g)))
     return NULL;
 
-  add_edge(g, SOURCE_ID, TARGET_ID);
+  graph_memory_usage(g, &used, &reserved);
+
+  return Py_BuildValue("LL", used, reserved);
+}
+
+/*******************************************************************************
+ * Sort the out edges of every vertex in the graph                             *
+ ******************************************************************************/
+static PyObject *py_sort_adjacency(PyObject *self, PyObject *args) {
+  Graph *g;
+  PyObject *py_g;
+
+  if (!PyArg_ParseTuple(args,"O",&py_g))
+    return NULL;
+  if (!(g = PyGraph_AsWritableGraph(py_g)))
+    return NULL;
+
+  sort_adjacency(g);
 
   return Py_BuildValue("");
 }
@@ -135,7 +690,7 @@ static PyObject *py_get_vertices(PyObject *self, PyObject *args) {
   PyObject *vs_list = PyList_New(g->vcount);
 
   for (long long int i = 0; i < g->vcount; i++) {
-    id = Py_BuildValue("L", g->vs[i].id);
+    id = Py_BuildValue("L", (long long int) g->vs[i].id);
     PyList_SetItem(vs_list, i, id);
   }
 
@@ -177,7 +732,7 @@ static PyObject *py_get_vertex_timestamp(PyObject *self, PyObject *args) {
   if (!(g = PyGraph_AsGraph(py_g)))
     return NULL;
 
-  return Py_BuildValue("L", g->vs[ID].timestamp);
+  return Py_BuildValue("L", (long long int) g->vs[ID].timestamp);
 }
 
 /*******************************************************************************
@@ -214,7 +769,7 @@ static PyObject *py_get_vertex_in_edges(PyObject *self, PyObject *args) {
   PyObject *vs_list = PyList_New(g->vs[ID].in_degree);
 
   for (long long int i = 0; i < g->vs[ID].in_degree; i++) {
-    source_id = Py_BuildValue("L", g->vs[ID].in_edges[i]);
+    source_id = Py_BuildValue("L", (long long int) g->vs[ID].in_edges[i]);
     PyList_SetItem(vs_list, i, source_id);
   }
 
@@ -260,7 +815,7 @@ static PyObject *py_get_vertex_out_edges(PyObject *self, PyObject *args) {
   PyObject *vs_list = PyList_New(g->vs[ID].out_degree);
 
   for (long long int i = 0; i < g->vs[ID].out_degree; i++) {
-    target_id = Py_BuildValue("L", g->vs[ID].out_edges[i]);
+    target_id = Py_BuildValue("L", (long long int) g->vs[ID].out_edges[i]);
     PyList_SetItem(vs_list, i, target_id);
   }
 
@@ -288,7 +843,11 @@ static PyObject *py_cdindex(PyObject *self, PyObject *args) {
   if (!(g = PyGraph_AsGraph(py_g)))
     return NULL;
 
+  PyGraph_BeginRead(py_g);
+  Py_BEGIN_ALLOW_THREADS
   result = cdindex(g, ID, TIMESTAMP);
+  Py_END_ALLOW_THREADS
+  PyGraph_EndRead(py_g);
   
   return Py_BuildValue("d", result);
 }
@@ -308,7 +867,11 @@ static PyObject *py_mcdindex(PyObject *self, PyObject *args) {
   if (!(g = PyGraph_AsGraph(py_g)))
     return NULL;
 
+  PyGraph_BeginRead(py_g);
+  Py_BEGIN_ALLOW_THREADS
   result = mcdindex(g, ID, TIMESTAMP);
+  Py_END_ALLOW_THREADS
+  PyGraph_EndRead(py_g);
   
   return Py_BuildValue("d", result);
 }
@@ -328,11 +891,962 @@ static PyObject *py_iindex(PyObject *self, PyObject *args) {
   if (!(g = PyGraph_AsGraph(py_g)))
     return NULL;
 
+  PyGraph_BeginRead(py_g);
+  Py_BEGIN_ALLOW_THREADS
   result = iindex(g, ID, TIMESTAMP);
+  Py_END_ALLOW_THREADS
+  PyGraph_EndRead(py_g);
   
   return Py_BuildValue("d", result);
 }
 
+/*******************************************************************************
+ * Freeze the graph into a compressed sparse row structure                     *
+ ******************************************************************************/
+static PyObject *py_freeze_graph(PyObject *self, PyObject *args) {
+  Graph *g;
+  FrozenGraph *fg;
+  PyObject *py_g;
+  int by_time = 0;
+  int ordering = ORDER_IDS;
+
+  if (!PyArg_ParseTuple(args,"O|pi",&py_g, &by_time, &ordering))
+    return NULL;
+  if (!(g = PyGraph_AsGraph(py_g)))
+    return NULL;
+  if (ordering < ORDER_IDS || ordering > ORDER_RCM) {
+    PyErr_SetString(PyExc_ValueError, "Unknown vertex ordering");
+    return NULL;
+  }
+
+  // create a frozen graph
+  fg = (FrozenGraph *) malloc(sizeof(FrozenGraph));
+  if (fg == NULL)
+    return PyErr_NoMemory();
+  PyGraph_BeginRead(py_g);
+  Py_BEGIN_ALLOW_THREADS
+  freeze_graph_ordered(g, fg, by_time, ordering);
+  Py_END_ALLOW_THREADS
+  PyGraph_EndRead(py_g);
+
+  return PyFrozenGraph_FromFrozenGraph(fg, 1);
+}
+
+/*******************************************************************************
+ * Write a frozen graph to a snapshot file                                     *
+ ******************************************************************************/
+static PyObject *py_save_frozen_graph(PyObject *self, PyObject *args) {
+  FrozenGraph *fg;
+  PyObject *py_fg, *py_path;
+  int error;
+  bool saved;
+
+  if (!PyArg_ParseTuple(args,"OO&",&py_fg, PyUnicode_FSConverter, &py_path))
+    return NULL;
+  if (!(fg = PyFrozenGraph_AsFrozenGraph(py_fg))) {
+    Py_DECREF(py_path);
+    return NULL;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+  saved = save_frozen_graph(fg, PyBytes_AS_STRING(py_path), &error);
+  Py_END_ALLOW_THREADS
+
+  if (!saved) {
+    PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, py_path);
+    Py_DECREF(py_path);
+    return NULL;
+  }
+  Py_DECREF(py_path);
+  return Py_BuildValue("");
+}
+
+/*******************************************************************************
+ * Map a snapshot file into memory as a frozen graph                           *
+ ******************************************************************************/
+static PyObject *py_map_frozen_graph(PyObject *self, PyObject *args) {
+  FrozenGraph *fg;
+  PyObject *py_path;
+  int error;
+  bool mapped;
+
+  if (!PyArg_ParseTuple(args,"O&",PyUnicode_FSConverter, &py_path))
+    return NULL;
+
+  fg = (FrozenGraph *) malloc(sizeof(FrozenGraph));
+  if (fg == NULL) {
+    Py_DECREF(py_path);
+    return PyErr_NoMemory();
+  }
+  Py_BEGIN_ALLOW_THREADS
+  mapped = map_frozen_graph(fg, PyBytes_AS_STRING(py_path), &error);
+  Py_END_ALLOW_THREADS
+
+  if (!mapped) {
+    if (error == 4)
+      PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, py_path);
+    else
+      PyErr_SetString(PyExc_ValueError, error_message(error));
+    free(fg);
+    Py_DECREF(py_path);
+    return NULL;
+  }
+  Py_DECREF(py_path);
+  return PyFrozenGraph_FromFrozenGraph(fg, 1);
+}
+
+/*******************************************************************************
+ * Get the number of vertices and edges of a frozen graph                      *
+ ******************************************************************************/
+static PyObject *py_get_frozen_counts(PyObject *self, PyObject *args) {
+  FrozenGraph *fg;
+  PyObject *py_fg;
+
+  if (!PyArg_ParseTuple(args,"O",&py_fg))
+    return NULL;
+  if (!(fg = PyFrozenGraph_AsFrozenGraph(py_fg)))
+    return NULL;
+
+  return Py_BuildValue("LL", fg->vcount, fg->ecount);
+}
+
+/*******************************************************************************
+ * Get a vertex timestamp on a frozen graph                                    *
+ ******************************************************************************/
+static PyObject *py_get_frozen_vertex_timestamp(PyObject *self, PyObject *args) {
+  long long int ID;
+  FrozenGraph *fg;
+  GraphView view = {NULL, NULL, NULL, 0};
+  PyObject *py_fg;
+
+  if (!PyArg_ParseTuple(args,"OL",&py_fg, &ID))
+    return NULL;
+  if (!(fg = PyFrozenGraph_AsFrozenGraph(py_fg)))
+    return NULL;
+
+  view.frozen = fg;
+  return Py_BuildValue("L", view_timestamp(&view, ID));
+}
+
+/*******************************************************************************
+ * View the arrays of a frozen graph without copying them                      *
+ ******************************************************************************/
+static PyObject *py_get_frozen_arrays(PyObject *self, PyObject *args) {
+  FrozenGraph *fg;
+  PyObject *py_fg, *arrays, *view;
+  char id_format = sizeof(VertexId) == 8 ? 'q' : 'I';
+  char timestamp_format = sizeof(Timestamp) == 8 ? 'q' : 'i';
+
+  if (!PyArg_ParseTuple(args,"O",&py_fg))
+    return NULL;
+  if (!(fg = PyFrozenGraph_AsFrozenGraph(py_fg)))
+    return NULL;
+  if (!(arrays = PyDict_New()))
+    return NULL;
+
+#define ADD_ARRAY(name, data, n, type, format)                                  \
+  view = PyCArray_View(py_fg, data, n, sizeof(type), format);                   \
+  if (!view || PyDict_SetItemString(arrays, name, view) < 0) {                  \
+    Py_XDECREF(view);                                                           \
+    Py_DECREF(arrays);                                                          \
+    return NULL;                                                                \
+  }                                                                             \
+  Py_DECREF(view);
+
+  ADD_ARRAY("timestamps", fg->timestamps, fg->vcount, Timestamp, timestamp_format);
+  ADD_ARRAY("in_offsets", fg->in_offsets, fg->vcount + 1, long long int, 'q');
+  ADD_ARRAY("in_edges", fg->in_edges, fg->ecount, VertexId, id_format);
+  ADD_ARRAY("out_offsets", fg->out_offsets, fg->vcount + 1, long long int, 'q');
+  ADD_ARRAY("out_edges", fg->out_edges, fg->ecount, VertexId, id_format);
+  if (fg->in_times) {
+    ADD_ARRAY("in_times", fg->in_times, fg->ecount, Timestamp, timestamp_format);
+  }
+  if (fg->public_ids) {
+    ADD_ARRAY("public_ids", fg->public_ids, fg->vcount, VertexId, id_format);
+    ADD_ARRAY("internal_ids", fg->internal_ids, fg->vcount, VertexId, id_format);
+  }
+#undef ADD_ARRAY
+
+  return arrays;
+}
+
+/*******************************************************************************
+ * Compute the CD index on a frozen graph                                      *
+ ******************************************************************************/
+static PyObject *py_frozen_cdindex(PyObject *self, PyObject *args) {
+  long long int ID;
+  long long int TIMESTAMP;
+  double result;
+  FrozenGraph *fg;
+  PyObject *py_fg;
+
+  if (!PyArg_ParseTuple(args,"OLL",&py_fg, &ID, &TIMESTAMP))
+    return NULL;
+  if (!(fg = PyFrozenGraph_AsFrozenGraph(py_fg)))
+    return NULL;
+
+  Py_BEGIN_ALLOW_THREADS
+  result = frozen_cdindex(fg, ID, TIMESTAMP);
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("d", result);
+}
+
+/*******************************************************************************
+ * Compute the mCD index on a frozen graph                                     *
+ ******************************************************************************/
+static PyObject *py_frozen_mcdindex(PyObject *self, PyObject *args) {
+  long long int ID;
+  long long int TIMESTAMP;
+  double result;
+  FrozenGraph *fg;
+  PyObject *py_fg;
+
+  if (!PyArg_ParseTuple(args,"OLL",&py_fg, &ID, &TIMESTAMP))
+    return NULL;
+  if (!(fg = PyFrozenGraph_AsFrozenGraph(py_fg)))
+    return NULL;
+
+  Py_BEGIN_ALLOW_THREADS
+  result = frozen_mcdindex(fg, ID, TIMESTAMP);
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("d", result);
+}
+
+/*******************************************************************************
+ * Compute the I index on a frozen graph                                       *
+ ******************************************************************************/
+static PyObject *py_frozen_iindex(PyObject *self, PyObject *args) {
+  long long int ID;
+  long long int TIMESTAMP;
+  double result;
+  FrozenGraph *fg;
+  PyObject *py_fg;
+
+  if (!PyArg_ParseTuple(args,"OLL",&py_fg, &ID, &TIMESTAMP))
+    return NULL;
+  if (!(fg = PyFrozenGraph_AsFrozenGraph(py_fg)))
+    return NULL;
+
+  Py_BEGIN_ALLOW_THREADS
+  result = frozen_iindex(fg, ID, TIMESTAMP);
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("d", result);
+}
+
+/*******************************************************************************
+ * Compress the graph into gap-encoded neighbor lists                          *
+ ******************************************************************************/
+static PyObject *py_compress_graph(PyObject *self, PyObject *args) {
+  Graph *g;
+  CompressedGraph *cg;
+  PyObject *py_g;
+
+  if (!PyArg_ParseTuple(args,"O",&py_g))
+    return NULL;
+  if (!(g = PyGraph_AsGraph(py_g)))
+    return NULL;
+
+  cg = (CompressedGraph *) malloc(sizeof(CompressedGraph));
+  if (cg == NULL)
+    return PyErr_NoMemory();
+  PyGraph_BeginRead(py_g);
+  Py_BEGIN_ALLOW_THREADS
+  compress_graph(g, cg);
+  Py_END_ALLOW_THREADS
+  PyGraph_EndRead(py_g);
+
+  return PyCompressedGraph_FromCompressedGraph(cg, 1);
+}
+
+/*******************************************************************************
+ * Get the memory taken by a compressed graph                                  *
+ ******************************************************************************/
+static PyObject *py_get_compressed_memory(PyObject *self, PyObject *args) {
+  CompressedGraph *cg;
+  PyObject *py_cg;
+
+  if (!PyArg_ParseTuple(args,"O",&py_cg))
+    return NULL;
+  if (!(cg = PyCompressedGraph_AsCompressedGraph(py_cg)))
+    return NULL;
+
+  return Py_BuildValue("L", compressed_graph_memory(cg));
+}
+
+/*******************************************************************************
+ * Compute the CD index on a compressed graph                                  *
+ ******************************************************************************/
+static PyObject *py_compressed_cdindex(PyObject *self, PyObject *args) {
+  long long int ID;
+  long long int TIMESTAMP;
+  double result;
+  CompressedGraph *cg;
+  PyObject *py_cg;
+
+  if (!PyArg_ParseTuple(args,"OLL",&py_cg, &ID, &TIMESTAMP))
+    return NULL;
+  if (!(cg = PyCompressedGraph_AsCompressedGraph(py_cg)))
+    return NULL;
+
+  Py_BEGIN_ALLOW_THREADS
+  result = compressed_cdindex(cg, ID, TIMESTAMP);
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("d", result);
+}
+
+/*******************************************************************************
+ * Compute the mCD index on a compressed graph                                 *
+ ******************************************************************************/
+static PyObject *py_compressed_mcdindex(PyObject *self, PyObject *args) {
+  long long int ID;
+  long long int TIMESTAMP;
+  double result;
+  CompressedGraph *cg;
+  PyObject *py_cg;
+
+  if (!PyArg_ParseTuple(args,"OLL",&py_cg, &ID, &TIMESTAMP))
+    return NULL;
+  if (!(cg = PyCompressedGraph_AsCompressedGraph(py_cg)))
+    return NULL;
+
+  Py_BEGIN_ALLOW_THREADS
+  result = compressed_mcdindex(cg, ID, TIMESTAMP);
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("d", result);
+}
+
+/*******************************************************************************
+ * Compute the I index on a compressed graph                                   *
+ ******************************************************************************/
+static PyObject *py_compressed_iindex(PyObject *self, PyObject *args) {
+  long long int ID;
+  long long int TIMESTAMP;
+  double result;
+  CompressedGraph *cg;
+  PyObject *py_cg;
+
+  if (!PyArg_ParseTuple(args,"OLL",&py_cg, &ID, &TIMESTAMP))
+    return NULL;
+  if (!(cg = PyCompressedGraph_AsCompressedGraph(py_cg)))
+    return NULL;
+
+  Py_BEGIN_ALLOW_THREADS
+  result = compressed_iindex(cg, ID, TIMESTAMP);
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("d", result);
+}
+
+/*******************************************************************************
+ * Compute a measure for many focal vertices of a graph of any kind            *
+ ******************************************************************************/
+static PyObject *py_batch(PyObject *args, int kind, int measure) {
+  long long int TIMESTAMP;
+  long long int *ids;
+  long long int vcount;
+  int threads = 1;
+  Py_ssize_t n;
+  int as_of;
+  void *out;
+  Graph *g = NULL;
+  FrozenGraph *fg = NULL;
+  CompressedGraph *cg = NULL;
+  GraphView view;
+  PyObject *py_g, *py_ids, *result, *py_cutoff = NULL;
+
+  if (!PyArg_ParseTuple(args,"OOL|iO",&py_g, &py_ids, &TIMESTAMP, &threads, &py_cutoff))
+    return NULL;
+  if (kind == BATCH_FROZEN) {
+    if (!(fg = PyFrozenGraph_AsFrozenGraph(py_g)))
+      return NULL;
+    vcount = fg->vcount;
+  }
+  else if (kind == BATCH_COMPRESSED) {
+    if (!(cg = PyCompressedGraph_AsCompressedGraph(py_g)))
+      return NULL;
+    vcount = cg->vcount;
+  }
+  else {
+    if (!(g = PyGraph_AsGraph(py_g)))
+      return NULL;
+    vcount = g->vcount;
+  }
+  if ((as_of = PyCutoff_AsView(py_cutoff, g, fg, cg, &view)) < 0)
+    return NULL;
+
+  // None stands for every vertex in the graph
+  if (py_ids == Py_None) {
+    n = vcount;
+    if (!(ids = malloc((n > 0 ? n : 1) * sizeof(long long int))))
+      return PyErr_NoMemory();
+    for (Py_ssize_t i = 0; i < n; i++)
+      ids[i] = i;
+  }
+  else if (!(ids = PyIds_AsArray(py_ids, vcount, &n)))
+    return NULL;
+  if (!(result = PyResultArray_New(n, measure == BATCH_IINDEX ? "q" : "d", &out))) {
+    free(ids);
+    return NULL;
+  }
+
+  // one thread runs the batch functions, more run the parallel engine;
+  // compressed graphs always run on one thread
+  if (kind == BATCH_GRAPH)
+    PyGraph_BeginRead(py_g);
+  Py_BEGIN_ALLOW_THREADS
+  if (as_of) switch (measure) {
+    case BATCH_CDINDEX:
+      if (cg || threads == 1) view_cdindex_batch(&view, ids, n, TIMESTAMP, out);
+      else view_parallel_cdindex(&view, ids, n, TIMESTAMP, threads, out);
+      break;
+    case BATCH_MCDINDEX:
+      if (cg || threads == 1) view_mcdindex_batch(&view, ids, n, TIMESTAMP, out);
+      else view_parallel_mcdindex(&view, ids, n, TIMESTAMP, threads, out);
+      break;
+    case BATCH_IINDEX:
+      if (cg || threads == 1) view_iindex_batch(&view, ids, n, TIMESTAMP, out);
+      else view_parallel_iindex(&view, ids, n, TIMESTAMP, threads, out);
+      break;
+  }
+  else switch (measure) {
+    case BATCH_CDINDEX:
+      if (cg) compressed_cdindex_batch(cg, ids, n, TIMESTAMP, out);
+      else if (threads == 1 && fg) frozen_cdindex_batch(fg, ids, n, TIMESTAMP, out);
+      else if (threads == 1) cdindex_batch(g, ids, n, TIMESTAMP, out);
+      else if (fg) frozen_parallel_cdindex(fg, ids, n, TIMESTAMP, threads, out);
+      else parallel_cdindex(g, ids, n, TIMESTAMP, threads, out);
+      break;
+    case BATCH_MCDINDEX:
+      if (cg) compressed_mcdindex_batch(cg, ids, n, TIMESTAMP, out);
+      else if (threads == 1 && fg) frozen_mcdindex_batch(fg, ids, n, TIMESTAMP, out);
+      else if (threads == 1) mcdindex_batch(g, ids, n, TIMESTAMP, out);
+      else if (fg) frozen_parallel_mcdindex(fg, ids, n, TIMESTAMP, threads, out);
+      else parallel_mcdindex(g, ids, n, TIMESTAMP, threads, out);
+      break;
+    case BATCH_IINDEX:
+      if (cg) compressed_iindex_batch(cg, ids, n, TIMESTAMP, out);
+      else if (threads == 1 && fg) frozen_iindex_batch(fg, ids, n, TIMESTAMP, out);
+      else if (threads == 1) iindex_batch(g, ids, n, TIMESTAMP, out);
+      else if (fg) frozen_parallel_iindex(fg, ids, n, TIMESTAMP, threads, out);
+      else parallel_iindex(g, ids, n, TIMESTAMP, threads, out);
+      break;
+  }
+  Py_END_ALLOW_THREADS
+  if (kind == BATCH_GRAPH)
+    PyGraph_EndRead(py_g);
+
+  free(ids);
+  return result;
+}
+
+static PyObject *py_cdindex_batch(PyObject *self, PyObject *args) {
+  return py_batch(args, BATCH_GRAPH, BATCH_CDINDEX);
+}
+static PyObject *py_mcdindex_batch(PyObject *self, PyObject *args) {
+  return py_batch(args, BATCH_GRAPH, BATCH_MCDINDEX);
+}
+static PyObject *py_iindex_batch(PyObject *self, PyObject *args) {
+  return py_batch(args, BATCH_GRAPH, BATCH_IINDEX);
+}
+static PyObject *py_frozen_cdindex_batch(PyObject *self, PyObject *args) {
+  return py_batch(args, BATCH_FROZEN, BATCH_CDINDEX);
+}
+static PyObject *py_frozen_mcdindex_batch(PyObject *self, PyObject *args) {
+  return py_batch(args, BATCH_FROZEN, BATCH_MCDINDEX);
+}
+static PyObject *py_frozen_iindex_batch(PyObject *self, PyObject *args) {
+  return py_batch(args, BATCH_FROZEN, BATCH_IINDEX);
+}
+static PyObject *py_compressed_cdindex_batch(PyObject *self, PyObject *args) {
+  return py_batch(args, BATCH_COMPRESSED, BATCH_CDINDEX);
+}
+static PyObject *py_compressed_mcdindex_batch(PyObject *self, PyObject *args) {
+  return py_batch(args, BATCH_COMPRESSED, BATCH_MCDINDEX);
+}
+static PyObject *py_compressed_iindex_batch(PyObject *self, PyObject *args) {
+  return py_batch(args, BATCH_COMPRESSED, BATCH_IINDEX);
+}
+
+/*******************************************************************************
+ * Compute the components of the CD index of a vertex of a graph of any kind   *
+ ******************************************************************************/
+static PyObject *py_components(PyObject *args, int kind) {
+  long long int ID;
+  long long int TIMESTAMP;
+  int as_of;
+  CDComponents c;
+  Graph *g = NULL;
+  FrozenGraph *fg = NULL;
+  CompressedGraph *cg = NULL;
+  GraphView view;
+  PyObject *py_g, *py_cutoff = NULL;
+
+  if (!PyArg_ParseTuple(args,"OLL|O",&py_g, &ID, &TIMESTAMP, &py_cutoff))
+    return NULL;
+  if (kind == BATCH_FROZEN) {
+    if (!(fg = PyFrozenGraph_AsFrozenGraph(py_g)))
+      return NULL;
+  }
+  else if (kind == BATCH_COMPRESSED) {
+    if (!(cg = PyCompressedGraph_AsCompressedGraph(py_g)))
+      return NULL;
+  }
+  else {
+    if (!(g = PyGraph_AsGraph(py_g)))
+      return NULL;
+  }
+  if ((as_of = PyCutoff_AsView(py_cutoff, g, fg, cg, &view)) < 0)
+    return NULL;
+
+  if (kind == BATCH_GRAPH)
+    PyGraph_BeginRead(py_g);
+  Py_BEGIN_ALLOW_THREADS
+  if (as_of) view_cdindex_components(&view, ID, TIMESTAMP, &c);
+  else if (cg) compressed_cdindex_components(cg, ID, TIMESTAMP, &c);
+  else if (fg) frozen_cdindex_components(fg, ID, TIMESTAMP, &c);
+  else cdindex_components(g, ID, TIMESTAMP, &c);
+  Py_END_ALLOW_THREADS
+  if (kind == BATCH_GRAPH)
+    PyGraph_EndRead(py_g);
+
+  return Py_BuildValue("{s:L,s:L,s:L,s:L,s:d,s:d}", "n_f", c.n_f, "n_b", c.n_b, "n_r", c.n_r,
+                       "iindex", c.iindex, "cdindex", c.cdindex, "mcdindex", c.mcdindex);
+}
+
+static PyObject *py_cdindex_components(PyObject *self, PyObject *args) {
+  return py_components(args, BATCH_GRAPH);
+}
+static PyObject *py_frozen_cdindex_components(PyObject *self, PyObject *args) {
+  return py_components(args, BATCH_FROZEN);
+}
+static PyObject *py_compressed_cdindex_components(PyObject *self, PyObject *args) {
+  return py_components(args, BATCH_COMPRESSED);
+}
+
+/*******************************************************************************
+ * Estimate the CD index on a frozen graph from a sample                       *
+ ******************************************************************************/
+static PyObject *py_frozen_cdindex_estimate(PyObject *self, PyObject *args) {
+  long long int ID;
+  long long int TIMESTAMP;
+  double tolerance, confidence;
+  long long int exact_below;
+  unsigned long long int seed;
+  int as_of;
+  CDEstimate e;
+  FrozenGraph *fg;
+  GraphView view;
+  PyObject *py_fg, *py_cutoff = NULL;
+
+  if (!PyArg_ParseTuple(args,"OLLddLK|O",&py_fg, &ID, &TIMESTAMP, &tolerance, &confidence, &exact_below, &seed, &py_cutoff))
+    return NULL;
+  if (!(fg = PyFrozenGraph_AsFrozenGraph(py_fg)))
+    return NULL;
+  if ((as_of = PyCutoff_AsView(py_cutoff, NULL, fg, NULL, &view)) < 0)
+    return NULL;
+  if (!(tolerance > 0.0) || !(confidence > 0.0 && confidence < 1.0)) {
+    PyErr_SetString(PyExc_ValueError, "The tolerance must be positive and the confidence in (0, 1)");
+    return NULL;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+  if (as_of) view_cdindex_estimate(&view, ID, TIMESTAMP, tolerance, confidence, exact_below, seed, &e);
+  else frozen_cdindex_estimate(fg, ID, TIMESTAMP, tolerance, confidence, exact_below, seed, &e);
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("{s:d,s:d,s:d,s:L,s:O}", "cdindex", e.cdindex, "lower", e.lower, "upper", e.upper,
+                       "sampled", e.sampled, "exact", e.exact ? Py_True : Py_False);
+}
+
+/*******************************************************************************
+ * Compute the CD index of many focal vertices at several time deltas          *
+ ******************************************************************************/
+static PyObject *py_multi_batch(PyObject *args, int kind) {
+  long long int *ids, *deltas;
+  long long int vcount;
+  int threads = 1;
+  int as_of;
+  Py_ssize_t n, k;
+  void *out;
+  Graph *g = NULL;
+  FrozenGraph *fg = NULL;
+  CompressedGraph *cg = NULL;
+  GraphView view;
+  PyObject *py_g, *py_ids, *py_deltas, *seq, *result, *py_cutoff = NULL;
+
+  if (!PyArg_ParseTuple(args,"OOO|iO",&py_g, &py_ids, &py_deltas, &threads, &py_cutoff))
+    return NULL;
+  if (kind == BATCH_FROZEN) {
+    if (!(fg = PyFrozenGraph_AsFrozenGraph(py_g)))
+      return NULL;
+    vcount = fg->vcount;
+  }
+  else if (kind == BATCH_COMPRESSED) {
+    if (!(cg = PyCompressedGraph_AsCompressedGraph(py_g)))
+      return NULL;
+    vcount = cg->vcount;
+  }
+  else {
+    if (!(g = PyGraph_AsGraph(py_g)))
+      return NULL;
+    vcount = g->vcount;
+  }
+  if ((as_of = PyCutoff_AsView(py_cutoff, g, fg, cg, &view)) < 0)
+    return NULL;
+
+  // copy the time deltas
+  if (!(seq = PySequence_Fast(py_deltas, "time deltas must be a sequence")))
+    return NULL;
+  k = PySequence_Fast_GET_SIZE(seq);
+  if (!(deltas = malloc((k > 0 ? k : 1) * sizeof(long long int)))) {
+    Py_DECREF(seq);
+    return PyErr_NoMemory();
+  }
+  for (Py_ssize_t h = 0; h < k; h++) {
+    deltas[h] = PyLong_AsLongLong(PySequence_Fast_GET_ITEM(seq, h));
+    if (deltas[h] == -1 && PyErr_Occurred())
+      break;
+  }
+  Py_DECREF(seq);
+  if (PyErr_Occurred()) {
+    free(deltas);
+    return NULL;
+  }
+
+  // None stands for every vertex in the graph
+  if (py_ids == Py_None) {
+    n = vcount;
+    if (!(ids = malloc((n > 0 ? n : 1) * sizeof(long long int)))) {
+      free(deltas);
+      return PyErr_NoMemory();
+    }
+    for (Py_ssize_t i = 0; i < n; i++)
+      ids[i] = i;
+  }
+  else if (!(ids = PyIds_AsArray(py_ids, vcount, &n))) {
+    free(deltas);
+    return NULL;
+  }
+  if (!(result = PyResultArray_New(n * k, "d", &out))) {
+    free(ids);
+    free(deltas);
+    return NULL;
+  }
+
+  if (kind == BATCH_GRAPH)
+    PyGraph_BeginRead(py_g);
+  Py_BEGIN_ALLOW_THREADS
+  if (as_of && (cg || threads == 1)) view_cdindex_multi_batch(&view, ids, n, deltas, k, out);
+  else if (as_of) view_parallel_cdindex_multi(&view, ids, n, deltas, k, threads, out);
+  else if (cg) compressed_cdindex_multi_batch(cg, ids, n, deltas, k, out);
+  else if (threads == 1 && fg) frozen_cdindex_multi_batch(fg, ids, n, deltas, k, out);
+  else if (threads == 1) cdindex_multi_batch(g, ids, n, deltas, k, out);
+  else if (fg) frozen_parallel_cdindex_multi(fg, ids, n, deltas, k, threads, out);
+  else parallel_cdindex_multi(g, ids, n, deltas, k, threads, out);
+  Py_END_ALLOW_THREADS
+  if (kind == BATCH_GRAPH)
+    PyGraph_EndRead(py_g);
+
+  free(ids);
+  free(deltas);
+
+  // one row of k values per focal vertex
+  return PyResultArray_Shape(result, n, k, "d");
+}
+
+static PyObject *py_cdindex_multi_batch(PyObject *self, PyObject *args) {
+  return py_multi_batch(args, BATCH_GRAPH);
+}
+static PyObject *py_frozen_cdindex_multi_batch(PyObject *self, PyObject *args) {
+  return py_multi_batch(args, BATCH_FROZEN);
+}
+static PyObject *py_compressed_cdindex_multi_batch(PyObject *self, PyObject *args) {
+  return py_multi_batch(args, BATCH_COMPRESSED);
+}
+
+/*******************************************************************************
+ * Compute the CD index or its components for every vertex in one sweep        *
+ ******************************************************************************/
+static PyObject *py_all(PyObject *args, int kind, int components) {
+  long long int *deltas;
+  long long int vcount;
+  Py_ssize_t k;
+  int flat;
+  int as_of;
+  void *out[3];
+  Graph *g = NULL;
+  FrozenGraph *fg = NULL;
+  GraphView view;
+  PyObject *py_g, *py_deltas, *seq, *result, *py_cutoff = NULL;
+
+  if (!PyArg_ParseTuple(args,"OO|O",&py_g, &py_deltas, &py_cutoff))
+    return NULL;
+  if (kind == BATCH_FROZEN) {
+    if (!(fg = PyFrozenGraph_AsFrozenGraph(py_g)))
+      return NULL;
+    vcount = fg->vcount;
+  }
+  else {
+    if (!(g = PyGraph_AsGraph(py_g)))
+      return NULL;
+    vcount = g->vcount;
+  }
+  if ((as_of = PyCutoff_AsView(py_cutoff, g, fg, NULL, &view)) < 0)
+    return NULL;
+
+  // a single time delta gives flat arrays, a sequence one column per delta
+  flat = PyLong_Check(py_deltas);
+  if (flat) {
+    k = 1;
+    if (!(deltas = malloc(sizeof(long long int))))
+      return PyErr_NoMemory();
+    deltas[0] = PyLong_AsLongLong(py_deltas);
+  }
+  else {
+    if (!(seq = PySequence_Fast(py_deltas, "time deltas must be an integer or a sequence")))
+      return NULL;
+    k = PySequence_Fast_GET_SIZE(seq);
+    if (!(deltas = malloc((k > 0 ? k : 1) * sizeof(long long int)))) {
+      Py_DECREF(seq);
+      return PyErr_NoMemory();
+    }
+    for (Py_ssize_t h = 0; h < k; h++) {
+      deltas[h] = PyLong_AsLongLong(PySequence_Fast_GET_ITEM(seq, h));
+      if (deltas[h] == -1 && PyErr_Occurred())
+        break;
+    }
+    Py_DECREF(seq);
+  }
+  if (PyErr_Occurred()) {
+    free(deltas);
+    return NULL;
+  }
+
+  // the components are three arrays of counts, n_f, n_b and n_r
+  if (!(result = PyTuple_New(components ? 3 : 1))) {
+    free(deltas);
+    return NULL;
+  }
+  for (int c = 0; c < PyTuple_GET_SIZE(result); c++) {
+    PyObject *array = PyResultArray_New(vcount * k, components ? "q" : "d", &out[c]);
+    if (!array) {
+      Py_DECREF(result);
+      free(deltas);
+      return NULL;
+    }
+    PyTuple_SET_ITEM(result, c, array);
+  }
+
+  if (k > 0) {
+    if (kind == BATCH_GRAPH)
+      PyGraph_BeginRead(py_g);
+    Py_BEGIN_ALLOW_THREADS
+    if (components && as_of) view_cdindex_all_counts(&view, deltas, k, out[0], out[1], out[2]);
+    else if (as_of) view_cdindex_all(&view, deltas, k, out[0]);
+    else if (components && fg) frozen_cdindex_all_counts(fg, deltas, k, out[0], out[1], out[2]);
+    else if (components) cdindex_all_counts(g, deltas, k, out[0], out[1], out[2]);
+    else if (fg) frozen_cdindex_all(fg, deltas, k, out[0]);
+    else cdindex_all(g, deltas, k, out[0]);
+    Py_END_ALLOW_THREADS
+    if (kind == BATCH_GRAPH)
+      PyGraph_EndRead(py_g);
+  }
+  free(deltas);
+
+  // one row of k values per vertex
+  for (int c = 0; !flat && c < PyTuple_GET_SIZE(result); c++) {
+    PyObject *shaped = PyResultArray_Shape(PyTuple_GET_ITEM(result, c), vcount, k, components ? "q" : "d");
+    PyTuple_SET_ITEM(result, c, shaped);
+    if (!shaped) {
+      Py_DECREF(result);
+      return NULL;
+    }
+  }
+  if (!components) {
+    PyObject *values = PyTuple_GET_ITEM(result, 0);
+    Py_INCREF(values);
+    Py_DECREF(result);
+    return values;
+  }
+  return result;
+}
+
+static PyObject *py_cdindex_all(PyObject *self, PyObject *args) {
+  return py_all(args, BATCH_GRAPH, 0);
+}
+static PyObject *py_frozen_cdindex_all(PyObject *self, PyObject *args) {
+  return py_all(args, BATCH_FROZEN, 0);
+}
+static PyObject *py_cdindex_all_counts(PyObject *self, PyObject *args) {
+  return py_all(args, BATCH_GRAPH, 1);
+}
+static PyObject *py_frozen_cdindex_all_counts(PyObject *self, PyObject *args) {
+  return py_all(args, BATCH_FROZEN, 1);
+}
+
+/*******************************************************************************
+ * Start streaming CD index updates for a graph                                *
+ ******************************************************************************/
+static PyObject *py_stream_new(PyObject *self, PyObject *args) {
+  Graph *g;
+  Stream *stream;
+  long long int *deltas;
+  Py_ssize_t k;
+  PyObject *py_g, *py_deltas, *seq, *capsule;
+
+  if (!PyArg_ParseTuple(args,"OO",&py_g, &py_deltas))
+    return NULL;
+  if (!(g = PyGraph_AsWritableGraph(py_g)))
+    return NULL;
+
+  // copy the time deltas
+  if (!(seq = PySequence_Fast(py_deltas, "time deltas must be a sequence")))
+    return NULL;
+  k = PySequence_Fast_GET_SIZE(seq);
+  if (k == 0) {
+    Py_DECREF(seq);
+    PyErr_SetString(PyExc_ValueError, "At least one time delta is needed");
+    return NULL;
+  }
+  if (!(deltas = malloc(k * sizeof(long long int)))) {
+    Py_DECREF(seq);
+    return PyErr_NoMemory();
+  }
+  for (Py_ssize_t h = 0; h < k; h++) {
+    deltas[h] = PyLong_AsLongLong(PySequence_Fast_GET_ITEM(seq, h));
+    if (deltas[h] == -1 && PyErr_Occurred())
+      break;
+  }
+  Py_DECREF(seq);
+  if (PyErr_Occurred() || !(stream = malloc(sizeof(Stream)))) {
+    free(deltas);
+    return PyErr_Occurred() ? NULL : PyErr_NoMemory();
+  }
+
+  PyGraph_BeginRead(py_g);
+  Py_BEGIN_ALLOW_THREADS
+  init_stream(stream, g, deltas, k);
+  Py_END_ALLOW_THREADS
+  PyGraph_EndRead(py_g);
+  free(deltas);
+
+  if (!(capsule = PyCapsule_New(stream, "Stream", del_Stream))) {
+    free_stream(stream);
+    free(stream);
+    return NULL;
+  }
+  Py_INCREF(py_g);
+  PyCapsule_SetContext(capsule, py_g);
+  return capsule;
+}
+
+/*******************************************************************************
+ * Add a vertex and its references to a streamed graph                         *
+ ******************************************************************************/
+static PyObject *py_stream_add_vertex(PyObject *self, PyObject *args) {
+  long long int TIMESTAMP;
+  long long int *refs, *sorted;
+  Py_ssize_t n;
+  Graph *g;
+  Stream *stream;
+  PyObject *py_stream, *py_refs;
+
+  if (!PyArg_ParseTuple(args,"OLO",&py_stream, &TIMESTAMP, &py_refs))
+    return NULL;
+  if (!(stream = PyCapsule_GetPointer(py_stream, "Stream")))
+    return NULL;
+  if (!(g = PyGraph_AsWritableGraph(PyCapsule_GetContext(py_stream))))
+    return NULL;
+  if (!vertex_fits(g->vcount, TIMESTAMP)) {
+    PyErr_SetString(PyExc_ValueError, error_message(7));
+    return NULL;
+  }
+  if (!(refs = PyIds_AsArray(py_refs, g->vcount, &n)))
+    return NULL;
+
+  // the references must be distinct
+  if (!(sorted = malloc((n > 0 ? n : 1) * sizeof(long long int)))) {
+    free(refs);
+    return PyErr_NoMemory();
+  }
+  memcpy(sorted, refs, n * sizeof(long long int));
+  qsort(sorted, n, sizeof(long long int), compare_int);
+  for (Py_ssize_t i = 1; i < n; i++) {
+    if (sorted[i] == sorted[i-1]) {
+      free(sorted);
+      free(refs);
+      PyErr_SetString(PyExc_ValueError, error_message(3));
+      return NULL;
+    }
+  }
+  free(sorted);
+
+  stream_add_vertex(stream, g->vcount, TIMESTAMP, refs, n);
+  free(refs);
+
+  return Py_BuildValue("L", g->vcount - 1);
+}
+
+/*******************************************************************************
+ * Get the streamed CD index of a vertex at one of the tracked time deltas     *
+ ******************************************************************************/
+static PyObject *py_stream_cdindex(PyObject *self, PyObject *args) {
+  long long int ID, HORIZON;
+  Stream *stream;
+  PyObject *py_stream;
+
+  if (!PyArg_ParseTuple(args,"OLL",&py_stream, &ID, &HORIZON))
+    return NULL;
+  if (!(stream = PyCapsule_GetPointer(py_stream, "Stream")))
+    return NULL;
+  if (ID < 0 || ID >= stream->graph->vcount || HORIZON < 0 || HORIZON >= stream->k) {
+    PyErr_SetString(PyExc_ValueError, error_message(2));
+    return NULL;
+  }
+
+  return Py_BuildValue("d", stream_cdindex(stream, ID, HORIZON));
+}
+
+/*******************************************************************************
+ * Get the counters of the index computations since the last reset             *
+ ******************************************************************************/
+static PyObject *py_get_stats(PyObject *self, PyObject *args) {
+  IndexStats *stats = malloc(sizeof(IndexStats));
+  if (stats == NULL)
+    return PyErr_NoMemory();
+
+  get_stats(stats);
+  PyObject *result = Py_BuildValue("{s:O,s:L,s:L,s:L,s:L,s:L,s:L,s:d,s:d,s:d,s:d,s:d,s:d,s:d}",
+    "enabled", stats_enabled() ? Py_True : Py_False,
+    "calls", stats->calls,
+    "vertices_visited", stats->vertices_visited,
+    "in_edges_scanned", stats->in_edges_scanned,
+    "in_edges_in_window", stats->in_edges_in_window,
+    "it_vertices", stats->it_vertices,
+    "membership_probes", stats->membership_probes,
+    "seconds", stats->nanoseconds * 1e-9,
+    "it_p50", stats_percentile(stats->it_histogram, 0.5),
+    "it_p90", stats_percentile(stats->it_histogram, 0.9),
+    "it_p99", stats_percentile(stats->it_histogram, 0.99),
+    "seconds_p50", stats_percentile(stats->time_histogram, 0.5) * 1e-9,
+    "seconds_p90", stats_percentile(stats->time_histogram, 0.9) * 1e-9,
+    "seconds_p99", stats_percentile(stats->time_histogram, 0.99) * 1e-9);
+  free(stats);
+  return result;
+}
+
+/*******************************************************************************
+ * Zero the counters of the index computations                                 *
+ ******************************************************************************/
+static PyObject *py_reset_stats(PyObject *self, PyObject *args) {
+  reset_stats();
+  Py_RETURN_NONE;
+}
 
 /*******************************************************************************
  * Module method table                                                         *
@@ -342,6 +1856,11 @@ static PyMethodDef CDIndexMethods[] = {
   {"_is_graph_sane", py_is_graph_sane, METH_VARARGS, "Test graph sanity"},
   {"add_vertex", py_add_vertex, METH_VARARGS, "Add a vertex to a graph"},
   {"add_edge", py_add_edge, METH_VARARGS, "Add an edge to a graph"},
+  {"bulk_load_graph", py_bulk_load_graph, METH_VARARGS, "Add many vertices and edges to a graph at once"},
+  {"bulk_load_arrays", py_bulk_load_arrays, METH_VARARGS, "Add many vertices and edges to the graph from arrays of integers"},
+  {"get_memory_usage", py_get_memory_usage, METH_VARARGS, "Get the bytes used and reserved by a graph"},
+  {"graph_reserve", py_graph_reserve, METH_VARARGS, "Reserve memory ahead of adding vertices and edges"},
+  {"sort_adjacency", py_sort_adjacency, METH_VARARGS, "Sort the out edges of every vertex in a graph"},
   {"get_vertices", py_get_vertices, METH_VARARGS, "Get a list of vertices in the graph"},
   {"get_vcount", py_get_vcount, METH_VARARGS, "Get the number of vertices in the graph"},
   {"get_ecount", py_get_ecount, METH_VARARGS, "Get the number of edges in the graph"},
@@ -353,6 +1872,45 @@ static PyMethodDef CDIndexMethods[] = {
   {"cdindex", py_cdindex, METH_VARARGS, "Compute the CD index"},
   {"mcdindex", py_mcdindex, METH_VARARGS, "Compute the mCD index"},
   {"iindex", py_iindex, METH_VARARGS, "Compute the I index"},
+  {"cdindex_components", py_cdindex_components, METH_VARARGS, "Compute the components of the CD index and the derived indices"},
+  {"freeze_graph", py_freeze_graph, METH_VARARGS, "Freeze a graph into a compressed sparse row structure"},
+  {"stream_new", py_stream_new, METH_VARARGS, "Start streaming CD index updates for a graph"},
+  {"stream_add_vertex", py_stream_add_vertex, METH_VARARGS, "Add a vertex and its references to a streamed graph"},
+  {"stream_cdindex", py_stream_cdindex, METH_VARARGS, "Get the streamed CD index of a vertex"},
+  {"save_frozen_graph", py_save_frozen_graph, METH_VARARGS, "Write a frozen graph to a snapshot file"},
+  {"map_frozen_graph", py_map_frozen_graph, METH_VARARGS, "Map a snapshot file into memory as a frozen graph"},
+  {"get_frozen_counts", py_get_frozen_counts, METH_VARARGS, "Get the number of vertices and edges of a frozen graph"},
+  {"get_frozen_vertex_timestamp", py_get_frozen_vertex_timestamp, METH_VARARGS, "Get the timestamp of a vertex of a frozen graph"},
+  {"get_frozen_arrays", py_get_frozen_arrays, METH_VARARGS, "View the arrays of a frozen graph without copying them"},
+  {"frozen_cdindex", py_frozen_cdindex, METH_VARARGS, "Compute the CD index on a frozen graph"},
+  {"frozen_mcdindex", py_frozen_mcdindex, METH_VARARGS, "Compute the mCD index on a frozen graph"},
+  {"frozen_iindex", py_frozen_iindex, METH_VARARGS, "Compute the I index on a frozen graph"},
+  {"frozen_cdindex_components", py_frozen_cdindex_components, METH_VARARGS, "Compute the components of the CD index and the derived indices on a frozen graph"},
+  {"frozen_cdindex_estimate", py_frozen_cdindex_estimate, METH_VARARGS, "Estimate the CD index on a frozen graph from a sample of the citing vertices"},
+  {"compress_graph", py_compress_graph, METH_VARARGS, "Compress the graph into gap-encoded neighbor lists"},
+  {"get_compressed_memory", py_get_compressed_memory, METH_VARARGS, "Get the memory taken by a compressed graph"},
+  {"compressed_cdindex", py_compressed_cdindex, METH_VARARGS, "Compute the CD index on a compressed graph"},
+  {"compressed_mcdindex", py_compressed_mcdindex, METH_VARARGS, "Compute the mCD index on a compressed graph"},
+  {"compressed_iindex", py_compressed_iindex, METH_VARARGS, "Compute the I index on a compressed graph"},
+  {"compressed_cdindex_components", py_compressed_cdindex_components, METH_VARARGS, "Compute the components of the CD index and the derived indices on a compressed graph"},
+  {"cdindex_batch", py_cdindex_batch, METH_VARARGS, "Compute the CD index of many vertices"},
+  {"mcdindex_batch", py_mcdindex_batch, METH_VARARGS, "Compute the mCD index of many vertices"},
+  {"iindex_batch", py_iindex_batch, METH_VARARGS, "Compute the I index of many vertices"},
+  {"frozen_cdindex_batch", py_frozen_cdindex_batch, METH_VARARGS, "Compute the CD index of many vertices on a frozen graph"},
+  {"frozen_mcdindex_batch", py_frozen_mcdindex_batch, METH_VARARGS, "Compute the mCD index of many vertices on a frozen graph"},
+  {"frozen_iindex_batch", py_frozen_iindex_batch, METH_VARARGS, "Compute the I index of many vertices on a frozen graph"},
+  {"cdindex_multi_batch", py_cdindex_multi_batch, METH_VARARGS, "Compute the CD index of many vertices at several time deltas"},
+  {"frozen_cdindex_multi_batch", py_frozen_cdindex_multi_batch, METH_VARARGS, "Compute the CD index of many vertices at several time deltas on a frozen graph"},
+  {"compressed_cdindex_batch", py_compressed_cdindex_batch, METH_VARARGS, "Compute the CD index of many vertices on a compressed graph"},
+  {"compressed_mcdindex_batch", py_compressed_mcdindex_batch, METH_VARARGS, "Compute the mCD index of many vertices on a compressed graph"},
+  {"compressed_iindex_batch", py_compressed_iindex_batch, METH_VARARGS, "Compute the I index of many vertices on a compressed graph"},
+  {"compressed_cdindex_multi_batch", py_compressed_cdindex_multi_batch, METH_VARARGS, "Compute the CD index of many vertices at several time deltas on a compressed graph"},
+  {"cdindex_all", py_cdindex_all, METH_VARARGS, "Compute the CD index of every vertex in one sweep"},
+  {"frozen_cdindex_all", py_frozen_cdindex_all, METH_VARARGS, "Compute the CD index of every vertex in one sweep on a frozen graph"},
+  {"cdindex_all_counts", py_cdindex_all_counts, METH_VARARGS, "Compute the CD index components of every vertex in one sweep"},
+  {"frozen_cdindex_all_counts", py_frozen_cdindex_all_counts, METH_VARARGS, "Compute the CD index components of every vertex in one sweep on a frozen graph"},
+  {"get_stats", py_get_stats, METH_NOARGS, "Get the counters of the index computations"},
+  {"reset_stats", py_reset_stats, METH_NOARGS, "Zero the counters of the index computations"},
   { NULL, NULL, 0, NULL}
 };
 
@@ -361,23 +1919,43 @@ static PyMethodDef CDIndexMethods[] = {
  ******************************************************************************/
 
 
+/* the compact build is a second module, so both can be loaded at once */
+#ifdef CDINDEX_COMPACT
+#define MODULE_NAME "_cdindex_compact"
+#else
+#define MODULE_NAME "_cdindex"
+#endif
+
 #ifdef PY3K
 static struct PyModuleDef _cdindex =
 {
     PyModuleDef_HEAD_INIT,
-    "_cdindex", 
+    MODULE_NAME, 
     "",         
     -1,         
     CDIndexMethods
 };
 
+#ifdef CDINDEX_COMPACT
+PyMODINIT_FUNC PyInit__cdindex_compact(void)
+#else
 PyMODINIT_FUNC PyInit__cdindex(void)
+#endif
 {
+    if (PyType_Ready(&CArrayType) < 0)
+      return NULL;
     return PyModule_Create(&_cdindex);
 }
 #else
+#ifdef CDINDEX_COMPACT
+PyMODINIT_FUNC
+init_cdindex_compact(void) {
+#else
 PyMODINIT_FUNC
 init_cdindex(void) {
-    (void) Py_InitModule("_cdindex", CDIndexMethods);
+#endif
+    if (PyType_Ready(&CArrayType) < 0)
+      return;
+    (void) Py_InitModule(MODULE_NAME, CDIndexMethods);
 }
 #endif
\ No newline at end of file
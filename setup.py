@@ -7,8 +7,27 @@ __author__ = "Russell J. Funk"
 __copyright__ = "Copyright (C) 2024"
 
 # built in modules
+import os
 from setuptools import setup, Extension, find_packages
 
+# the sources are built twice: with 64 bit vertex ids and timestamps, and as
+# a compact module with 32 bit ones
+sources = ["src/cdindex.c", 
+           "src/graph.c", 
+           "src/utility.c", 
+           "src/parallel.c",
+           "src/snapshot.c",
+           "src/stream.c",
+           "src/arena.c",
+           "src/compressed.c",
+           "src/simd.c",
+           "src/stats.c",
+           "src/view.c",
+           "cdindex/pycdindex.c"]
+
+# CDINDEX_STATS=1 builds the modules with the index computation counters
+stats_macros = [("CDINDEX_STATS", None)] if os.environ.get("CDINDEX_STATS") == "1" else []
+
 setup(name="cdindex",
     version="1.0.20",
     description="Package for computing the cdindex.",
@@ -19,11 +38,16 @@ setup(name="cdindex",
     install_requires=['future'],
     ext_modules=[
                   Extension("cdindex._cdindex",
-                            ["src/cdindex.c", 
-                             "src/graph.c", 
-                             "src/utility.c", 
-                             "cdindex/pycdindex.c"],
-                             include_dirs = ["src"],
+                            sources,
+                            include_dirs = ["src"],
+                            define_macros = stats_macros,
+                            extra_link_args = ["-pthread"],
+                           ),
+                  Extension("cdindex._cdindex_compact",
+                            sources,
+                            include_dirs = ["src"],
+                            define_macros = [("CDINDEX_COMPACT", None)] + stats_macros,
+                            extra_link_args = ["-pthread"],
                            )
                 ],
     packages=find_packages()
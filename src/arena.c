@@ -0,0 +1,172 @@
+/*
+  cdindex library.
+  Copyright (C) 2017 Russell J. Funk <russellfunk@gmail.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "cdindex.h"
+
+/* size of the chunks small blocks are carved from; larger blocks get a
+   chunk of their own */
+#define ARENA_CHUNK_SIZE (1LL << 20)
+
+/* a chunk of arena memory, with its blocks following the header */
+typedef struct ArenaChunk {
+  struct ArenaChunk *next;
+  long long int size;
+} ArenaChunk;
+
+/**
+ * \function size_class
+ * \brief Find the power of two size class of a vertex id array.
+ *
+ * Arrays of the class c hold at least 2^c ids.
+ *
+ * \param count The number of ids (at least 1).
+ * \param round_up Whether to round count up (to find a class that holds
+ *                 count ids) or down (to find the class of an array that
+ *                 holds count ids).
+ *
+ * \return The size class.
+ */
+static int size_class(long long int count, bool round_up) {
+  int c = 0;
+  while ((2LL << c) <= count) {
+    c++;
+  }
+  return round_up && (1LL << c) < count ? c + 1 : c;
+}
+
+/**
+ * \function add_chunk
+ * \brief Allocate a new chunk for an arena.
+ *
+ * \param arena The input arena.
+ * \param size The number of bytes the chunk must hold after its header.
+ *
+ * \return The start of the chunk's memory.
+ */
+static char *add_chunk(Arena *arena, long long int size) {
+  ArenaChunk *chunk = malloc(sizeof(ArenaChunk) + size);
+  if (chunk==NULL) {
+    raise_error(0);
+  }
+  chunk->next = arena->chunks;
+  chunk->size = size;
+  arena->chunks = chunk;
+  arena->reserved += size;
+  return (char *) (chunk + 1);
+}
+
+/**
+ * \function create_arena
+ * \brief Create an empty arena.
+ *
+ * \return The new arena (free with free_arena).
+ */
+Arena *create_arena(void) {
+  Arena *arena = calloc(1, sizeof(Arena));
+  if (arena==NULL) {
+    raise_error(0);
+  }
+  return arena;
+}
+
+/**
+ * \function arena_alloc_ids
+ * \brief Allocate a vertex id array from an arena.
+ *
+ * An array is reused from the free list of the smallest power of two size
+ * class that holds it when possible, and otherwise carved from the current
+ * chunk at exactly the size needed, so an allocation is a handful of
+ * instructions and carries no per-array header.
+ *
+ * \param arena The input arena.
+ * \param count The number of ids needed (at least 1).
+ * \param capacity Set to the number of ids the array holds.
+ *
+ * \return The array.
+ */
+VertexId *arena_alloc_ids(Arena *arena, long long int count, long long int *capacity) {
+
+  /* every array can hold a free list link and starts 8 byte aligned */
+  long long int per_word = 8 / sizeof(VertexId);
+  count = (count + per_word - 1) / per_word * per_word;
+
+  int c = size_class(count, true);
+  VertexId *array;
+
+  if (arena->free_lists[c] != NULL) {
+    array = arena->free_lists[c];
+    arena->free_lists[c] = *(void **) array;
+    arena->used += (long long int) sizeof(VertexId) << c;
+    *capacity = 1LL << c;
+    return array;
+  }
+
+  long long int bytes = count * sizeof(VertexId);
+  if (bytes > ARENA_CHUNK_SIZE / 4) {
+    array = (VertexId *) add_chunk(arena, bytes);
+  }
+  else {
+    if (bytes > arena->remaining) {
+      arena->next = add_chunk(arena, ARENA_CHUNK_SIZE);
+      arena->remaining = ARENA_CHUNK_SIZE;
+    }
+    array = (VertexId *) arena->next;
+    arena->next += bytes;
+    arena->remaining -= bytes;
+  }
+
+  arena->used += bytes;
+  *capacity = count;
+  return array;
+}
+
+/**
+ * \function arena_free_ids
+ * \brief Return a vertex id array to its arena for reuse.
+ *
+ * The array joins the free list of the largest size class it can hold.
+ *
+ * \param arena The input arena.
+ * \param array The array, allocated with arena_alloc_ids.
+ * \param capacity The capacity returned for the array.
+ */
+void arena_free_ids(Arena *arena, VertexId *array, long long int capacity) {
+  int c = size_class(capacity, false);
+  *(void **) array = arena->free_lists[c];
+  arena->free_lists[c] = array;
+  arena->used -= capacity * sizeof(VertexId);
+}
+
+/**
+ * \function free_arena
+ * \brief Free an arena and every array allocated from it.
+ *
+ * This frees one block per chunk, regardless of the number of arrays.
+ *
+ * \param arena The input arena.
+ */
+void free_arena(Arena *arena) {
+  while (arena->chunks != NULL) {
+    ArenaChunk *next = arena->chunks->next;
+    free(arena->chunks);
+    arena->chunks = next;
+  }
+  free(arena);
+}
@@ -0,0 +1,1134 @@
+/*
+  cdindex library.
+  Copyright (C) 2017 Russell J. Funk <russellfunk@gmail.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "cdindex.h"
+
+/* a measurement kept for the machine-readable results */
+typedef struct BenchmarkResult {
+  char name[64];
+  double value;
+  const char *unit;
+} BenchmarkResult;
+
+#define MAX_RESULTS 256
+
+static BenchmarkResult results[MAX_RESULTS];
+static int result_count = 0;
+
+/* state of the xorshift random number generator */
+static unsigned long long int rng_state = 88172645463325252ULL;
+
+/**
+ * \function random_int
+ * \brief Draw a random integer in [0, n) (xorshift64, for reproducible graphs).
+ *
+ * \param n The upper bound.
+ *
+ * \return The random integer.
+ */
+static long long int random_int(long long int n) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return (long long int) (rng_state % (unsigned long long int) n);
+}
+
+/**
+ * \function seconds_now
+ * \brief Read a monotonic clock.
+ *
+ * \return The current time in seconds.
+ */
+static double seconds_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * \function record
+ * \brief Keep a measurement for the machine-readable results.
+ *
+ * \param name The name of the measurement (dotted, e.g. "batch.cdindex").
+ * \param value The value.
+ * \param unit The unit of the value (e.g. "s", "bytes" or "x").
+ */
+static void record(const char *name, double value, const char *unit) {
+  if (result_count < MAX_RESULTS) {
+    snprintf(results[result_count].name, sizeof(results[result_count].name), "%s", name);
+    results[result_count].value = value;
+    results[result_count].unit = unit;
+    result_count++;
+  }
+}
+
+/**
+ * \function peak_memory
+ * \brief Read the peak resident memory of the process.
+ *
+ * \return The peak resident set size in bytes.
+ */
+static double peak_memory(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss * 1024.0;
+}
+
+/**
+ * \function write_json_number
+ * \brief Write a number to a JSON file (null if it is not finite).
+ *
+ * \param file The JSON file.
+ * \param value The number.
+ */
+static void write_json_number(FILE *file, double value) {
+  if (isfinite(value)) {
+    fprintf(file, "%.9g", value);
+  }
+  else {
+    fprintf(file, "null");
+  }
+}
+
+/**
+ * \function write_results
+ * \brief Write the parameters and measurements of a run as JSON.
+ *
+ * \param path The file to write (replaced if it exists).
+ * \param options The generator options of the graph.
+ * \param threads The number of threads of the parallel runs.
+ * \param passed Whether every result check passed.
+ *
+ * \return True if the file was written, False otherwise.
+ */
+static bool write_results(const char *path, GeneratorOptions *options, int threads, bool passed) {
+  static const char *distribution_names[] = {"fixed", "geometric", "power-law"};
+  static const char *level_names[] = {"scalar", "avx2", "avx512"};
+  FILE *file = fopen(path, "w");
+  if (file==NULL) {
+    return false;
+  }
+  fprintf(file, "{\n  \"format\": 1,\n  \"id_bits\": %d,\n  \"simd\": \"%s\",\n",
+          (int) (8 * sizeof(VertexId)), level_names[simd_level()]);
+  fprintf(file, "  \"parameters\": {\"vertices\": %lld, \"periods\": %lld, \"mean_refs\": %g, "
+          "\"refs_distribution\": \"%s\", \"refs_exponent\": %g, \"max_refs\": %lld, "
+          "\"attachment\": %g, \"recency\": %g, \"window\": %lld, \"seed\": %llu, \"threads\": %d},\n",
+          options->vcount, options->periods, options->mean_refs, distribution_names[options->refs_distribution],
+          options->refs_exponent, options->max_refs, options->attachment, options->recency, options->window,
+          options->seed, threads);
+  fprintf(file, "  \"results\": [\n");
+  for (int i = 0; i < result_count; i++) {
+    fprintf(file, "    {\"name\": \"%s\", \"value\": ", results[i].name);
+    write_json_number(file, results[i].value);
+    fprintf(file, ", \"unit\": \"%s\"}%s\n", results[i].unit, i + 1 < result_count ? "," : "");
+  }
+  fprintf(file, "  ],\n  \"passed\": %s\n}\n", passed ? "true" : "false");
+  return fclose(file) == 0;
+}
+
+/**
+ * \function reference_cdindex
+ * \brief Computes the CD Index with linear scans for "it" uniqueness.
+ *
+ * This is the original implementation of cdindex, kept as a baseline to
+ * check results and measure speedups against.
+ *
+ * \param graph The input graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ *
+ * \return The value of the CD index.
+ */
+static double reference_cdindex(Graph *graph, long long int id, long long int time_delta){
+
+  long long int it_count = 0;
+  long long int *it = malloc(sizeof(long long int));
+  if (it==NULL) {
+    raise_error(0);
+  }
+
+  long long int i;
+  for (i = 0; i < graph->vs[id].out_degree; i++) {
+    long long int out_edge_i = graph->vs[id].out_edges[i];
+    for (long long int j = 0; j < graph->vs[out_edge_i].in_degree; j++) {
+      long long int out_edge_i_in_edge_j = graph->vs[out_edge_i].in_edges[j];
+      if (graph->vs[out_edge_i_in_edge_j].timestamp > graph->vs[id].timestamp &&
+          graph->vs[out_edge_i_in_edge_j].timestamp <= (graph->vs[id].timestamp + time_delta) &&
+          !in_int_array(it, it_count, out_edge_i_in_edge_j)) {
+        add_to_int_array(&it, it_count, out_edge_i_in_edge_j, true);
+        it_count++;
+      }
+    }
+  }
+  for (i = 0; i < graph->vs[id].in_degree; i++) {
+    long long int in_edge_i = graph->vs[id].in_edges[i];
+    if (graph->vs[in_edge_i].timestamp > graph->vs[id].timestamp &&
+        graph->vs[in_edge_i].timestamp <= (graph->vs[id].timestamp + time_delta) &&
+        !in_int_array(it, it_count, in_edge_i)) {
+      add_to_int_array(&it, it_count, in_edge_i, true);
+      it_count++;
+    }
+  }
+
+  double sum_i = 0.0;
+  for (i = 0; i < it_count; i++) {
+    long long int f_it = in_id_array(graph->vs[it[i]].out_edges, graph->vs[it[i]].out_degree, id);
+    long long int b_it = 0;
+    for (long long int j = 0; j < graph->vs[it[i]].out_degree; j++) {
+      if (in_id_array(graph->vs[id].out_edges, graph->vs[id].out_degree, graph->vs[it[i]].out_edges[j])) {
+        b_it = 1;
+      }
+    }
+    sum_i += -2.0*f_it*b_it + f_it;
+  }
+
+  free(it);
+  return sum_i/it_count;
+}
+
+/**
+ * \function most_cited
+ * \brief Find the most cited vertices that also cite something.
+ *
+ * \param graph The input graph.
+ * \param ids Array to fill with the ids, most cited first.
+ * \param count The number of ids to find.
+ */
+static void most_cited(Graph *graph, long long int *ids, long long int count) {
+  for (long long int k = 0; k < count; k++) {
+    ids[k] = -1;
+    for (long long int i = 0; i < graph->vcount; i++) {
+      bool taken = in_int_array(ids, k, i);
+      if (!taken && graph->vs[i].out_degree > 0 &&
+          (ids[k] < 0 || graph->vs[i].in_degree > graph->vs[ids[k]].in_degree)) {
+        ids[k] = i;
+      }
+    }
+  }
+}
+
+/* a distribution of array sizes for the kernel microbenchmarks: sizes are
+   drawn from a power law with exponent 2 from min up to max if power_law is
+   set, and uniformly between min and max otherwise */
+typedef struct KernelSizes {
+  const char *name;
+  long long int min;
+  long long int max;
+  bool power_law;
+} KernelSizes;
+
+/**
+ * \function draw_size
+ * \brief Draw an array size from a distribution.
+ *
+ * \param sizes The distribution.
+ *
+ * \return The size.
+ */
+static long long int draw_size(const KernelSizes *sizes) {
+  if (sizes->power_law) {
+    double u = (random_int(1LL << 30) + 1) / (double) (1LL << 30);
+    long long int size = (long long int) (sizes->min / u);
+    return size < sizes->max ? size : sizes->max;
+  }
+  return sizes->min + random_int(sizes->max - sizes->min + 1);
+}
+
+/**
+ * \function fill_kernel_arrays
+ * \brief Fill a pool of sorted arrays of distinct ids for the kernel
+ *        microbenchmarks.
+ *
+ * The arrays are taken in pairs, and the ids of both arrays of a pair are
+ * spread over a range twice the product of their sizes, so the arrays of a
+ * pair have about half an id in common on average.
+ *
+ * \param sizes The distribution of the array sizes.
+ * \param count The number of arrays (even).
+ * \param offsets Filled with the array offsets (count + 1).
+ *
+ * \return The ids (free with free).
+ */
+static VertexId *fill_kernel_arrays(const KernelSizes *sizes, long long int count, long long int *offsets) {
+  offsets[0] = 0;
+  for (long long int i = 0; i < count; i++) {
+    offsets[i+1] = offsets[i] + draw_size(sizes);
+  }
+  VertexId *ids = malloc(offsets[count] * sizeof(VertexId));
+  if (ids==NULL) {
+    raise_error(0);
+  }
+  for (long long int i = 0; i < count; i += 2) {
+    long long int size_a = offsets[i+1] - offsets[i], size_b = offsets[i+2] - offsets[i+1];
+    long long int range = 2 * size_a * size_b;
+    for (long long int k = i; k < i + 2; k++) {
+      long long int size = offsets[k+1] - offsets[k];
+      long long int step = 2 * range / size > 1 ? 2 * range / size : 1;
+      long long int id = -1;
+      for (long long int j = 0; j < size; j++) {
+        id += 1 + random_int(step);
+        ids[offsets[k] + j] = id;
+      }
+    }
+  }
+  return ids;
+}
+
+/**
+ * \function benchmark_kernels
+ * \brief Time the membership and intersection kernels of every supported
+ *        instruction set on arrays of several size distributions.
+ *
+ * Half of the membership queries look for an id of the array (at a random
+ * position) and half for an absent id. The kernels in use before the call
+ * are restored afterwards.
+ *
+ * \return Whether every instruction set gave the same results.
+ */
+static bool benchmark_kernels(void) {
+  static const KernelSizes distributions[] = {
+    {"4-16", 4, 16, false},
+    {"16-64", 16, 64, false},
+    {"64-256", 64, 256, false},
+    {"256-1024", 256, 1024, false},
+    {"1024-4096", 1024, 4096, false},
+    {"power-law-4+", 4, 4096, true},
+  };
+  static const char *level_names[] = {"scalar", "avx2", "avx512"};
+  long long int distribution_count = sizeof(distributions) / sizeof(distributions[0]);
+  long long int max_count = 2048, work = 20000000;
+  int previous_level = simd_level(), supported = simd_supported_level();
+  bool matches = true;
+
+  long long int *offsets = malloc((max_count + 1) * sizeof(long long int));
+  long long int *queries = malloc(max_count * sizeof(long long int));
+  if (offsets==NULL || queries==NULL) {
+    raise_error(0);
+  }
+  printf("Kernels, ns per call (%s supported):\n", level_names[supported]);
+  printf("  %-28s", "");
+  for (int level = SIMD_SCALAR; level <= supported; level++) {
+    printf(" %9s", level_names[level]);
+  }
+  printf("\n");
+
+  for (long long int d = 0; d < distribution_count; d++) {
+    /* keep the arrays of the larger sizes within the cache */
+    long long int count = 2 * (1LL << 18) / (distributions[d].min + distributions[d].max) * 2;
+    count = count < max_count ? (count > 16 ? count : 16) : max_count;
+    VertexId *ids = fill_kernel_arrays(&distributions[d], count, offsets);
+    for (long long int i = 0; i < count; i++) {
+      long long int size = offsets[i+1] - offsets[i];
+      queries[i] = random_int(2) ? (long long int) ids[offsets[i] + random_int(size)] : -1;
+    }
+    long long int reps = work / offsets[count] > 1 ? work / offsets[count] : 1;
+
+    for (int kernel = 0; kernel < 2; kernel++) {
+      long long int expected = -1;
+      printf("  %-12s %-15s", kernel ? "intersect" : "membership", distributions[d].name);
+      for (int level = SIMD_SCALAR; level <= supported; level++) {
+        set_simd_level(level);
+        long long int found = 0;
+        double start = seconds_now();
+        for (long long int r = 0; r < reps; r++) {
+          for (long long int i = 0; i < count; i += 1 + kernel) {
+            VertexId *a = ids + offsets[i];
+            long long int size_a = offsets[i+1] - offsets[i];
+            found += kernel ? sorted_id_arrays_intersect(a, size_a, ids + offsets[i+1], offsets[i+2] - offsets[i+1])
+                            : in_id_array(a, size_a, queries[i]);
+          }
+        }
+        double seconds = seconds_now() - start;
+        double call_ns = 1e9 * seconds / (reps * (kernel ? count / 2 : count));
+        printf(" %9.1f", call_ns);
+        char name[64];
+        snprintf(name, sizeof(name), "kernel.%s.%s.%s", kernel ? "intersect" : "membership",
+                 distributions[d].name, level_names[level]);
+        record(name, call_ns, "ns");
+        matches = matches && (expected < 0 || found == expected);
+        expected = found;
+      }
+      printf("\n");
+    }
+    free(ids);
+  }
+
+  set_simd_level(previous_level);
+  printf("Kernel results agree: %s\n", matches ? "PASS" : "FAIL");
+  free(offsets);
+  free(queries);
+  return matches;
+}
+
+/**
+ * \function open_cache_miss_counter
+ * \brief Start counting the cache misses of the calling thread.
+ *
+ * \return The counter (read with read_cache_miss_counter), or -1 where the
+ *         hardware counters are not available, as in most virtual machines.
+ */
+static int open_cache_miss_counter(void) {
+#ifdef __linux__
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+  return -1;
+#endif
+}
+
+/**
+ * \function read_cache_miss_counter
+ * \brief Read and close a cache miss counter.
+ *
+ * \param counter The counter (-1 if it could not be opened).
+ *
+ * \return The number of cache misses since the counter was opened (NAN if
+ *         it is not available).
+ */
+static double read_cache_miss_counter(int counter) {
+  double misses = NAN;
+#ifdef __linux__
+  long long int count;
+  if (counter >= 0) {
+    if (read(counter, &count, sizeof(count)) == sizeof(count)) {
+      misses = count;
+    }
+    close(counter);
+  }
+#endif
+  return misses;
+}
+
+/**
+ * \function benchmark_orderings
+ * \brief Time all-vertex runs on frozen graphs that store the vertices in
+ *        each order, starting from ids in a random order.
+ *
+ * The generated graph has ids in time order, which already keeps citing
+ * vertices close together, so it is loaded again with its ids shuffled, as
+ * when papers are added in the order they were crawled. Where the hardware
+ * counters are available, the cache misses of each run are counted too.
+ *
+ * \param graph The generated graph.
+ * \param time_delta The time delta of the runs.
+ * \param expected The CD index of each vertex of the generated graph.
+ *
+ * \return Whether every order gave the expected results.
+ */
+static bool benchmark_orderings(Graph *graph, long long int time_delta, double *expected) {
+  static const char *order_names[] = {"ids", "time", "degree", "rcm"};
+  long long int vcount = graph->vcount;
+  long long int i, j;
+  bool matches = true;
+
+  /* shuffle the ids and load the shuffled graph */
+  long long int *shuffled = malloc(vcount * sizeof(long long int));
+  long long int *ids = malloc(vcount * sizeof(long long int));
+  long long int *timestamps = malloc(vcount * sizeof(long long int));
+  Edge *edges = malloc((graph->ecount > 0 ? graph->ecount : 1) * sizeof(Edge));
+  double *out = malloc(vcount * sizeof(double));
+  if (shuffled==NULL || ids==NULL || timestamps==NULL || edges==NULL || out==NULL) {
+    raise_error(0);
+  }
+  for (i = 0; i < vcount; i++) {
+    shuffled[i] = i;
+  }
+  for (i = vcount - 1; i > 0; i--) {
+    long long int other = random_int(i + 1);
+    long long int tmp = shuffled[i];
+    shuffled[i] = shuffled[other];
+    shuffled[other] = tmp;
+  }
+  long long int edge_count = 0;
+  for (i = 0; i < vcount; i++) {
+    ids[i] = i;
+    timestamps[shuffled[i]] = graph->vs[i].timestamp;
+    for (j = 0; j < graph->vs[i].out_degree; j++) {
+      edges[edge_count].source_id = shuffled[i];
+      edges[edge_count].target_id = shuffled[graph->vs[i].out_edges[j]];
+      edge_count++;
+    }
+  }
+  CREATE_GRAPH(scattered);
+  int error;
+  if (!bulk_load_graph(&scattered, vcount, ids, timestamps, edge_count, edges, &error)) {
+    raise_error(error);
+  }
+  free(timestamps);
+  free(edges);
+
+  printf("Vertex orders, all vertices from shuffled ids:\n");
+  for (int ordering = ORDER_IDS; ordering <= ORDER_RCM; ordering++) {
+    FrozenGraph frozen;
+    double start = seconds_now();
+    freeze_graph_ordered(&scattered, &frozen, false, ordering);
+    double freeze_seconds = seconds_now() - start;
+    int counter = open_cache_miss_counter();
+    start = seconds_now();
+    frozen_cdindex_batch(&frozen, ids, vcount, time_delta, out);
+    double seconds = seconds_now() - start;
+    double misses = read_cache_miss_counter(counter);
+    bool order_matches = true;
+    for (i = 0; i < vcount; i++) {
+      double value = out[shuffled[i]];
+      if (value != expected[i] && !(isnan(value) && isnan(expected[i]))) {
+        order_matches = false;
+      }
+    }
+    printf("  %-7s frozen in %.3f s, cdindex %.3f s (%.0f vertices/s), ",
+           order_names[ordering], freeze_seconds, seconds, vcount / seconds);
+    if (isnan(misses)) {
+      printf("cache misses unavailable\n");
+    }
+    else {
+      printf("%.2f cache misses per vertex\n", misses / vcount);
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "order.%s.freeze", order_names[ordering]);
+    record(name, freeze_seconds, "s");
+    snprintf(name, sizeof(name), "order.%s.cdindex", order_names[ordering]);
+    record(name, seconds, "s");
+    snprintf(name, sizeof(name), "order.%s.cache_misses", order_names[ordering]);
+    record(name, misses, "count");
+    matches = matches && order_matches;
+    free_frozen_graph(&frozen);
+  }
+  printf("Reordered results match batch: %s\n", matches ? "PASS" : "FAIL");
+
+  free_graph(&scattered);
+  free(shuffled);
+  free(ids);
+  free(out);
+  return matches;
+}
+
+/**
+ * \function benchmark_views
+ * \brief Time sweeps of views of a frozen graph at several cutoffs against rebuilding it.
+ *
+ * At each cutoff, the CD index of every vertex is swept once on a view of
+ * the frozen graph and once on a graph rebuilt from the vertices up to the
+ * cutoff and frozen, as a backtest without views would. The generated ids
+ * are in time order, so the vertices up to a cutoff are a prefix of them.
+ *
+ * \param graph The generated graph.
+ * \param frozen The graph frozen with its in edges ordered by time.
+ * \param time_delta The time delta of the sweeps.
+ * \param cutoffs The number of cutoffs, spread evenly over the timestamps.
+ *
+ * \return Whether every view gave the results of the rebuilt graph.
+ */
+static bool benchmark_views(Graph *graph, FrozenGraph *frozen, long long int time_delta, int cutoffs) {
+  long long int vcount = graph->vcount;
+  long long int last = vcount > 0 ? graph->vs[vcount-1].timestamp : 0;
+  double *view_out = malloc((vcount > 0 ? vcount : 1) * sizeof(double));
+  double *rebuilt_out = malloc((vcount > 0 ? vcount : 1) * sizeof(double));
+  if (view_out==NULL || rebuilt_out==NULL) {
+    raise_error(0);
+  }
+  bool matches = true;
+  double view_seconds = 0.0, rebuilt_seconds = 0.0;
+
+  for (int c = 1; c <= cutoffs; c++) {
+    GraphView view = {NULL, frozen, NULL, last * c / cutoffs};
+    double start = seconds_now();
+    view_cdindex_all(&view, &time_delta, 1, view_out);
+    view_seconds += seconds_now() - start;
+
+    start = seconds_now();
+    CREATE_GRAPH(rebuilt);
+    for (long long int i = 0; i < vcount && graph->vs[i].timestamp <= view.cutoff; i++) {
+      add_vertex(&rebuilt, i, graph->vs[i].timestamp);
+      for (long long int j = 0; j < graph->vs[i].out_degree; j++) {
+        add_edge(&rebuilt, i, graph->vs[i].out_edges[j]);
+      }
+    }
+    FrozenGraph rebuilt_frozen;
+    freeze_graph_by_time(&rebuilt, &rebuilt_frozen);
+    frozen_cdindex_all(&rebuilt_frozen, &time_delta, 1, rebuilt_out);
+    rebuilt_seconds += seconds_now() - start;
+
+    for (long long int i = 0; i < vcount; i++) {
+      double expected = i < rebuilt.vcount ? rebuilt_out[i] : NAN;
+      if (view_out[i] != expected && !(isnan(view_out[i]) && isnan(expected))) {
+        matches = false;
+      }
+    }
+    free_frozen_graph(&rebuilt_frozen);
+    free_graph(&rebuilt);
+  }
+
+  printf("As-of views, all vertices at %d cutoffs: %.3f s vs %.3f s rebuilding (%.1fx)\n",
+         cutoffs, view_seconds, rebuilt_seconds, rebuilt_seconds / view_seconds);
+  record("view.sweeps", view_seconds, "s");
+  record("view.rebuilt_sweeps", rebuilt_seconds, "s");
+  printf("View results match rebuilt graphs: %s\n", matches ? "PASS" : "FAIL");
+  free(view_out);
+  free(rebuilt_out);
+  return matches;
+}
+
+/**
+ * \function usage
+ * \brief Print the options of the benchmark.
+ *
+ * \param program The name of the program.
+ */
+static void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [options] [vertices [refs [focal [threads [snapshot]]]]]\n"
+          "  --vertices N            vertices in the generated graph (100000)\n"
+          "  --periods N             distinct timestamps (50)\n"
+          "  --refs X                mean references per vertex (20)\n"
+          "  --refs-distribution D   fixed, geometric or power-law (fixed)\n"
+          "  --refs-exponent X       power law exponent, above 2 (2.5)\n"
+          "  --max-refs N            most references per vertex (1000)\n"
+          "  --attachment P          share of preferential references (0.8)\n"
+          "  --recency P             share of other references to recent periods (0)\n"
+          "  --window N              periods counted as recent (5)\n"
+          "  --seed N                random seed\n"
+          "  --focal N               most cited vertices timed one by one (5)\n"
+          "  --threads N             threads of the parallel runs (0: all cores)\n"
+          "  --snapshot PATH         snapshot file (/tmp/cdindex_benchmark.cdg)\n"
+          "  --json PATH             write the results as JSON\n",
+          program);
+}
+
+int main(int argc, char *argv[]) {
+
+  /* benchmark parameters */
+  static const struct option long_options[] = {
+    {"vertices", required_argument, NULL, 'n'},
+    {"periods", required_argument, NULL, 'p'},
+    {"refs", required_argument, NULL, 'r'},
+    {"refs-distribution", required_argument, NULL, 'd'},
+    {"refs-exponent", required_argument, NULL, 'e'},
+    {"max-refs", required_argument, NULL, 'm'},
+    {"attachment", required_argument, NULL, 'a'},
+    {"recency", required_argument, NULL, 'c'},
+    {"window", required_argument, NULL, 'w'},
+    {"seed", required_argument, NULL, 's'},
+    {"focal", required_argument, NULL, 'f'},
+    {"threads", required_argument, NULL, 't'},
+    {"snapshot", required_argument, NULL, 'o'},
+    {"json", required_argument, NULL, 'j'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+  GeneratorOptions options;
+  default_generator_options(&options);
+  long long int focal_count = 5;
+  int threads = 0;
+  const char *snapshot_path = "/tmp/cdindex_benchmark.cdg";
+  const char *json_path = NULL;
+  int option;
+  while ((option = getopt_long(argc, argv, "n:p:r:d:e:m:a:c:w:s:f:t:o:j:h", long_options, NULL)) != -1) {
+    switch (option) {
+      case 'n': options.vcount = atoll(optarg); break;
+      case 'p': options.periods = atoll(optarg); break;
+      case 'r': options.mean_refs = atof(optarg); break;
+      case 'd':
+        if (strcmp(optarg, "fixed") == 0) {
+          options.refs_distribution = REFS_FIXED;
+        }
+        else if (strcmp(optarg, "geometric") == 0) {
+          options.refs_distribution = REFS_GEOMETRIC;
+        }
+        else if (strcmp(optarg, "power-law") == 0) {
+          options.refs_distribution = REFS_POWER_LAW;
+        }
+        else {
+          usage(argv[0]);
+          return 2;
+        }
+        break;
+      case 'e': options.refs_exponent = atof(optarg); break;
+      case 'm': options.max_refs = atoll(optarg); break;
+      case 'a': options.attachment = atof(optarg); break;
+      case 'c': options.recency = atof(optarg); break;
+      case 'w': options.window = atoll(optarg); break;
+      case 's': options.seed = strtoull(optarg, NULL, 10); break;
+      case 'f': focal_count = atoll(optarg); break;
+      case 't': threads = atoi(optarg); break;
+      case 'o': snapshot_path = optarg; break;
+      case 'j': json_path = optarg; break;
+      default:
+        usage(argv[0]);
+        return option == 'h' ? 0 : 2;
+    }
+  }
+
+  /* positional arguments, as before the options existed */
+  if (optind < argc) options.vcount = atoll(argv[optind++]);
+  if (optind < argc) options.mean_refs = atof(argv[optind++]);
+  if (optind < argc) focal_count = atoll(argv[optind++]);
+  if (optind < argc) threads = atoi(argv[optind++]);
+  if (optind < argc) snapshot_path = argv[optind++];
+  if (options.vcount < 1 || options.mean_refs < 0 || options.max_refs < 0 || focal_count < 0 ||
+      (options.refs_distribution == REFS_POWER_LAW && options.refs_exponent <= 2.0)) {
+    usage(argv[0]);
+    return 2;
+  }
+  long long int time_delta = 50;
+  long long int all_time_delta = 5;
+
+  /* generate the graph, then time loading it */
+  double start = seconds_now();
+  long long int *ids = malloc(options.vcount * sizeof(long long int));
+  long long int *timestamps = malloc(options.vcount * sizeof(long long int));
+  if (ids==NULL || timestamps==NULL) {
+    raise_error(0);
+  }
+  Edge *edges;
+  long long int edge_count;
+  generate_citations(&options, timestamps, &edges, &edge_count);
+  for (long long int i = 0; i < options.vcount; i++) {
+    ids[i] = i;
+  }
+  double generate_seconds = seconds_now() - start;
+  CREATE_GRAPH(g);
+  int error;
+  start = seconds_now();
+  if (!bulk_load_graph(&g, options.vcount, ids, timestamps, edge_count, edges, &error)) {
+    raise_error(error);
+  }
+  double load_seconds = seconds_now() - start;
+  free(ids);
+  free(timestamps);
+  free(edges);
+  long long int max_in_degree = 0;
+  for (long long int i = 0; i < g.vcount; i++) {
+    max_in_degree = g.vs[i].in_degree > max_in_degree ? g.vs[i].in_degree : max_in_degree;
+  }
+  long long int graph_used, graph_reserved;
+  graph_memory_usage(&g, &graph_used, &graph_reserved);
+  printf("Generated graph: %lld vertices, %lld edges (max in degree %lld) in %.3f s, bulk loaded in %.3f s\n",
+         g.vcount, g.ecount, max_in_degree, generate_seconds, load_seconds);
+  record("graph.vertices", g.vcount, "count");
+  record("graph.edges", g.ecount, "count");
+  record("graph.max_in_degree", max_in_degree, "count");
+  record("graph.generate", generate_seconds, "s");
+  record("graph.bulk_load", load_seconds, "s");
+  record("graph.memory_used", graph_used, "bytes");
+  record("memory.peak_after_load", peak_memory(), "bytes");
+
+  /* time rebuilding the graph one vertex and one edge at a time, with edge
+     arrays from malloc and from an arena, and time tearing it down */
+  for (int use_arena = 0; use_arena < 2; use_arena++) {
+    CREATE_GRAPH(incremental);
+    if (use_arena) {
+      graph_use_arena(&incremental);
+    }
+    start = seconds_now();
+    for (long long int i = 0; i < g.vcount; i++) {
+      add_vertex(&incremental, i, g.vs[i].timestamp);
+      for (long long int j = 0; j < g.vs[i].out_degree; j++) {
+        add_edge(&incremental, i, g.vs[i].out_edges[j]);
+      }
+    }
+    double build_seconds = seconds_now() - start;
+    long long int used, reserved;
+    graph_memory_usage(&incremental, &used, &reserved);
+    start = seconds_now();
+    free_graph(&incremental);
+    double free_seconds = seconds_now() - start;
+    printf("Incremental build (%s): %.3f s, free %.4f s, %.1f MB used, %.1f MB reserved\n",
+           use_arena ? "arena" : "malloc", build_seconds, free_seconds,
+           used / 1048576.0, reserved / 1048576.0);
+    record(use_arena ? "incremental.arena.build" : "incremental.malloc.build", build_seconds, "s");
+    record(use_arena ? "incremental.arena.free" : "incremental.malloc.free", free_seconds, "s");
+    record(use_arena ? "incremental.arena.reserved" : "incremental.malloc.reserved", reserved, "bytes");
+  }
+
+  /* time the heavily cited focal vertices with both implementations */
+  long long int *focal = malloc(focal_count * sizeof(long long int));
+  if (focal==NULL) {
+    raise_error(0);
+  }
+  most_cited(&g, focal, focal_count);
+  bool matches = true;
+  double reference_total = 0.0, cdindex_total = 0.0;
+  for (long long int k = 0; k < focal_count; k++) {
+    start = seconds_now();
+    double expected = reference_cdindex(&g, focal[k], time_delta);
+    double reference_seconds = seconds_now() - start;
+    start = seconds_now();
+    double actual = cdindex(&g, focal[k], time_delta);
+    double cdindex_seconds = seconds_now() - start;
+    if (expected != actual && !(isnan(expected) && isnan(actual))) {
+      matches = false;
+    }
+    reference_total += reference_seconds;
+    cdindex_total += cdindex_seconds;
+    printf("vertex %-8lld in degree %-8lld cd index %9.6f  reference %.6f s  cdindex %.6f s\n",
+           focal[k], g.vs[focal[k]].in_degree, actual, reference_seconds, cdindex_seconds);
+  }
+  printf("Results match reference: %s\n", matches ? "PASS" : "FAIL");
+  printf("Speedup over reference: %.1fx\n", reference_total / cdindex_total);
+  record("focal.reference", reference_total, "s");
+  record("focal.cdindex", cdindex_total, "s");
+  record("focal.speedup", reference_total / cdindex_total, "x");
+
+  /* time single calls on a sample of vertices, most of them lightly cited */
+  long long int sample_count = g.vcount < 10000 ? g.vcount : 10000;
+  double sample_sum = 0.0;
+  start = seconds_now();
+  for (long long int k = 0; k < sample_count; k++) {
+    double value = cdindex(&g, random_int(g.vcount), time_delta);
+    sample_sum += isnan(value) ? 0.0 : value;
+  }
+  double sample_seconds = seconds_now() - start;
+  printf("Single vertex: %.2f us per cdindex call over %lld random vertices (sum %.3f)\n",
+         1e6 * sample_seconds / sample_count, sample_count, sample_sum);
+  record("single.cdindex", 1e6 * sample_seconds / sample_count, "us");
+
+  /* time every vertex with one thread and with the parallel engine, over a
+     five period horizon */
+  long long int *all = malloc(g.vcount * sizeof(long long int));
+  double *batch_out = malloc(g.vcount * sizeof(double));
+  double *parallel_out = malloc(g.vcount * sizeof(double));
+  if (all==NULL || batch_out==NULL || parallel_out==NULL) {
+    raise_error(0);
+  }
+  for (long long int i = 0; i < g.vcount; i++) {
+    all[i] = i;
+  }
+  start = seconds_now();
+  cdindex_batch(&g, all, g.vcount, all_time_delta, batch_out);
+  double batch_seconds = seconds_now() - start;
+  start = seconds_now();
+  parallel_cdindex(&g, NULL, 0, all_time_delta, threads, parallel_out);
+  double parallel_seconds = seconds_now() - start;
+  bool parallel_matches = true;
+  for (long long int i = 0; i < g.vcount; i++) {
+    if (batch_out[i] != parallel_out[i] && !(isnan(batch_out[i]) && isnan(parallel_out[i]))) {
+      parallel_matches = false;
+    }
+  }
+  printf("All vertices: batch %.3f s, parallel %.3f s (%.1fx)\n",
+         batch_seconds, parallel_seconds, batch_seconds / parallel_seconds);
+  record("batch.cdindex", batch_seconds, "s");
+  record("parallel.cdindex", parallel_seconds, "s");
+  printf("Parallel results match batch: %s\n", parallel_matches ? "PASS" : "FAIL");
+  matches = matches && parallel_matches;
+
+  /* time every horizon up to five periods in one pass and one per call */
+  long long int multi_deltas[] = {1, 2, 3, 4, 5};
+  long long int multi_k = 5;
+  double *multi_out = malloc(g.vcount * multi_k * sizeof(double));
+  if (multi_out==NULL) {
+    raise_error(0);
+  }
+  start = seconds_now();
+  for (long long int h = 0; h < multi_k; h++) {
+    cdindex_batch(&g, all, g.vcount, multi_deltas[h], batch_out);
+  }
+  double single_seconds = seconds_now() - start;
+  start = seconds_now();
+  cdindex_multi_batch(&g, all, g.vcount, multi_deltas, multi_k, multi_out);
+  double multi_seconds = seconds_now() - start;
+  bool multi_matches = true;
+  for (long long int i = 0; i < g.vcount; i++) {
+    double expected = multi_out[i * multi_k + multi_k - 1];
+    if (batch_out[i] != expected && !(isnan(batch_out[i]) && isnan(expected))) {
+      multi_matches = false;
+    }
+  }
+  printf("All vertices at %lld horizons: one per call %.3f s, multi-horizon %.3f s (%.1fx)\n",
+         multi_k, single_seconds, multi_seconds, single_seconds / multi_seconds);
+  record("multi.one_per_call", single_seconds, "s");
+  record("multi.cdindex", multi_seconds, "s");
+  printf("Multi-horizon results match batch: %s\n", multi_matches ? "PASS" : "FAIL");
+  matches = matches && multi_matches;
+
+  /* compute the same horizons for every vertex in one sweep over the citers,
+     on the graph and on a frozen copy with time-ordered in edges */
+  FrozenGraph sweep_frozen;
+  freeze_graph_by_time(&g, &sweep_frozen);
+  double *sweep_out = malloc(g.vcount * multi_k * sizeof(double));
+  double *frozen_sweep_out = malloc(g.vcount * multi_k * sizeof(double));
+  if (sweep_out==NULL || frozen_sweep_out==NULL) {
+    raise_error(0);
+  }
+  start = seconds_now();
+  cdindex_all(&g, multi_deltas, multi_k, sweep_out);
+  double sweep_seconds = seconds_now() - start;
+  start = seconds_now();
+  frozen_cdindex_multi_batch(&sweep_frozen, all, g.vcount, multi_deltas, multi_k, frozen_sweep_out);
+  double frozen_multi_seconds = seconds_now() - start;
+  start = seconds_now();
+  frozen_cdindex_all(&sweep_frozen, multi_deltas, multi_k, frozen_sweep_out);
+  double frozen_sweep_seconds = seconds_now() - start;
+  bool sweep_matches = true;
+  for (long long int i = 0; i < g.vcount * multi_k; i++) {
+    if ((sweep_out[i] != multi_out[i] && !(isnan(sweep_out[i]) && isnan(multi_out[i]))) ||
+        (frozen_sweep_out[i] != multi_out[i] && !(isnan(frozen_sweep_out[i]) && isnan(multi_out[i])))) {
+      sweep_matches = false;
+    }
+  }
+  printf("All vertices at %lld horizons in one sweep: %.3f s (%.1fx multi-horizon); "
+         "frozen by time %.3f s vs %.3f s multi-horizon (%.1fx)\n",
+         multi_k, sweep_seconds, multi_seconds / sweep_seconds,
+         frozen_sweep_seconds, frozen_multi_seconds, frozen_multi_seconds / frozen_sweep_seconds);
+  record("sweep.cdindex", sweep_seconds, "s");
+  record("sweep.frozen_by_time", frozen_sweep_seconds, "s");
+  record("sweep.frozen_by_time_multi", frozen_multi_seconds, "s");
+  printf("Sweep results match multi-horizon: %s\n", sweep_matches ? "PASS" : "FAIL");
+  matches = matches && sweep_matches;
+  free(sweep_out);
+  free(frozen_sweep_out);
+  free_frozen_graph(&sweep_frozen);
+
+  /* rebuild the graph one vertex at a time with streaming updates */
+  CREATE_GRAPH(streamed);
+  Stream stream;
+  init_stream(&stream, &streamed, multi_deltas, multi_k);
+  long long int max_out_degree = 1;
+  for (long long int i = 0; i < g.vcount; i++) {
+    max_out_degree = g.vs[i].out_degree > max_out_degree ? g.vs[i].out_degree : max_out_degree;
+  }
+  long long int *stream_refs = malloc(max_out_degree * sizeof(long long int));
+  start = seconds_now();
+  for (long long int i = 0; i < g.vcount; i++) {
+    for (long long int j = 0; j < g.vs[i].out_degree; j++) {
+      stream_refs[j] = g.vs[i].out_edges[j];
+    }
+    stream_add_vertex(&stream, i, g.vs[i].timestamp, stream_refs, g.vs[i].out_degree);
+  }
+  double stream_seconds = seconds_now() - start;
+  free(stream_refs);
+  bool stream_matches = true;
+  for (long long int i = 0; i < g.vcount; i++) {
+    for (long long int h = 0; h < multi_k; h++) {
+      double expected = multi_out[i * multi_k + h];
+      double actual = stream_cdindex(&stream, i, h);
+      if (actual != expected && !(isnan(actual) && isnan(expected))) {
+        stream_matches = false;
+      }
+    }
+  }
+  printf("Streaming: %lld vertices added in %.3f s (%.1f us per vertex)\n",
+         g.vcount, stream_seconds, 1e6 * stream_seconds / g.vcount);
+  record("stream.add_all", stream_seconds, "s");
+  printf("Streamed results match multi-horizon: %s\n", stream_matches ? "PASS" : "FAIL");
+  matches = matches && stream_matches;
+  free_stream(&stream);
+  free_graph(&streamed);
+  free(multi_out);
+
+  /* time freezing, saving and mapping a snapshot, and check the mapped graph */
+  FrozenGraph frozen, mapped;
+  start = seconds_now();
+  freeze_graph(&g, &frozen);
+  double freeze_seconds = seconds_now() - start;
+  start = seconds_now();
+  if (!save_frozen_graph(&frozen, snapshot_path, &error)) {
+    raise_error(error);
+  }
+  double save_seconds = seconds_now() - start;
+  start = seconds_now();
+  if (!map_frozen_graph(&mapped, snapshot_path, &error)) {
+    raise_error(error);
+  }
+  double map_seconds = seconds_now() - start;
+  frozen_cdindex_batch(&mapped, all, g.vcount, all_time_delta, parallel_out);
+  bool snapshot_matches = true;
+  for (long long int i = 0; i < g.vcount; i++) {
+    if (batch_out[i] != parallel_out[i] && !(isnan(batch_out[i]) && isnan(parallel_out[i]))) {
+      snapshot_matches = false;
+    }
+  }
+  printf("Snapshot: freeze %.3f s, save %.3f s, map %.6f s\n", freeze_seconds, save_seconds, map_seconds);
+  record("frozen.freeze", freeze_seconds, "s");
+  record("snapshot.save", save_seconds, "s");
+  record("snapshot.map", map_seconds, "s");
+  printf("Mapped snapshot results match batch: %s\n", snapshot_matches ? "PASS" : "FAIL");
+  matches = matches && snapshot_matches;
+
+  /* compare the size and speed of a compressed graph with the frozen one; the
+     I index of every vertex scans every in list, so it times decoding alone */
+  CompressedGraph compressed;
+  start = seconds_now();
+  compress_graph(&g, &compressed);
+  double compress_seconds = seconds_now() - start;
+  long long int frozen_bytes = g.vcount * sizeof(Timestamp) + 2 * (g.vcount + 1) * sizeof(long long int) +
+                               2 * g.ecount * sizeof(VertexId);
+  long long int compressed_bytes = compressed_graph_memory(&compressed);
+  long long int *frozen_iindex_out = malloc(g.vcount * sizeof(long long int));
+  long long int *compressed_iindex_out = malloc(g.vcount * sizeof(long long int));
+  start = seconds_now();
+  frozen_iindex_batch(&frozen, all, g.vcount, all_time_delta, frozen_iindex_out);
+  double frozen_scan_seconds = seconds_now() - start;
+  start = seconds_now();
+  compressed_iindex_batch(&compressed, all, g.vcount, all_time_delta, compressed_iindex_out);
+  double compressed_scan_seconds = seconds_now() - start;
+  start = seconds_now();
+  frozen_cdindex_batch(&frozen, all, g.vcount, all_time_delta, parallel_out);
+  double frozen_seconds = seconds_now() - start;
+  start = seconds_now();
+  compressed_cdindex_batch(&compressed, all, g.vcount, all_time_delta, parallel_out);
+  double compressed_seconds = seconds_now() - start;
+  bool compressed_matches = true;
+  for (long long int i = 0; i < g.vcount; i++) {
+    if ((batch_out[i] != parallel_out[i] && !(isnan(batch_out[i]) && isnan(parallel_out[i]))) ||
+        frozen_iindex_out[i] != compressed_iindex_out[i]) {
+      compressed_matches = false;
+    }
+  }
+  printf("Compressed: %.1f MB vs %.1f MB frozen (%.2fx smaller, %.2f bytes per edge), built in %.3f s\n",
+         compressed_bytes / 1e6, frozen_bytes / 1e6, (double) frozen_bytes / compressed_bytes,
+         (double) (compressed.in_offsets[g.vcount] + compressed.out_offsets[g.vcount]) / (2.0 * g.ecount),
+         compress_seconds);
+  printf("Decode: %.0f M edges/s (frozen scan %.0f M edges/s)\n",
+         g.ecount / compressed_scan_seconds / 1e6, g.ecount / frozen_scan_seconds / 1e6);
+  printf("All vertices: frozen batch %.3f s, compressed batch %.3f s (%.2fx)\n",
+         frozen_seconds, compressed_seconds, compressed_seconds / frozen_seconds);
+  record("frozen.bytes", frozen_bytes, "bytes");
+  record("frozen.cdindex", frozen_seconds, "s");
+  record("frozen.iindex", frozen_scan_seconds, "s");
+  record("compressed.bytes", compressed_bytes, "bytes");
+  record("compressed.build", compress_seconds, "s");
+  record("compressed.cdindex", compressed_seconds, "s");
+  record("compressed.iindex", compressed_scan_seconds, "s");
+  printf("Compressed results match batch: %s\n", compressed_matches ? "PASS" : "FAIL");
+  matches = matches && compressed_matches;
+  free_compressed_graph(&compressed);
+
+  /* compare the frozen graph with one whose in edges are ordered by time,
+     on which a short horizon only touches the citers in its window */
+  FrozenGraph by_time;
+  start = seconds_now();
+  freeze_graph_by_time(&g, &by_time);
+  double by_time_freeze_seconds = seconds_now() - start;
+  start = seconds_now();
+  frozen_iindex_batch(&by_time, all, g.vcount, all_time_delta, compressed_iindex_out);
+  double by_time_scan_seconds = seconds_now() - start;
+  start = seconds_now();
+  frozen_cdindex_batch(&by_time, all, g.vcount, all_time_delta, parallel_out);
+  double by_time_seconds = seconds_now() - start;
+  bool by_time_matches = true;
+  for (long long int i = 0; i < g.vcount; i++) {
+    if ((batch_out[i] != parallel_out[i] && !(isnan(batch_out[i]) && isnan(parallel_out[i]))) ||
+        frozen_iindex_out[i] != compressed_iindex_out[i]) {
+      by_time_matches = false;
+    }
+  }
+  printf("Time-ordered in edges: frozen in %.3f s; iindex %.4f s vs %.4f s, cdindex %.3f s vs %.3f s (%.2fx)\n",
+         by_time_freeze_seconds, by_time_scan_seconds, frozen_scan_seconds,
+         by_time_seconds, frozen_seconds, frozen_seconds / by_time_seconds);
+  record("by_time.freeze", by_time_freeze_seconds, "s");
+  record("by_time.cdindex", by_time_seconds, "s");
+  record("by_time.iindex", by_time_scan_seconds, "s");
+  printf("Time-ordered results match batch: %s\n", by_time_matches ? "PASS" : "FAIL");
+  matches = matches && by_time_matches;
+
+  /* estimate the heavily cited focal vertices from samples of their citers */
+  double exact_total = 0.0, estimate_total = 0.0;
+  long long int covered = 0;
+  for (long long int k = 0; k < focal_count; k++) {
+    start = seconds_now();
+    double exact = frozen_cdindex(&by_time, focal[k], time_delta);
+    exact_total += seconds_now() - start;
+    CDEstimate estimate;
+    start = seconds_now();
+    frozen_cdindex_estimate(&by_time, focal[k], time_delta, 0.01, 0.95, 0, k + 1, &estimate);
+    estimate_total += seconds_now() - start;
+    covered += (estimate.lower <= exact && exact <= estimate.upper) || (isnan(exact) && isnan(estimate.cdindex));
+  }
+  printf("Sampled estimates of the focal vertices (tolerance 0.01): %.4f s vs %.4f s exact (%.1fx), "
+         "%lld of %lld intervals cover the exact value\n",
+         estimate_total, exact_total, exact_total / estimate_total, covered, focal_count);
+  record("estimate.focal", estimate_total, "s");
+  record("estimate.focal_exact", exact_total, "s");
+  record("estimate.covered", covered, "count");
+
+  /* sweep the graph as of several cutoffs without rebuilding it */
+  matches = benchmark_views(&g, &by_time, all_time_delta, 10) && matches;
+  free_frozen_graph(&by_time);
+
+  /* time the vertex orders of frozen graphs */
+  matches = benchmark_orderings(&g, all_time_delta, batch_out) && matches;
+
+  /* time the membership and intersection kernels of each instruction set */
+  matches = benchmark_kernels() && matches;
+  free(frozen_iindex_out);
+  free(compressed_iindex_out);
+  free_frozen_graph(&mapped);
+  free_frozen_graph(&frozen);
+  remove(snapshot_path);
+  free(all);
+  free(batch_out);
+  free(parallel_out);
+
+  free(focal);
+  free_thread_scratch();
+  free_graph(&g);
+
+  /* report the counters of every computation above when they are built in */
+  if (stats_enabled()) {
+    IndexStats *stats = malloc(sizeof(IndexStats));
+    if (stats==NULL) {
+      raise_error(0);
+    }
+    get_stats(stats);
+    printf("Stats: %lld calls, %.1f in edges scanned and %.1f in window per call, "
+           "it size p50 %.0f p99 %.0f, %.1f us p50 %.1f us p99\n",
+           stats->calls, (double) stats->in_edges_scanned / stats->calls,
+           (double) stats->in_edges_in_window / stats->calls,
+           stats_percentile(stats->it_histogram, 0.5), stats_percentile(stats->it_histogram, 0.99),
+           stats_percentile(stats->time_histogram, 0.5) / 1e3, stats_percentile(stats->time_histogram, 0.99) / 1e3);
+    record("stats.calls", stats->calls, "count");
+    record("stats.vertices_visited", stats->vertices_visited, "count");
+    record("stats.in_edges_scanned", stats->in_edges_scanned, "count");
+    record("stats.in_edges_in_window", stats->in_edges_in_window, "count");
+    record("stats.it_vertices", stats->it_vertices, "count");
+    record("stats.membership_probes", stats->membership_probes, "count");
+    record("stats.it_p50", stats_percentile(stats->it_histogram, 0.5), "count");
+    record("stats.it_p99", stats_percentile(stats->it_histogram, 0.99), "count");
+    record("stats.call_p50", stats_percentile(stats->time_histogram, 0.5), "ns");
+    record("stats.call_p99", stats_percentile(stats->time_histogram, 0.99), "ns");
+    free(stats);
+  }
+
+  record("memory.peak", peak_memory(), "bytes");
+  printf("Peak memory: %.1f MB\n", peak_memory() / 1048576.0);
+  if (json_path != NULL && !write_results(json_path, &options, threads, matches)) {
+    perror(json_path);
+    return 1;
+  }
+  return matches ? 0 : 1;
+}
@@ -18,8 +18,227 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
 #include "cdindex.h"
 
+/**
+ * \function add_it_vertex
+ * \brief Add a vertex to the "it" list of a scratch, unless it is already there.
+ *
+ * \param scratch The scratch holding the list.
+ * \param it_count The size of the list (incremented if the vertex is added).
+ * \param id The vertex id.
+ */
+static inline void add_it_vertex(Scratch *scratch, long long int *it_count, long long int id) {
+  unsigned long long int bit = 1ULL << (id & 63);
+  if (!(scratch->visited[id >> 6] & bit)) {
+    scratch->visited[id >> 6] |= bit;
+    if (*it_count == scratch->it_capacity) {
+      long long int *tmp = realloc(scratch->it, 2 * scratch->it_capacity * sizeof(long long int));
+      if (tmp==NULL) {
+        raise_error(0);
+      }
+      scratch->it = tmp;
+      scratch->it_capacity *= 2;
+    }
+    scratch->it[(*it_count)++] = id;
+  }
+}
+
+/**
+ * \function clear_it_vertices
+ * \brief Clear the visited bits of the "it" list of a scratch.
+ *
+ * Whole words are zeroed, since every bit set in the bitset belongs to a
+ * vertex in the list.
+ *
+ * \param scratch The scratch holding the list.
+ * \param it_count The size of the list.
+ */
+static inline void clear_it_vertices(Scratch *scratch, long long int it_count) {
+  for (long long int i = 0; i < it_count; i++) {
+    scratch->visited[scratch->it[i] >> 6] = 0;
+  }
+}
+
+/**
+ * \function max_time_delta
+ * \brief Find the longest of several time deltas.
+ *
+ * \param time_deltas The time deltas.
+ * \param k The number of time deltas (at least 1).
+ *
+ * \return The longest time delta.
+ */
+static inline long long int max_time_delta(long long int *time_deltas, long long int k) {
+  long long int max_delta = time_deltas[0];
+  for (long long int h = 1; h < k; h++) {
+    if (time_deltas[h] > max_delta) {
+      max_delta = time_deltas[h];
+    }
+  }
+  return max_delta;
+}
+
+/**
+ * \function start_horizons
+ * \brief Zero the components of every horizon.
+ *
+ * \param k The number of horizons.
+ * \param horizons The components of each horizon.
+ */
+static inline void start_horizons(long long int k, CDComponents *horizons) {
+  memset(horizons, 0, k * sizeof(CDComponents));
+}
+
+/**
+ * \function add_to_horizons
+ * \brief Count an "it" vertex in every horizon it falls within.
+ *
+ * \param f_it Whether the "it" vertex cites the focal vertex.
+ * \param b_it Whether it also cites one of the focal vertex's "out_edges".
+ * \param delay How long after the focal vertex the "it" vertex appeared.
+ * \param time_deltas The time deltas of the horizons.
+ * \param k The number of horizons.
+ * \param horizons The components of each horizon.
+ */
+static inline void add_to_horizons(long long int f_it, long long int b_it, long long int delay, long long int *time_deltas, long long int k, CDComponents *horizons) {
+  for (long long int h = 0; h < k; h++) {
+    if (delay <= time_deltas[h]) {
+      if (!f_it) {
+        horizons[h].n_r++;
+      }
+      else if (b_it) {
+        horizons[h].n_b++;
+      }
+      else {
+        horizons[h].n_f++;
+      }
+    }
+  }
+}
+
+/**
+ * \function add_citer_to_horizons
+ * \brief Count a citer of the focal vertex in the I index of every horizon it falls within.
+ *
+ * \param delay How long after the focal vertex the citer appeared (citers
+ *              that are not later than the focal vertex count everywhere).
+ * \param time_deltas The time deltas of the horizons.
+ * \param k The number of horizons.
+ * \param horizons The components of each horizon.
+ */
+static inline void add_citer_to_horizons(long long int delay, long long int *time_deltas, long long int k, CDComponents *horizons) {
+  for (long long int h = 0; h < k; h++) {
+    if (delay <= time_deltas[h]) {
+      horizons[h].iindex++;
+    }
+  }
+}
+
+/**
+ * \function finish_horizons
+ * \brief Compute the CD and mCD index of each horizon from its counts.
+ *
+ * \param k The number of horizons.
+ * \param horizons The components of each horizon (NAN indices for empty horizons).
+ */
+static inline void finish_horizons(long long int k, CDComponents *horizons) {
+  for (long long int h = 0; h < k; h++) {
+    long long int it_count = horizons[h].n_f + horizons[h].n_b + horizons[h].n_r;
+    horizons[h].cdindex = it_count > 0 ? (double) (horizons[h].n_f - horizons[h].n_b)/it_count : NAN;
+    horizons[h].mcdindex = horizons[h].cdindex * horizons[h].iindex;
+  }
+}
+
+/**
+ * \function first_after
+ * \brief Find the first in edge of a time-ordered list that is later than a time.
+ *
+ * \param times The in edge timestamps of a frozen graph.
+ * \param lo The start of the list.
+ * \param hi The end of the list.
+ * \param t The time.
+ *
+ * \return The first position in [lo, hi) with a timestamp after t (hi if none).
+ */
+static inline long long int first_after(Timestamp *times, long long int lo, long long int hi, long long int t) {
+  while (lo < hi) {
+    long long int mid = lo + (hi - lo) / 2;
+    if (times[mid] <= t) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/**
+ * \function frozen_position
+ * \brief Find where a frozen graph stores a vertex.
+ *
+ * \param frozen The input frozen graph.
+ * \param id The vertex id.
+ *
+ * \return The position of the vertex in the arrays of the frozen graph.
+ */
+static inline long long int frozen_position(FrozenGraph *frozen, long long int id) {
+  return frozen->internal_ids != NULL ? frozen->internal_ids[id] : id;
+}
+
+/**
+ * \function visible_references
+ * \brief Drop the references of a focal vertex that are later than a cutoff.
+ *
+ * \param scratch The scratch whose neighbors hold the visible references.
+ * \param timestamps The vertex timestamps, by position.
+ * \param references The sorted references of the focal vertex.
+ * \param count The number of references (updated to the number visible).
+ * \param cutoff The time after which vertices are hidden (LLONG_MAX for none).
+ *
+ * \return The visible references, still sorted (the input list itself when
+ *         there is no cutoff).
+ */
+static inline VertexId *visible_references(Scratch *scratch, Timestamp *timestamps, VertexId *references, long long int *count, long long int cutoff) {
+  if (cutoff == LLONG_MAX) {
+    return references;
+  }
+  reserve_scratch_neighbors(scratch, *count);
+  long long int visible = 0;
+  for (long long int i = 0; i < *count; i++) {
+    if (timestamps[references[i]] <= cutoff) {
+      scratch->neighbors[visible++] = references[i];
+    }
+  }
+  *count = visible;
+  return scratch->neighbors;
+}
+
+/**
+ * \function next_neighbor
+ * \brief Decode the next vertex id of a compressed neighbor list.
+ *
+ * \param p The position in the list (advanced past the varint read).
+ * \param previous The previous vertex id of the list (0 before the first).
+ *
+ * \return The vertex id.
+ */
+static inline long long int next_neighbor(const unsigned char **p, long long int previous) {
+  const unsigned char *q = *p;
+  unsigned long long int gap = *q & 0x7f;
+  int shift = 7;
+  while (*q++ & 0x80) {
+    gap |= (unsigned long long int) (*q & 0x7f) << shift;
+    shift += 7;
+  }
+  *p = q;
+  return previous + (long long int) gap;
+}
+
 /**
  * \function cdindex
  * \brief Computes the CD Index.
@@ -28,64 +247,202 @@
  * \param id The focal vertex id.
  * \param time_delta Time beyond stamp of focal vertex to consider in measure.
  *
- * \return The value of the CD index.
+ * \return The value of the CD index (NAN if there are no "it" vertices).
  */
 double cdindex(Graph *graph, long long int id, long long int time_delta){
+  double result;
+  cdindex_multi(graph, id, &time_delta, 1, &result);
+  return result;
+}
 
-   /* Build a list of "it" vertices that are "in_edges" of the focal vertex's
-     "out_edges" as of timestamp t. Vertices in the list are unique. */
-
-   long long int it_count = 0;
-   long long int *it = malloc(sizeof(long long int));
-
-   /* check for malloc problems */
-   if (it==NULL) {
-     raise_error(0);
-   }
-
-   /* define i for multiple loops */
-   long long int i;
-
-   /* add unique "in_edges" of focal vertex "out_edges" */
-   for (i = 0; i < graph->vs[id].out_degree; i++) {
-     long long int out_edge_i = graph->vs[id].out_edges[i];
-     for (long long int j = 0; j < graph->vs[out_edge_i].in_degree; j++) {
-       long long int out_edge_i_in_edge_j = graph->vs[out_edge_i].in_edges[j];
-       if (graph->vs[out_edge_i_in_edge_j].timestamp > graph->vs[id].timestamp &&
-           graph->vs[out_edge_i_in_edge_j].timestamp <= (graph->vs[id].timestamp + time_delta) &&
-           !in_int_array(it, it_count, out_edge_i_in_edge_j)) {
-         add_to_int_array(&it, it_count, out_edge_i_in_edge_j, true);
-         it_count++;
-       }
+/**
+ * \function cdindex_multi
+ * \brief Computes the CD Index at several time deltas in one pass.
+ *
+ * The "it" vertices are collected once for the longest time delta, and each
+ * is classified once and added to every horizon it falls within.
+ *
+ * \param graph The input graph.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of k values to fill (NAN where there are no "it" vertices).
+ */
+void cdindex_multi(Graph *graph, long long int id, long long int *time_deltas, long long int k, double *out){
+
+  if (k <= 0) {
+    return;
+  }
+
+  Scratch *scratch = get_thread_scratch(graph->vcount);
+  reserve_scratch_horizons(scratch, k);
+  cdindex_multi_components(graph, id, time_deltas, k, scratch->horizons);
+  for (long long int h = 0; h < k; h++) {
+    out[h] = scratch->horizons[h].cdindex;
+  }
+}
+
+/**
+ * \function cdindex_multi_counts
+ * \brief Computes the numerator and denominator of the CD Index at several time deltas.
+ *
+ * For each time delta, sums is the total of -2*f_it*b_it + f_it over the "it"
+ * vertices and counts is their number, so the CD index is sums/counts.
+ *
+ * \param graph The input graph.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param sums Array of k sums to fill.
+ * \param counts Array of k counts to fill.
+ */
+void cdindex_multi_counts(Graph *graph, long long int id, long long int *time_deltas, long long int k, long long int *sums, long long int *counts){
+
+  Scratch *scratch = get_thread_scratch(graph->vcount);
+  reserve_scratch_horizons(scratch, k);
+  cdindex_multi_components(graph, id, time_deltas, k, scratch->horizons);
+  for (long long int h = 0; h < k; h++) {
+    sums[h] = scratch->horizons[h].n_f - scratch->horizons[h].n_b;
+    counts[h] = scratch->horizons[h].n_f + scratch->horizons[h].n_b + scratch->horizons[h].n_r;
+  }
+}
+
+/**
+ * \function cdindex_components
+ * \brief Computes the components of the CD Index and the derived indices.
+ *
+ * \param graph The input graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out The components to fill.
+ */
+void cdindex_components(Graph *graph, long long int id, long long int time_delta, CDComponents *out){
+  cdindex_multi_components(graph, id, &time_delta, 1, out);
+}
+
+/**
+ * \function cdindex_multi_components
+ * \brief Computes the components of the CD Index at several time deltas in one pass.
+ *
+ * One traversal gives the counts of each kind of "it" vertex, the I index
+ * (counted while scanning the in edges of the focal vertex), and from them
+ * the CD and mCD index of every horizon.
+ *
+ * \param graph The input graph.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param out Array of k components to fill.
+ */
+void cdindex_multi_components(Graph *graph, long long int id, long long int *time_deltas, long long int k, CDComponents *out){
+  cdindex_multi_components_as_of(graph, id, time_deltas, k, LLONG_MAX, out);
+}
+
+/**
+ * \function cdindex_multi_components_as_of
+ * \brief Computes the components of the CD Index at several time deltas as of a cutoff.
+ *
+ * References of the focal vertex stamped after the cutoff are hidden along
+ * with their edges. Every other vertex counted is a citer in the window, so
+ * windows that end by the cutoff (see view_cdindex_multi_components) give the
+ * components of the graph as it stood at the cutoff.
+ *
+ * \param graph The input graph.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param cutoff The time after which vertices are hidden (LLONG_MAX for none).
+ * \param out Array of k components to fill.
+ */
+void cdindex_multi_components_as_of(Graph *graph, long long int id, long long int *time_deltas, long long int k, long long int cutoff, CDComponents *out){
+
+  /* Build a list of "it" vertices that are "in_edges" of the focal vertex's
+     "out_edges" as of timestamp t. Vertices in the list are unique, which is
+     tracked with the visited bitset of the thread's scratch. */
+
+  STATS(CallStats call);
+  STATS(stats_start_call(&call));
+  Scratch *scratch = get_thread_scratch(graph->vcount);
+  long long int it_count = 0;
+  long long int t_start = graph->vs[id].timestamp;
+  long long int t_end = graph->vs[id].timestamp + max_time_delta(time_deltas, k);
+
+  /* define i for multiple loops */
+  long long int i;
+
+  /* the references of the focal vertex, less those after the cutoff */
+  VertexId *focal_out_edges = graph->vs[id].out_edges;
+  long long int focal_out_degree = graph->vs[id].out_degree;
+  if (cutoff != LLONG_MAX) {
+    reserve_scratch_neighbors(scratch, focal_out_degree);
+    focal_out_degree = 0;
+    for (i = 0; i < graph->vs[id].out_degree; i++) {
+      if (graph->vs[focal_out_edges[i]].timestamp <= cutoff) {
+        scratch->neighbors[focal_out_degree++] = focal_out_edges[i];
       }
-     }
+    }
+    focal_out_edges = scratch->neighbors;
+  }
 
-   /* add unique "in_edges" of focal vertex */
-   for (i = 0; i < graph->vs[id].in_degree; i++) {
-     long long int in_edge_i = graph->vs[id].in_edges[i];
-     if (graph->vs[in_edge_i].timestamp > graph->vs[id].timestamp &&
-         graph->vs[in_edge_i].timestamp <= (graph->vs[id].timestamp + time_delta) &&
-         !in_int_array(it, it_count, in_edge_i)) {
-       add_to_int_array(&it, it_count, in_edge_i, true);
-       it_count++;
-       }
-     }
+  /* add unique "in_edges" of focal vertex "out_edges" */
+  for (i = 0; i < focal_out_degree; i++) {
+    long long int out_edge_i = focal_out_edges[i];
+    STATS(call.in_edges_scanned += graph->vs[out_edge_i].in_degree);
+    for (long long int j = 0; j < graph->vs[out_edge_i].in_degree; j++) {
+      long long int out_edge_i_in_edge_j = graph->vs[out_edge_i].in_edges[j];
+      if (graph->vs[out_edge_i_in_edge_j].timestamp > t_start &&
+          graph->vs[out_edge_i_in_edge_j].timestamp <= t_end) {
+        STATS(call.in_edges_in_window++);
+        add_it_vertex(scratch, &it_count, out_edge_i_in_edge_j);
+      }
+    }
+  }
+
+  /* add unique "in_edges" of focal vertex, counting them for the i index */
+  start_horizons(k, out);
+  STATS(call.vertices_visited += focal_out_degree + 1);
+  STATS(call.in_edges_scanned += graph->vs[id].in_degree);
+  for (i = 0; i < graph->vs[id].in_degree; i++) {
+    long long int in_edge_i = graph->vs[id].in_edges[i];
+    if (graph->vs[in_edge_i].timestamp <= t_end) {
+      add_citer_to_horizons(graph->vs[in_edge_i].timestamp - t_start, time_deltas, k, out);
+      if (graph->vs[in_edge_i].timestamp > t_start) {
+        STATS(call.in_edges_in_window++);
+        add_it_vertex(scratch, &it_count, in_edge_i);
+      }
+    }
+  }
 
-  /* compute the cd index */
-  double sum_i = 0.0;
+  /* compute the cd index; f_it is whether "it" cites the focal vertex and
+     b_it whether it cites any of the focal vertex's "out_edges", which are
+     searches and intersections when the out edges are sorted */
+  long long int *it = scratch->it;
   for (i = 0; i < it_count; i++) {
-    long long int f_it = in_int_array(graph->vs[it[i]].out_edges, graph->vs[it[i]].out_degree, id);
-    long long int b_it = 0;
-    for (long long int j = 0; j < graph->vs[it[i]].out_degree; j++) {
-      if (in_int_array(graph->vs[id].out_edges, graph->vs[id].out_degree, graph->vs[it[i]].out_edges[j])) {
-        b_it = 1;
+    Vertex *it_i = &graph->vs[it[i]];
+    long long int f_it, b_it = 0;
+    if (graph->out_edges_sorted) {
+      f_it = in_sorted_id_array(it_i->out_edges, it_i->out_degree, id);
+      b_it = f_it && sorted_id_arrays_intersect(it_i->out_edges, it_i->out_degree,
+                                                 focal_out_edges, focal_out_degree);
+      STATS(call.membership_probes += 1 + f_it);
+    }
+    else {
+      f_it = in_id_array(it_i->out_edges, it_i->out_degree, id);
+      STATS(call.membership_probes++);
+      for (long long int j = 0; j < it_i->out_degree && f_it && !b_it; j++) {
+        STATS(call.membership_probes++);
+        if (in_id_array(focal_out_edges, focal_out_degree, it_i->out_edges[j])) {
+          b_it = 1;
+        }
       }
     }
-    sum_i += -2.0*f_it*b_it + f_it;
+    add_to_horizons(f_it, b_it, it_i->timestamp - t_start, time_deltas, k, out);
   }
+  finish_horizons(k, out);
 
-  free(it);
-  return sum_i/it_count;
+  clear_it_vertices(scratch, it_count);
+  STATS(call.it_vertices = it_count);
+  STATS(stats_end_call(&call));
 }
 
 /**
@@ -123,10 +480,1329 @@ long long int iindex(Graph *graph, long long int id, long long int time_delta){
  * \return The value of the mCD index.
  */
 double mcdindex(Graph *graph, long long int id, long long int time_delta){
+  CDComponents components;
+  cdindex_components(graph, id, time_delta, &components);
+  return components.mcdindex;
+}
+
+/**
+ * \function frozen_cdindex
+ * \brief Computes the CD Index on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ *
+ * \return The value of the CD index (NAN if there are no "it" vertices).
+ */
+double frozen_cdindex(FrozenGraph *frozen, long long int id, long long int time_delta){
+  double result;
+  frozen_cdindex_multi(frozen, id, &time_delta, 1, &result);
+  return result;
+}
+
+/**
+ * \function frozen_cdindex_multi
+ * \brief Computes the CD Index at several time deltas in one pass on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of k values to fill (NAN where there are no "it" vertices).
+ */
+void frozen_cdindex_multi(FrozenGraph *frozen, long long int id, long long int *time_deltas, long long int k, double *out){
+
+  if (k <= 0) {
+    return;
+  }
+
+  Scratch *scratch = get_thread_scratch(frozen->vcount);
+  reserve_scratch_horizons(scratch, k);
+  frozen_cdindex_multi_components(frozen, id, time_deltas, k, scratch->horizons);
+  for (long long int h = 0; h < k; h++) {
+    out[h] = scratch->horizons[h].cdindex;
+  }
+}
+
+/**
+ * \function frozen_cdindex_components
+ * \brief Computes the components of the CD Index and the derived indices on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out The components to fill.
+ */
+void frozen_cdindex_components(FrozenGraph *frozen, long long int id, long long int time_delta, CDComponents *out){
+  frozen_cdindex_multi_components(frozen, id, &time_delta, 1, out);
+}
+
+/**
+ * \function frozen_cdindex_multi_components
+ * \brief Computes the components of the CD Index at several time deltas in one pass on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param out Array of k components to fill.
+ */
+void frozen_cdindex_multi_components(FrozenGraph *frozen, long long int id, long long int *time_deltas, long long int k, CDComponents *out){
+  frozen_cdindex_multi_components_as_of(frozen, id, time_deltas, k, LLONG_MAX, out);
+}
+
+/**
+ * \function frozen_cdindex_multi_components_as_of
+ * \brief Computes the components of the CD Index at several time deltas as of a cutoff on a frozen graph.
+ *
+ * As cdindex_multi_components_as_of.
+ *
+ * \param frozen The input frozen graph.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param cutoff The time after which vertices are hidden (LLONG_MAX for none).
+ * \param out Array of k components to fill.
+ */
+void frozen_cdindex_multi_components_as_of(FrozenGraph *frozen, long long int id, long long int *time_deltas, long long int k, long long int cutoff, CDComponents *out){
+
+  /* work on the stored position of the focal vertex, which is all that
+     depends on the order of the vertices */
+  id = frozen_position(frozen, id);
+
+  STATS(CallStats call);
+  STATS(stats_start_call(&call));
+  Timestamp *timestamps = frozen->timestamps;
+  long long int *in_offsets = frozen->in_offsets;
+  VertexId *in_edges = frozen->in_edges;
+  long long int *out_offsets = frozen->out_offsets;
+  VertexId *out_edges = frozen->out_edges;
+  long long int t_start = timestamps[id];
+  long long int t_end = timestamps[id] + max_time_delta(time_deltas, k);
+
+  /* Build a list of unique "it" vertices, as in cdindex_multi_components */
+  Scratch *scratch = get_thread_scratch(frozen->vcount);
+  long long int it_count = 0;
+  start_horizons(k, out);
+  long long int focal_out_degree = out_offsets[id+1] - out_offsets[id];
+  VertexId *focal_out_edges = visible_references(scratch, timestamps, out_edges + out_offsets[id],
+                                                 &focal_out_degree, cutoff);
+
+  /* define i, j for multiple loops */
+  long long int i, j;
+
+  if (frozen->in_times != NULL) {
+
+    /* the citers in the window are a run of each time-ordered in list */
+    Timestamp *in_times = frozen->in_times;
+    for (i = 0; i < focal_out_degree; i++) {
+      long long int out_edge_i = focal_out_edges[i];
+      long long int end = in_offsets[out_edge_i+1];
+      for (j = first_after(in_times, in_offsets[out_edge_i], end, t_start); j < end && in_times[j] <= t_end; j++) {
+        STATS(call.in_edges_in_window++);
+        add_it_vertex(scratch, &it_count, in_edges[j]);
+      }
+    }
+    for (i = first_after(in_times, in_offsets[id], in_offsets[id+1], t_start);
+         i < in_offsets[id+1] && in_times[i] <= t_end; i++) {
+      STATS(call.in_edges_in_window++);
+      add_it_vertex(scratch, &it_count, in_edges[i]);
+    }
+    STATS(call.in_edges_scanned = call.in_edges_in_window);
+
+    /* and the i index of a horizon is the position of its first later citer */
+    for (long long int h = 0; h < k; h++) {
+      out[h].iindex = first_after(in_times, in_offsets[id], in_offsets[id+1], t_start + time_deltas[h]) - in_offsets[id];
+    }
+  }
+  else {
+
+    /* add unique "in_edges" of focal vertex "out_edges" */
+    for (i = 0; i < focal_out_degree; i++) {
+      long long int out_edge_i = focal_out_edges[i];
+      STATS(call.in_edges_scanned += in_offsets[out_edge_i+1] - in_offsets[out_edge_i]);
+      for (j = in_offsets[out_edge_i]; j < in_offsets[out_edge_i+1]; j++) {
+        long long int out_edge_i_in_edge_j = in_edges[j];
+        if (timestamps[out_edge_i_in_edge_j] > t_start &&
+            timestamps[out_edge_i_in_edge_j] <= t_end) {
+          STATS(call.in_edges_in_window++);
+          add_it_vertex(scratch, &it_count, out_edge_i_in_edge_j);
+        }
+      }
+    }
+
+    /* add unique "in_edges" of focal vertex, counting them for the i index */
+    STATS(call.in_edges_scanned += in_offsets[id+1] - in_offsets[id]);
+    for (i = in_offsets[id]; i < in_offsets[id+1]; i++) {
+      long long int in_edge_i = in_edges[i];
+      if (timestamps[in_edge_i] <= t_end) {
+        add_citer_to_horizons(timestamps[in_edge_i] - t_start, time_deltas, k, out);
+        if (timestamps[in_edge_i] > t_start) {
+          STATS(call.in_edges_in_window++);
+          add_it_vertex(scratch, &it_count, in_edge_i);
+        }
+      }
+    }
+  }
+  STATS(call.vertices_visited += focal_out_degree + 1);
+
+  /* compute the cd index, searching the sorted out edges */
+  long long int *it = scratch->it;
+  for (i = 0; i < it_count; i++) {
+    VertexId *it_out_edges = out_edges + out_offsets[it[i]];
+    long long int it_out_degree = out_offsets[it[i]+1] - out_offsets[it[i]];
+    long long int f_it = in_sorted_id_array(it_out_edges, it_out_degree, id);
+    long long int b_it = f_it && sorted_id_arrays_intersect(it_out_edges, it_out_degree,
+                                                             focal_out_edges, focal_out_degree);
+    STATS(call.membership_probes += 1 + f_it);
+    add_to_horizons(f_it, b_it, timestamps[it[i]] - t_start, time_deltas, k, out);
+  }
+  finish_horizons(k, out);
+
+  clear_it_vertices(scratch, it_count);
+  STATS(call.it_vertices = it_count);
+  STATS(stats_end_call(&call));
+}
+
+/**
+ * \function frozen_iindex
+ * \brief Computes the I Index on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in computing the measure.
+ *
+ * \return The value of the I index.
+ */
+long long int frozen_iindex(FrozenGraph *frozen, long long int id, long long int time_delta){
+
+  id = frozen_position(frozen, id);
+  long long int t_end = frozen->timestamps[id] + time_delta;
+
+  /* with time-ordered in edges, the count is the position of the first later one */
+  if (frozen->in_times != NULL) {
+    return first_after(frozen->in_times, frozen->in_offsets[id], frozen->in_offsets[id+1], t_end) -
+           frozen->in_offsets[id];
+  }
+
+  /* count mt vertices that are "in_edges" of the focal vertex as of timestamp t. */
+  long long int mt_count = 0;
+  for (long long int i = frozen->in_offsets[id]; i < frozen->in_offsets[id+1]; i++) {
+    if (frozen->timestamps[frozen->in_edges[i]] <= t_end) {
+      mt_count++;
+    }
+  }
+
+  return mt_count;
+}
+
+/**
+ * \function frozen_mcdindex
+ * \brief Computes the mCD Index on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in computing the measure.
+ *
+ * \return The value of the mCD index.
+ */
+double frozen_mcdindex(FrozenGraph *frozen, long long int id, long long int time_delta){
+  CDComponents components;
+  frozen_cdindex_components(frozen, id, time_delta, &components);
+  return components.mcdindex;
+}
+
+/**
+ * \function compressed_cdindex
+ * \brief Computes the CD Index on a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ *
+ * \return The value of the CD index (NAN if there are no "it" vertices).
+ */
+double compressed_cdindex(CompressedGraph *compressed, long long int id, long long int time_delta){
+  double result;
+  compressed_cdindex_multi(compressed, id, &time_delta, 1, &result);
+  return result;
+}
+
+/**
+ * \function compressed_cdindex_multi
+ * \brief Computes the CD Index at several time deltas in one pass on a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of k values to fill (NAN where there are no "it" vertices).
+ */
+void compressed_cdindex_multi(CompressedGraph *compressed, long long int id, long long int *time_deltas, long long int k, double *out){
 
-  double cdindex_value = cdindex(graph, id, time_delta);
-  long long int iindex_value = iindex(graph, id, time_delta);
+  if (k <= 0) {
+    return;
+  }
 
-  return cdindex_value * iindex_value;
+  Scratch *scratch = get_thread_scratch(compressed->vcount);
+  reserve_scratch_horizons(scratch, k);
+  compressed_cdindex_multi_components(compressed, id, time_deltas, k, scratch->horizons);
+  for (long long int h = 0; h < k; h++) {
+    out[h] = scratch->horizons[h].cdindex;
+  }
+}
 
+/**
+ * \function compressed_cdindex_components
+ * \brief Computes the components of the CD Index and the derived indices on a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out The components to fill.
+ */
+void compressed_cdindex_components(CompressedGraph *compressed, long long int id, long long int time_delta, CDComponents *out){
+  compressed_cdindex_multi_components(compressed, id, &time_delta, 1, out);
+}
+
+/**
+ * \function compressed_cdindex_multi_components
+ * \brief Computes the components of the CD Index at several time deltas in one pass on a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param out Array of k components to fill.
+ */
+void compressed_cdindex_multi_components(CompressedGraph *compressed, long long int id, long long int *time_deltas, long long int k, CDComponents *out){
+  compressed_cdindex_multi_components_as_of(compressed, id, time_deltas, k, LLONG_MAX, out);
+}
+
+/**
+ * \function compressed_cdindex_multi_components_as_of
+ * \brief Computes the components of the CD Index at several time deltas as of a cutoff on a compressed graph.
+ *
+ * The neighbor lists are decoded as they are scanned. The out edges of the
+ * focal vertex are decoded once into the scratch, and the out edges of each
+ * "it" vertex are merged against them, stopping as soon as the contribution
+ * of the vertex is known. References after the cutoff are dropped as they
+ * are decoded (see cdindex_multi_components_as_of).
+ *
+ * \param compressed The input compressed graph.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param cutoff The time after which vertices are hidden (LLONG_MAX for none).
+ * \param out Array of k components to fill.
+ */
+void compressed_cdindex_multi_components_as_of(CompressedGraph *compressed, long long int id, long long int *time_deltas, long long int k, long long int cutoff, CDComponents *out){
+
+  STATS(CallStats call);
+  STATS(stats_start_call(&call));
+  Timestamp *timestamps = compressed->timestamps;
+  long long int *in_offsets = compressed->in_offsets;
+  unsigned char *in_data = compressed->in_data;
+  long long int *out_offsets = compressed->out_offsets;
+  unsigned char *out_data = compressed->out_data;
+  long long int t_start = timestamps[id];
+  long long int t_end = timestamps[id] + max_time_delta(time_deltas, k);
+
+  /* Build a list of unique "it" vertices, as in cdindex_multi_components */
+  Scratch *scratch = get_thread_scratch(compressed->vcount);
+  long long int it_count = 0;
+  start_horizons(k, out);
+  const unsigned char *p, *end;
+
+  /* decode the out edges of the focal vertex up to the cutoff, which have at
+     most one id per byte */
+  reserve_scratch_neighbors(scratch, out_offsets[id+1] - out_offsets[id]);
+  VertexId *focal_out_edges = scratch->neighbors;
+  long long int focal_out_degree = 0;
+  long long int value = 0;
+  for (p = out_data + out_offsets[id], end = out_data + out_offsets[id+1]; p < end; ) {
+    value = next_neighbor(&p, value);
+    if (timestamps[value] <= cutoff) {
+      focal_out_edges[focal_out_degree++] = value;
+    }
+  }
+
+  /* add unique "in_edges" of focal vertex "out_edges" */
+  for (long long int i = 0; i < focal_out_degree; i++) {
+    long long int out_edge_i = focal_out_edges[i];
+    value = 0;
+    for (p = in_data + in_offsets[out_edge_i], end = in_data + in_offsets[out_edge_i+1]; p < end; ) {
+      value = next_neighbor(&p, value);
+      STATS(call.in_edges_scanned++);
+      if (timestamps[value] > t_start && timestamps[value] <= t_end) {
+        STATS(call.in_edges_in_window++);
+        add_it_vertex(scratch, &it_count, value);
+      }
+    }
+  }
+
+  /* add unique "in_edges" of focal vertex, counting them for the i index */
+  STATS(call.vertices_visited += focal_out_degree + 1);
+  value = 0;
+  for (p = in_data + in_offsets[id], end = in_data + in_offsets[id+1]; p < end; ) {
+    value = next_neighbor(&p, value);
+    STATS(call.in_edges_scanned++);
+    if (timestamps[value] <= t_end) {
+      add_citer_to_horizons(timestamps[value] - t_start, time_deltas, k, out);
+      if (timestamps[value] > t_start) {
+        STATS(call.in_edges_in_window++);
+        add_it_vertex(scratch, &it_count, value);
+      }
+    }
+  }
+
+  /* compute the cd index, merging the sorted out edges */
+  long long int *it = scratch->it;
+  for (long long int i = 0; i < it_count; i++) {
+    const unsigned char *start = out_data + out_offsets[it[i]];
+    end = out_data + out_offsets[it[i]+1];
+    long long int f_it = 0, b_it = 0;
+
+    /* the list is sorted, so the search for the focal vertex stops at the
+       first larger id */
+    value = 0;
+    for (p = start; p < end; ) {
+      value = next_neighbor(&p, value);
+      if (value >= id) {
+        f_it = value == id;
+        break;
+      }
+    }
+
+    /* only then look for a shared out edge, from the start of the list */
+    if (f_it) {
+      long long int j = 0;
+      value = 0;
+      for (p = start; p < end && j < focal_out_degree && !b_it; ) {
+        value = next_neighbor(&p, value);
+        while (j < focal_out_degree && focal_out_edges[j] < value) {
+          j++;
+        }
+        b_it = j < focal_out_degree && focal_out_edges[j] == value;
+      }
+    }
+    STATS(call.membership_probes += 1 + f_it);
+    add_to_horizons(f_it, b_it, timestamps[it[i]] - t_start, time_deltas, k, out);
+  }
+  finish_horizons(k, out);
+
+  clear_it_vertices(scratch, it_count);
+  STATS(call.it_vertices = it_count);
+  STATS(stats_end_call(&call));
+}
+
+/**
+ * \function compressed_iindex
+ * \brief Computes the I Index on a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in computing the measure.
+ *
+ * \return The value of the I index.
+ */
+long long int compressed_iindex(CompressedGraph *compressed, long long int id, long long int time_delta){
+
+  long long int t_end = compressed->timestamps[id] + time_delta;
+
+  /* count mt vertices that are "in_edges" of the focal vertex as of timestamp t. */
+  long long int mt_count = 0;
+  long long int value = 0;
+  const unsigned char *p = compressed->in_data + compressed->in_offsets[id];
+  const unsigned char *end = compressed->in_data + compressed->in_offsets[id+1];
+  while (p < end) {
+    value = next_neighbor(&p, value);
+    if (compressed->timestamps[value] <= t_end) {
+      mt_count++;
+    }
+  }
+
+  return mt_count;
+}
+
+/**
+ * \function compressed_mcdindex
+ * \brief Computes the mCD Index on a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in computing the measure.
+ *
+ * \return The value of the mCD index.
+ */
+double compressed_mcdindex(CompressedGraph *compressed, long long int id, long long int time_delta){
+  CDComponents components;
+  compressed_cdindex_components(compressed, id, time_delta, &components);
+  return components.mcdindex;
+}
+
+/**
+ * \function cdindex_batch
+ * \brief Computes the CD Index of many focal vertices.
+ *
+ * The vertices share the scratch of the calling thread, so no memory is
+ * allocated per vertex once the scratch has grown to fit the largest "it"
+ * list.
+ *
+ * \param graph The input graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill (NAN where the index is undefined).
+ */
+void cdindex_batch(Graph *graph, long long int *ids, long long int n, long long int time_delta, double *out){
+  for (long long int i = 0; i < n; i++) {
+    out[i] = cdindex(graph, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function mcdindex_batch
+ * \brief Computes the mCD Index of many focal vertices.
+ *
+ * \param graph The input graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill (NAN where the index is undefined).
+ */
+void mcdindex_batch(Graph *graph, long long int *ids, long long int n, long long int time_delta, double *out){
+  for (long long int i = 0; i < n; i++) {
+    out[i] = mcdindex(graph, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function iindex_batch
+ * \brief Computes the I Index of many focal vertices.
+ *
+ * \param graph The input graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill.
+ */
+void iindex_batch(Graph *graph, long long int *ids, long long int n, long long int time_delta, long long int *out){
+  for (long long int i = 0; i < n; i++) {
+    out[i] = iindex(graph, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function frozen_cdindex_batch
+ * \brief Computes the CD Index of many focal vertices on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill (NAN where the index is undefined).
+ */
+void frozen_cdindex_batch(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, double *out){
+  for (long long int i = 0; i < n; i++) {
+    out[i] = frozen_cdindex(frozen, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function frozen_mcdindex_batch
+ * \brief Computes the mCD Index of many focal vertices on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill (NAN where the index is undefined).
+ */
+void frozen_mcdindex_batch(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, double *out){
+  for (long long int i = 0; i < n; i++) {
+    out[i] = frozen_mcdindex(frozen, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function frozen_iindex_batch
+ * \brief Computes the I Index of many focal vertices on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill.
+ */
+void frozen_iindex_batch(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, long long int *out){
+  for (long long int i = 0; i < n; i++) {
+    out[i] = frozen_iindex(frozen, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function cdindex_multi_batch
+ * \brief Computes the CD Index of many focal vertices at several time deltas.
+ *
+ * \param graph The input graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of n * k values to fill, k per focal vertex (NAN where the index is undefined).
+ */
+void cdindex_multi_batch(Graph *graph, long long int *ids, long long int n, long long int *time_deltas, long long int k, double *out){
+  for (long long int i = 0; i < n; i++) {
+    cdindex_multi(graph, ids[i], time_deltas, k, out + i * k);
+  }
+}
+
+/**
+ * \function frozen_cdindex_multi_batch
+ * \brief Computes the CD Index of many focal vertices at several time deltas on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of n * k values to fill, k per focal vertex (NAN where the index is undefined).
+ */
+void frozen_cdindex_multi_batch(FrozenGraph *frozen, long long int *ids, long long int n, long long int *time_deltas, long long int k, double *out){
+  for (long long int i = 0; i < n; i++) {
+    frozen_cdindex_multi(frozen, ids[i], time_deltas, k, out + i * k);
+  }
+}
+
+/**
+ * \function compressed_cdindex_batch
+ * \brief Computes the CD Index of many focal vertices on a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill (NAN where the index is undefined).
+ */
+void compressed_cdindex_batch(CompressedGraph *compressed, long long int *ids, long long int n, long long int time_delta, double *out){
+  for (long long int i = 0; i < n; i++) {
+    out[i] = compressed_cdindex(compressed, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function compressed_mcdindex_batch
+ * \brief Computes the mCD Index of many focal vertices on a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill (NAN where the index is undefined).
+ */
+void compressed_mcdindex_batch(CompressedGraph *compressed, long long int *ids, long long int n, long long int time_delta, double *out){
+  for (long long int i = 0; i < n; i++) {
+    out[i] = compressed_mcdindex(compressed, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function compressed_iindex_batch
+ * \brief Computes the I Index of many focal vertices on a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill.
+ */
+void compressed_iindex_batch(CompressedGraph *compressed, long long int *ids, long long int n, long long int time_delta, long long int *out){
+  for (long long int i = 0; i < n; i++) {
+    out[i] = compressed_iindex(compressed, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function compressed_cdindex_multi_batch
+ * \brief Computes the CD Index of many focal vertices at several time deltas on a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of n * k values to fill, k per focal vertex (NAN where the index is undefined).
+ */
+void compressed_cdindex_multi_batch(CompressedGraph *compressed, long long int *ids, long long int n, long long int *time_deltas, long long int k, double *out){
+  for (long long int i = 0; i < n; i++) {
+    compressed_cdindex_multi(compressed, ids[i], time_deltas, k, out + i * k);
+  }
+}
+
+/**
+ * \function add_to_horizon_counts
+ * \brief Count a vertex in every horizon its delay falls within.
+ *
+ * \param counts The k counts of a vertex.
+ * \param delay How long after the focal vertex the counted vertex appeared.
+ * \param time_deltas The time deltas of the horizons.
+ * \param k The number of horizons.
+ */
+static inline void add_to_horizon_counts(long long int *counts, long long int delay, long long int *time_deltas, long long int k) {
+  for (long long int h = 0; h < k; h++) {
+    if (delay <= time_deltas[h]) {
+      counts[h]++;
+    }
+  }
+}
+
+/**
+ * \function finish_all_counts
+ * \brief Turn the sweep totals of every vertex into CD index components.
+ *
+ * \param n The number of counts (vcount * k).
+ * \param n_f The citers of each vertex, replaced by those citing none of its references.
+ * \param n_b The citers of each vertex that also cite one of its references.
+ * \param n_r The vertices citing one of the references of each vertex,
+ *            replaced by those not citing the vertex itself.
+ */
+static void finish_all_counts(long long int n, long long int *n_f, long long int *n_b, long long int *n_r) {
+  for (long long int i = 0; i < n; i++) {
+    n_f[i] -= n_b[i];
+    n_r[i] -= n_b[i];
+  }
+}
+
+/**
+ * \function sweep_counts
+ * \brief Computes the components of the CD Index of every vertex in one sweep.
+ *
+ * Rather than gathering the "it" vertices of each focal vertex, the sweep
+ * visits each citing vertex p once and hands its contribution to every focal
+ * vertex f it is an "it" vertex of. Those are the vertices citing one of p's
+ * references (found through the in edges of the references, with the visited
+ * bitset keeping each f once) and the vertices p cites. In both cases f must
+ * be earlier than p by at most the time delta. The b_it flag of p for a cited
+ * f is then a bit lookup: p and f share a reference exactly when f was
+ * reached through one, closing the triangle p->f, p->r, f->r. No out edges
+ * are searched or intersected, and each reference list is read once.
+ *
+ * For each vertex and time delta, n_f counts the "it" vertices citing the
+ * vertex but none of its references, n_b those citing both, and n_r those
+ * citing only its references, so the CD index is (n_f - n_b) / (n_f + n_b + n_r).
+ *
+ * Citing vertices stamped after the cutoff are skipped, and so are the
+ * references after it that earlier vertices cite, which leaves the
+ * components of the graph as it stood at the cutoff.
+ *
+ * \param graph The input graph.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param cutoff The time after which vertices are hidden (LLONG_MAX for none).
+ * \param n_f Array of vcount * k counts to fill, k per vertex.
+ * \param n_b Array of vcount * k counts to fill, k per vertex.
+ * \param n_r Array of vcount * k counts to fill, k per vertex.
+ */
+static void sweep_counts(Graph *graph, long long int *time_deltas, long long int k, long long int cutoff, long long int *n_f, long long int *n_b, long long int *n_r){
+
+  Scratch *scratch = get_thread_scratch(graph->vcount);
+  long long int max_delta = max_time_delta(time_deltas, k);
+  Vertex *vs = graph->vs;
+  for (long long int i = 0; i < graph->vcount * k; i++) {
+    n_f[i] = 0;
+    n_b[i] = 0;
+    n_r[i] = 0;
+  }
+
+  for (long long int p = 0; p < graph->vcount; p++) {
+    long long int t_p = vs[p].timestamp;
+    long long int it_count = 0;
+    if (t_p > cutoff) {
+      continue;
+    }
+
+    /* mark the earlier vertices in window that share a reference with p */
+    for (long long int i = 0; i < vs[p].out_degree; i++) {
+      Vertex *reference = &vs[vs[p].out_edges[i]];
+      if (reference->timestamp > cutoff) {
+        continue;
+      }
+      for (long long int j = 0; j < reference->in_degree; j++) {
+        long long int f = reference->in_edges[j];
+        if (vs[f].timestamp < t_p && vs[f].timestamp >= t_p - max_delta) {
+          add_it_vertex(scratch, &it_count, f);
+        }
+      }
+    }
+
+    /* p is a citer of each vertex it cites in window, of both kinds if marked */
+    for (long long int i = 0; i < vs[p].out_degree; i++) {
+      long long int f = vs[p].out_edges[i];
+      long long int delay = t_p - vs[f].timestamp;
+      if (delay > 0 && delay <= max_delta) {
+        add_to_horizon_counts(n_f + f * k, delay, time_deltas, k);
+        if (scratch->visited[f >> 6] & (1ULL << (f & 63))) {
+          add_to_horizon_counts(n_b + f * k, delay, time_deltas, k);
+        }
+      }
+    }
+
+    /* and cites one of the references of each marked vertex */
+    for (long long int i = 0; i < it_count; i++) {
+      long long int f = scratch->it[i];
+      add_to_horizon_counts(n_r + f * k, t_p - vs[f].timestamp, time_deltas, k);
+    }
+    clear_it_vertices(scratch, it_count);
+  }
+
+  finish_all_counts(graph->vcount * k, n_f, n_b, n_r);
+}
+
+/**
+ * \function cdindex_all_counts
+ * \brief Computes the components of the CD Index of every vertex in one sweep.
+ *
+ * See sweep_counts.
+ *
+ * \param graph The input graph.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param n_f Array of vcount * k counts to fill, k per vertex.
+ * \param n_b Array of vcount * k counts to fill, k per vertex.
+ * \param n_r Array of vcount * k counts to fill, k per vertex.
+ */
+void cdindex_all_counts(Graph *graph, long long int *time_deltas, long long int k, long long int *n_f, long long int *n_b, long long int *n_r){
+  sweep_counts(graph, time_deltas, k, LLONG_MAX, n_f, n_b, n_r);
+}
+
+/**
+ * \function unpermute_rows
+ * \brief Move the rows of a per-vertex array from storage positions to ids.
+ *
+ * \param frozen The frozen graph whose vertices are reordered.
+ * \param k The number of values per vertex.
+ * \param values The array of vcount rows of k values.
+ */
+static void unpermute_rows(FrozenGraph *frozen, long long int k, long long int *values) {
+  long long int n = frozen->vcount * k;
+  long long int *rows = malloc((n > 0 ? n : 1) * sizeof(long long int));
+  if (rows==NULL) {
+    raise_error(0);
+  }
+  for (long long int p = 0; p < frozen->vcount; p++) {
+    memcpy(rows + frozen->public_ids[p] * k, values + p * k, k * sizeof(long long int));
+  }
+  memcpy(values, rows, n * sizeof(long long int));
+  free(rows);
+}
+
+/**
+ * \function frozen_sweep_counts
+ * \brief Computes the components of the CD Index of every vertex in one sweep on a frozen graph.
+ *
+ * As sweep_counts. When the in edges are ordered by time, the vertices
+ * citing a reference in the window of p are a run of its in list.
+ *
+ * \param frozen The input frozen graph.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param cutoff The time after which vertices are hidden (LLONG_MAX for none).
+ * \param n_f Array of vcount * k counts to fill, k per vertex.
+ * \param n_b Array of vcount * k counts to fill, k per vertex.
+ * \param n_r Array of vcount * k counts to fill, k per vertex.
+ */
+static void frozen_sweep_counts(FrozenGraph *frozen, long long int *time_deltas, long long int k, long long int cutoff, long long int *n_f, long long int *n_b, long long int *n_r){
+
+  Scratch *scratch = get_thread_scratch(frozen->vcount);
+  long long int max_delta = max_time_delta(time_deltas, k);
+  Timestamp *timestamps = frozen->timestamps;
+  Timestamp *in_times = frozen->in_times;
+  long long int *in_offsets = frozen->in_offsets;
+  VertexId *in_edges = frozen->in_edges;
+  long long int *out_offsets = frozen->out_offsets;
+  VertexId *out_edges = frozen->out_edges;
+  for (long long int i = 0; i < frozen->vcount * k; i++) {
+    n_f[i] = 0;
+    n_b[i] = 0;
+    n_r[i] = 0;
+  }
+
+  for (long long int p = 0; p < frozen->vcount; p++) {
+    long long int t_p = timestamps[p];
+    long long int it_count = 0;
+    if (t_p > cutoff) {
+      continue;
+    }
+
+    /* mark the earlier vertices in window that share a reference with p */
+    for (long long int i = out_offsets[p]; i < out_offsets[p+1]; i++) {
+      long long int reference = out_edges[i];
+      if (timestamps[reference] > cutoff) {
+        continue;
+      }
+      long long int j = in_offsets[reference];
+      long long int end = in_offsets[reference+1];
+      if (in_times != NULL) {
+        for (j = first_after(in_times, j, end, t_p - max_delta - 1); j < end && in_times[j] < t_p; j++) {
+          add_it_vertex(scratch, &it_count, in_edges[j]);
+        }
+      }
+      else {
+        for (; j < end; j++) {
+          long long int f = in_edges[j];
+          if (timestamps[f] < t_p && timestamps[f] >= t_p - max_delta) {
+            add_it_vertex(scratch, &it_count, f);
+          }
+        }
+      }
+    }
+
+    /* p is a citer of each vertex it cites in window, of both kinds if marked */
+    for (long long int i = out_offsets[p]; i < out_offsets[p+1]; i++) {
+      long long int f = out_edges[i];
+      long long int delay = t_p - timestamps[f];
+      if (delay > 0 && delay <= max_delta) {
+        add_to_horizon_counts(n_f + f * k, delay, time_deltas, k);
+        if (scratch->visited[f >> 6] & (1ULL << (f & 63))) {
+          add_to_horizon_counts(n_b + f * k, delay, time_deltas, k);
+        }
+      }
+    }
+
+    /* and cites one of the references of each marked vertex */
+    for (long long int i = 0; i < it_count; i++) {
+      long long int f = scratch->it[i];
+      add_to_horizon_counts(n_r + f * k, t_p - timestamps[f], time_deltas, k);
+    }
+    clear_it_vertices(scratch, it_count);
+  }
+
+  finish_all_counts(frozen->vcount * k, n_f, n_b, n_r);
+  if (frozen->public_ids != NULL) {
+    unpermute_rows(frozen, k, n_f);
+    unpermute_rows(frozen, k, n_b);
+    unpermute_rows(frozen, k, n_r);
+  }
+}
+
+/**
+ * \function frozen_cdindex_all_counts
+ * \brief Computes the components of the CD Index of every vertex in one sweep on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param n_f Array of vcount * k counts to fill, k per vertex.
+ * \param n_b Array of vcount * k counts to fill, k per vertex.
+ * \param n_r Array of vcount * k counts to fill, k per vertex.
+ */
+void frozen_cdindex_all_counts(FrozenGraph *frozen, long long int *time_deltas, long long int k, long long int *n_f, long long int *n_b, long long int *n_r){
+  frozen_sweep_counts(frozen, time_deltas, k, LLONG_MAX, n_f, n_b, n_r);
+}
+
+/**
+ * \function view_cdindex_all_counts
+ * \brief Computes the components of the CD Index of every vertex of a view in one sweep.
+ *
+ * Vertices hidden by the view get zero counts. A view of a compressed graph
+ * cannot be swept; sweep a view of the graph it was compressed from.
+ *
+ * \param view The input view (of a graph or a frozen graph).
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (at least 1).
+ * \param n_f Array of vcount * k counts to fill, k per vertex.
+ * \param n_b Array of vcount * k counts to fill, k per vertex.
+ * \param n_r Array of vcount * k counts to fill, k per vertex.
+ */
+void view_cdindex_all_counts(GraphView *view, long long int *time_deltas, long long int k, long long int *n_f, long long int *n_b, long long int *n_r){
+  if (view->frozen != NULL) {
+    frozen_sweep_counts(view->frozen, time_deltas, k, view->cutoff, n_f, n_b, n_r);
+  }
+  else {
+    sweep_counts(view->graph, time_deltas, k, view->cutoff, n_f, n_b, n_r);
+  }
+}
+
+/**
+ * \function cdindex_from_counts
+ * \brief Computes the CD Index of every vertex from its components.
+ *
+ * \param n The number of values (vcount * k).
+ * \param n_f The "it" vertices citing only the focal vertex.
+ * \param n_b The "it" vertices citing the focal vertex and one of its references.
+ * \param n_r The "it" vertices citing only references of the focal vertex.
+ * \param out Array of n values to fill (NAN where there are no "it" vertices).
+ */
+static void cdindex_from_counts(long long int n, long long int *n_f, long long int *n_b, long long int *n_r, double *out) {
+  for (long long int i = 0; i < n; i++) {
+    long long int it_count = n_f[i] + n_b[i] + n_r[i];
+    out[i] = it_count > 0 ? (double) (n_f[i] - n_b[i]) / it_count : NAN;
+  }
+}
+
+/**
+ * \function cdindex_all
+ * \brief Computes the CD Index of every vertex at several time deltas in one sweep.
+ *
+ * The results equal those of cdindex_multi_batch over every vertex, from the
+ * sweep of cdindex_all_counts.
+ *
+ * \param graph The input graph.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of vcount * k values to fill, k per vertex (NAN where the index is undefined).
+ */
+void cdindex_all(Graph *graph, long long int *time_deltas, long long int k, double *out){
+  if (k <= 0) {
+    return;
+  }
+  long long int n = graph->vcount * k;
+  long long int *counts = malloc(3 * (n > 0 ? n : 1) * sizeof(long long int));
+  if (counts==NULL) {
+    raise_error(0);
+  }
+  cdindex_all_counts(graph, time_deltas, k, counts, counts + n, counts + 2 * n);
+  cdindex_from_counts(n, counts, counts + n, counts + 2 * n, out);
+  free(counts);
+}
+
+/**
+ * \function frozen_cdindex_all
+ * \brief Computes the CD Index of every vertex at several time deltas in one sweep on a frozen graph.
+ *
+ * \param frozen The input frozen graph.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of vcount * k values to fill, k per vertex (NAN where the index is undefined).
+ */
+void frozen_cdindex_all(FrozenGraph *frozen, long long int *time_deltas, long long int k, double *out){
+  if (k <= 0) {
+    return;
+  }
+  long long int n = frozen->vcount * k;
+  long long int *counts = malloc(3 * (n > 0 ? n : 1) * sizeof(long long int));
+  if (counts==NULL) {
+    raise_error(0);
+  }
+  frozen_cdindex_all_counts(frozen, time_deltas, k, counts, counts + n, counts + 2 * n);
+  cdindex_from_counts(n, counts, counts + n, counts + 2 * n, out);
+  free(counts);
+}
+
+/**
+ * \function view_cdindex_all
+ * \brief Computes the CD Index of every vertex of a view at several time deltas in one sweep.
+ *
+ * \param view The input view (of a graph or a frozen graph).
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of vcount * k values to fill, k per vertex (NAN where the
+ *            index is undefined or the vertex is hidden).
+ */
+void view_cdindex_all(GraphView *view, long long int *time_deltas, long long int k, double *out){
+  if (k <= 0) {
+    return;
+  }
+  long long int vcount = view->frozen != NULL ? view->frozen->vcount : view->graph->vcount;
+  long long int n = vcount * k;
+  long long int *counts = malloc(3 * (n > 0 ? n : 1) * sizeof(long long int));
+  if (counts==NULL) {
+    raise_error(0);
+  }
+  view_cdindex_all_counts(view, time_deltas, k, counts, counts + n, counts + 2 * n);
+  cdindex_from_counts(n, counts, counts + n, counts + 2 * n, out);
+  free(counts);
+}
+
+/**
+ * \function sample_below
+ * \brief Draw a random integer in [0, n) with a xorshift64 generator.
+ *
+ * \param state The generator state (not zero).
+ * \param n The upper bound (at least 1).
+ *
+ * \return The random integer.
+ */
+static inline long long int sample_below(unsigned long long int *state, long long int n) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return (long long int) (*state % (unsigned long long int) n);
+}
+
+/**
+ * \function count_common_ids
+ * \brief Count the ids two sorted id arrays share.
+ *
+ * \param a The first array.
+ * \param sizeof_a The size of the first array.
+ * \param b The second array.
+ * \param sizeof_b The size of the second array.
+ *
+ * \return The number of shared ids.
+ */
+static long long int count_common_ids(VertexId *a, long long int sizeof_a, VertexId *b, long long int sizeof_b) {
+  long long int i = 0, j = 0, common = 0;
+  while (i < sizeof_a && j < sizeof_b) {
+    if (a[i] < b[j]) {
+      i++;
+    }
+    else if (a[i] > b[j]) {
+      j++;
+    }
+    else {
+      common++;
+      i++;
+      j++;
+    }
+  }
+  return common;
+}
+
+/**
+ * \function normal_quantile
+ * \brief Find the two-sided critical value of the standard normal distribution.
+ *
+ * \param confidence The confidence level, in (0, 1).
+ *
+ * \return The z with P(|Z| <= z) = confidence, to about 1e-9.
+ */
+static double normal_quantile(double confidence) {
+  double lo = 0.0, hi = 40.0;
+  for (int i = 0; i < 64; i++) {
+    double z = (lo + hi) / 2.0;
+    if (erf(z / sqrt(2.0)) < confidence) {
+      lo = z;
+    }
+    else {
+      hi = z;
+    }
+  }
+  return (lo + hi) / 2.0;
+}
+
+/**
+ * \function frozen_cdindex_estimate
+ * \brief Estimates the CD Index on a frozen graph from a sample of the "it" vertices.
+ *
+ * The "it" vertices are split in two strata. The d direct citers in the
+ * window are counted exactly, and a uniform sample of them estimates the
+ * share that also cite a reference, giving n_b (and n_f = d - n_b). The m
+ * in-window citers of the references, counted once per reference cited, are
+ * sampled uniformly too: a citer u that does not cite the focal vertex and
+ * shares c(u) references with it contributes 1 / c(u), so m times the mean
+ * contribution estimates n_r without building the set of "it" vertices.
+ * The interval comes from the normal approximation of the two sample means
+ * (each with one pseudo-observation of 0 and of 1, so a sample in which every
+ * draw agrees still gets a width) carried through
+ * (n_f - n_b) / (n_f + n_b + n_r) by the delta method. Both samples double
+ * until the half width is at most tolerance. The index is computed exactly
+ * when d + m is below exact_below, when there are no direct citers (the index
+ * is then 0 or undefined), or when the samples would grow as large as d + m.
+ *
+ * Drawing from the citers of the references is a binary search when the in
+ * edges are ordered by time (see freeze_graph_by_time), so the estimate costs
+ * about the sample size; otherwise the in lists are scanned once.
+ *
+ * \param frozen The input frozen graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param tolerance The largest half width of the interval to accept.
+ * \param confidence The confidence level of the interval (e.g., 0.95).
+ * \param exact_below The number of citers below which to compute exactly.
+ * \param seed The seed of the sample (the same seed gives the same estimate).
+ * \param out The estimate to fill.
+ */
+void frozen_cdindex_estimate(FrozenGraph *frozen, long long int id, long long int time_delta, double tolerance, double confidence, long long int exact_below, unsigned long long int seed, CDEstimate *out){
+  frozen_cdindex_estimate_as_of(frozen, id, time_delta, tolerance, confidence, exact_below, seed, LLONG_MAX, out);
+}
+
+/**
+ * \function frozen_cdindex_estimate_as_of
+ * \brief Estimates the CD Index on a frozen graph as of a cutoff.
+ *
+ * As frozen_cdindex_estimate, sampling only through the references that
+ * are no later than the cutoff (see cdindex_multi_components_as_of).
+ *
+ * \param frozen The input frozen graph.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param tolerance The largest half width of the interval to accept.
+ * \param confidence The confidence level of the interval (e.g., 0.95).
+ * \param exact_below The number of citers below which to compute exactly.
+ * \param seed The seed of the sample (the same seed gives the same estimate).
+ * \param cutoff The time after which vertices are hidden (LLONG_MAX for none).
+ * \param out The estimate to fill.
+ */
+void frozen_cdindex_estimate_as_of(FrozenGraph *frozen, long long int id, long long int time_delta, double tolerance, double confidence, long long int exact_below, unsigned long long int seed, long long int cutoff, CDEstimate *out){
+
+  long long int position = frozen_position(frozen, id);
+  Timestamp *timestamps = frozen->timestamps;
+  Timestamp *in_times = frozen->in_times;
+  long long int *in_offsets = frozen->in_offsets;
+  VertexId *in_edges = frozen->in_edges;
+  long long int *out_offsets = frozen->out_offsets;
+  VertexId *out_edges = frozen->out_edges;
+  long long int t_start = timestamps[position];
+  long long int t_end = t_start + time_delta;
+  long long int focal_out_degree = out_offsets[position+1] - out_offsets[position];
+  VertexId *focal_out_edges = visible_references(get_thread_scratch(frozen->vcount), timestamps,
+                                                 out_edges + out_offsets[position],
+                                                 &focal_out_degree, cutoff);
+  long long int i, j;
+
+  /* the direct citers in the window, a run of the in list when it is
+     ordered by time, and the citers of the references in the window, as
+     runs after a running count of their sizes or as one list of them */
+  VertexId *direct = NULL;
+  VertexId *citers = NULL;
+  long long int direct_count = 0, citer_count = 0;
+  long long int *starts = malloc((focal_out_degree + 1) * sizeof(long long int));
+  long long int *run_ends = malloc((focal_out_degree + 1) * sizeof(long long int));
+  if (starts==NULL || run_ends==NULL) {
+    raise_error(0);
+  }
+  if (in_times != NULL) {
+    long long int lo = first_after(in_times, in_offsets[position], in_offsets[position+1], t_start);
+    direct = in_edges + lo;
+    direct_count = first_after(in_times, lo, in_offsets[position+1], t_end) - lo;
+    for (i = 0; i < focal_out_degree; i++) {
+      long long int reference = focal_out_edges[i];
+      starts[i] = first_after(in_times, in_offsets[reference], in_offsets[reference+1], t_start);
+      long long int end = first_after(in_times, starts[i], in_offsets[reference+1], t_end);
+      citer_count += end - starts[i];
+      run_ends[i] = citer_count;
+    }
+  }
+  else {
+    direct = malloc((in_offsets[position+1] - in_offsets[position] + 1) * sizeof(VertexId));
+    if (direct==NULL) {
+      raise_error(0);
+    }
+    for (i = in_offsets[position]; i < in_offsets[position+1]; i++) {
+      if (timestamps[in_edges[i]] > t_start && timestamps[in_edges[i]] <= t_end) {
+        direct[direct_count++] = in_edges[i];
+      }
+    }
+    long long int capacity = 0;
+    for (i = 0; i < focal_out_degree; i++) {
+      long long int reference = focal_out_edges[i];
+      capacity += in_offsets[reference+1] - in_offsets[reference];
+    }
+    citers = malloc((capacity + 1) * sizeof(VertexId));
+    if (citers==NULL) {
+      raise_error(0);
+    }
+    for (i = 0; i < focal_out_degree; i++) {
+      long long int reference = focal_out_edges[i];
+      for (j = in_offsets[reference]; j < in_offsets[reference+1]; j++) {
+        if (timestamps[in_edges[j]] > t_start && timestamps[in_edges[j]] <= t_end) {
+          citers[citer_count++] = in_edges[j];
+        }
+      }
+    }
+  }
+
+  bool exact = direct_count + citer_count < exact_below;
+  out->exact = true;
+  out->sampled = 0;
+  if (direct_count == 0) {
+
+    /* every "it" vertex cites only references */
+    out->cdindex = citer_count > 0 ? 0.0 : NAN;
+    out->lower = out->cdindex;
+    out->upper = out->cdindex;
+    exact = false;
+  }
+
+  unsigned long long int state = seed != 0 ? seed : 88172645463325252ULL;
+  double z = normal_quantile(confidence);
+  long long int target = 256, direct_sampled = 0, citer_sampled = 0;
+  double both_sum = 0.0, share_sum = 0.0, share_squares = 0.0;
+  while (direct_count > 0 && !exact) {
+
+    /* does a direct citer also cite a reference? */
+    for (; direct_sampled < target; direct_sampled++) {
+      long long int u = direct[sample_below(&state, direct_count)];
+      both_sum += sorted_id_arrays_intersect(out_edges + out_offsets[u], out_offsets[u+1] - out_offsets[u],
+                                             focal_out_edges, focal_out_degree);
+    }
+
+    /* what share of a reference citer's count goes to n_r? */
+    for (; citer_count > 0 && citer_sampled < target; citer_sampled++) {
+      long long int k = sample_below(&state, citer_count);
+      long long int u;
+      if (citers != NULL) {
+        u = citers[k];
+      }
+      else {
+        long long int lo = 0, hi = focal_out_degree - 1;
+        while (lo < hi) {
+          long long int mid = lo + (hi - lo) / 2;
+          if (run_ends[mid] > k) {
+            hi = mid;
+          }
+          else {
+            lo = mid + 1;
+          }
+        }
+        u = in_edges[starts[lo] + k - (lo > 0 ? run_ends[lo-1] : 0)];
+      }
+      VertexId *u_out_edges = out_edges + out_offsets[u];
+      long long int u_out_degree = out_offsets[u+1] - out_offsets[u];
+      if (!in_sorted_id_array(u_out_edges, u_out_degree, position)) {
+        double share = 1.0 / count_common_ids(u_out_edges, u_out_degree, focal_out_edges, focal_out_degree);
+        share_sum += share;
+        share_squares += share * share;
+      }
+    }
+
+    /* the estimate and its half width, by the delta method */
+    double d = direct_count;
+    double both_mean = (both_sum + 1.0) / (direct_sampled + 2.0);
+    double both_variance = both_mean * (1.0 - both_mean) / (direct_sampled + 2.0);
+    double n_b = d * both_sum / direct_sampled;
+    double n_r = 0.0, n_r_variance = 0.0;
+    if (citer_sampled > 0) {
+      double share_mean = (share_sum + 1.0) / (citer_sampled + 2.0);
+      double share_variance = ((share_squares + 1.0) / (citer_sampled + 2.0) - share_mean * share_mean) / (citer_sampled + 2.0);
+      n_r = citer_count * share_sum / citer_sampled;
+      n_r_variance = (double) citer_count * citer_count * share_variance;
+    }
+    double total = d + n_r;
+    double estimate = (d - 2.0 * n_b) / total;
+    double variance = 4.0 * d * d * both_variance / (total * total) +
+                      estimate * estimate * n_r_variance / (total * total);
+    double half_width = z * sqrt(variance);
+    out->sampled = direct_sampled + citer_sampled;
+    if (half_width <= tolerance) {
+      out->exact = false;
+      out->cdindex = estimate;
+      out->lower = estimate - half_width > -1.0 ? estimate - half_width : -1.0;
+      out->upper = estimate + half_width < 1.0 ? estimate + half_width : 1.0;
+      break;
+    }
+
+    /* stop sampling once it would cost as much as the exact index */
+    target *= 2;
+    exact = 2 * target >= direct_count + citer_count;
+  }
+
+  if (exact) {
+    CDComponents components;
+    frozen_cdindex_multi_components_as_of(frozen, id, &time_delta, 1, cutoff, &components);
+    out->cdindex = components.cdindex;
+    out->lower = components.cdindex;
+    out->upper = components.cdindex;
+    out->sampled = components.n_f + components.n_b + components.n_r;
+  }
+
+  if (in_times == NULL) {
+    free(direct);
+    free(citers);
+  }
+  free(starts);
+  free(run_ends);
 }
@@ -1,12 +1,32 @@
 #include <stdbool.h>
 
+/* types of vertex ids (including the neighbors in edge arrays) and of
+   timestamps; compiling with CDINDEX_COMPACT stores them in 32 bits, which
+   halves the memory of a graph and the memory traffic of the index functions
+   for graphs with fewer than 2^32 vertices and 32 bit timestamps (e.g., days) */
+#ifdef CDINDEX_COMPACT
+typedef unsigned int VertexId;
+typedef int Timestamp;
+#define MAX_VERTEX_ID 4294967295LL
+#define MIN_TIMESTAMP (-2147483647LL - 1)
+#define MAX_TIMESTAMP 2147483647LL
+#else
+typedef long long int VertexId;
+typedef long long int Timestamp;
+#define MAX_VERTEX_ID 9223372036854775807LL
+#define MIN_TIMESTAMP (-9223372036854775807LL - 1)
+#define MAX_TIMESTAMP 9223372036854775807LL
+#endif
+
 typedef struct Vertex {
-	long long int id;
-	long long int timestamp;
-  long long int *in_edges;
-  long long int *out_edges;
+	VertexId id;
+	Timestamp timestamp;
+  VertexId *in_edges;
+  VertexId *out_edges;
   long long int in_degree;
   long long int out_degree;
+  long long int in_capacity;
+  long long int out_capacity;
 } Vertex;
 
 typedef struct Edge {
@@ -18,22 +38,341 @@ typedef struct Graph {
     long long int vcount;
     Vertex *vs;
     long long int ecount;
+    bool out_edges_sorted;
+    long long int vcapacity;
+    long long int degree_hint;
+    struct Arena *arena;
 } Graph;
 
-#define CREATE_GRAPH(G) Graph G = {.vcount = 0, .ecount = 0}
+/* memory for the edge arrays of a graph, carved from large chunks, with a
+   free list per power of two size class for arrays that have grown; used
+   counts bytes handed out and reserved bytes taken from malloc */
+typedef struct Arena {
+    struct ArenaChunk *chunks;
+    char *next;
+    long long int remaining;
+    void *free_lists[64];
+    long long int used;
+    long long int reserved;
+} Arena;
+
+/* orders in which freeze_graph_ordered can store the vertices of a frozen graph */
+#define ORDER_IDS 0
+#define ORDER_TIME 1
+#define ORDER_DEGREE 2
+#define ORDER_RCM 3
+
+/* a read-only, compressed sparse row (csr) copy of a graph, in which the
+   neighbors of vertex i are stored at [offsets[i], offsets[i + 1]) of a
+   single contiguous array for each direction; when in_times is set, the in
+   edges of each vertex are ordered by timestamp and in_times holds the
+   timestamp of each in edge's source; when the vertices are reordered, the
+   arrays are indexed by storage position, public_ids holds the id of the
+   vertex at each position and internal_ids the position of each id (both are
+   NULL when vertices are stored in id order); when loaded from a snapshot the
+   arrays point into a read-only mapping of the file */
+typedef struct FrozenGraph {
+    long long int vcount;
+    long long int ecount;
+    Timestamp *timestamps;
+    long long int *in_offsets;
+    VertexId *in_edges;
+    long long int *out_offsets;
+    VertexId *out_edges;
+    Timestamp *in_times;
+    VertexId *public_ids;
+    VertexId *internal_ids;
+    void *mapping;
+    long long int mapping_size;
+} FrozenGraph;
+
+/* a read-only copy of a graph in which the sorted neighbors of each vertex
+   are stored as varints of the gaps between them (the first as a gap from 0);
+   the neighbors of vertex i take bytes [offsets[i], offsets[i + 1]) of the
+   data array for each direction */
+typedef struct CompressedGraph {
+    long long int vcount;
+    long long int ecount;
+    Timestamp *timestamps;
+    long long int *in_offsets;
+    unsigned char *in_data;
+    long long int *out_offsets;
+    unsigned char *out_data;
+} CompressedGraph;
+
+/* a graph as it stood at a cutoff time: vertices stamped after the cutoff are
+   hidden with their edges, so the measures of a view are those of the graph
+   rebuilt from the vertices up to the cutoff; exactly one of graph, frozen
+   and compressed is set, and a view copies nothing, so any number of views
+   can share one graph */
+typedef struct GraphView {
+    Graph *graph;
+    FrozenGraph *frozen;
+    CompressedGraph *compressed;
+    long long int cutoff;
+} GraphView;
+
+/* the parts of the CD index of a focal vertex at one time delta: of the "it"
+   vertices, n_f cite the focal vertex but none of its references, n_b cite
+   both and n_r cite only its references, so the CD index is
+   (n_f - n_b) / (n_f + n_b + n_r) (NAN if there are no "it" vertices); iindex
+   counts the citers of the focal vertex and the mCD index is cdindex * iindex */
+typedef struct CDComponents {
+    long long int n_f;
+    long long int n_b;
+    long long int n_r;
+    long long int iindex;
+    double cdindex;
+    double mcdindex;
+} CDComponents;
+
+/* an estimate of the CD index of a focal vertex from a sample of its "it"
+   vertices, with the bounds of a confidence interval; exact is set when the
+   index was computed exactly (lower and upper are then the index itself),
+   and sampled counts the "it" vertices classified */
+typedef struct CDEstimate {
+    double cdindex;
+    double lower;
+    double upper;
+    long long int sampled;
+    bool exact;
+} CDEstimate;
+
+/* reusable working memory for the index functions, holding a visited bitset
+   with one bit per vertex, the list of "it" vertices, the components of each
+   horizon for cdindex_multi, and the decoded out edges of the focal vertex of
+   a compressed graph or its references up to a cutoff; a scratch must not be
+   shared between threads */
+typedef struct Scratch {
+    long long int vcount;
+    unsigned long long int *visited;
+    long long int *it;
+    long long int it_capacity;
+    CDComponents *horizons;
+    long long int horizon_capacity;
+    VertexId *neighbors;
+    long long int neighbors_capacity;
+} Scratch;
+
+/* running CD index numerators (sums) and denominators (counts) of every
+   vertex of a graph at k time deltas, stored k per vertex, which are updated
+   as vertices are added */
+typedef struct Stream {
+    Graph *graph;
+    long long int k;
+    long long int *time_deltas;
+    long long int *sums;
+    long long int *counts;
+    long long int capacity;
+} Stream;
+
+/* buckets of the stats histograms: values below 8 have a bucket each, and
+   each larger power of two is split into four */
+#define STATS_BUCKETS 248
+
+/* totals and histograms of the CD index computations (see get_stats); the
+   histograms count calls by "it" set size and by nanoseconds taken */
+typedef struct IndexStats {
+    long long int calls;
+    long long int vertices_visited;
+    long long int in_edges_scanned;
+    long long int in_edges_in_window;
+    long long int it_vertices;
+    long long int membership_probes;
+    long long int nanoseconds;
+    long long int it_histogram[STATS_BUCKETS];
+    long long int time_histogram[STATS_BUCKETS];
+} IndexStats;
+
+/* counters of one CD index computation: the vertices whose in edges are
+   scanned, the in edges read and those in the time window, the "it" set size
+   and the membership searches and intersections run to classify it */
+typedef struct CallStats {
+    long long int vertices_visited;
+    long long int in_edges_scanned;
+    long long int in_edges_in_window;
+    long long int it_vertices;
+    long long int membership_probes;
+    long long int start;
+} CallStats;
+
+/* the counting statements in the index functions, compiled only into builds
+   with CDINDEX_STATS */
+#ifdef CDINDEX_STATS
+#define STATS(statement) statement
+#else
+#define STATS(statement)
+#endif
+
+/* distributions of the number of references of generated vertices */
+#define REFS_FIXED 0
+#define REFS_GEOMETRIC 1
+#define REFS_POWER_LAW 2
+
+/* parameters of a synthetic citation graph (see generate_citations) */
+typedef struct GeneratorOptions {
+    long long int vcount;
+    long long int periods;
+    double mean_refs;
+    int refs_distribution;
+    double refs_exponent;
+    long long int max_refs;
+    double attachment;
+    double recency;
+    long long int window;
+    unsigned long long int seed;
+} GeneratorOptions;
+
+/* instruction sets of the membership and intersection kernels */
+#define SIMD_SCALAR 0
+#define SIMD_AVX2 1
+#define SIMD_AVX512 2
+
+#define CREATE_GRAPH(G) Graph G = {.vcount = 0, .ecount = 0, .out_edges_sorted = true, .vcapacity = 0, .degree_hint = 0, .arena = NULL}
 
 /* function prototypes for utility.c */
+const char *error_message(int code);
 void raise_error(int code);
 bool in_int_array(long long int *array, long long int sizeof_array, long long int value);
 void add_to_int_array(long long int **array, long long int sizeof_array, long long int value, bool add_memory);
+int compare_int(const void *a, const void *b);
+int compare_id(const void *a, const void *b);
+bool in_sorted_id_array(VertexId *array, long long int sizeof_array, long long int value);
+void reserve_scratch(Scratch *scratch, long long int vcount);
+void reserve_scratch_horizons(Scratch *scratch, long long int k);
+void reserve_scratch_neighbors(Scratch *scratch, long long int count);
+void free_scratch(Scratch *scratch);
+Scratch *get_thread_scratch(long long int vcount);
+void free_thread_scratch(void);
+
+/* function prototypes for simd.c */
+int simd_supported_level(void);
+int simd_level(void);
+int set_simd_level(int level);
+bool in_id_array(VertexId *array, long long int sizeof_array, long long int value);
+bool sorted_id_arrays_intersect(VertexId *a, long long int sizeof_a, VertexId *b, long long int sizeof_b);
+
+/* function prototypes for stats.c */
+bool stats_enabled(void);
+void stats_start_call(CallStats *call);
+void stats_end_call(CallStats *call);
+void get_stats(IndexStats *stats);
+void reset_stats(void);
+double stats_percentile(long long int *histogram, double fraction);
 
 /* function prototypes for graph.c */
 bool is_graph_sane(Graph *graph); 
 void add_vertex(Graph *graph, long long int id, long long int timestamp);
 void add_edge(Graph *graph, long long int source_id, long long int target_id);
+bool try_add_edge(Graph *graph, long long int source_id, long long int target_id, int *error);
+bool graph_reserve(Graph *graph, long long int vcount, long long int ecount);
+void vertex_reserve(Graph *graph, long long int id, long long int in_degree, long long int out_degree);
+void graph_use_arena(Graph *graph);
+void graph_memory_usage(Graph *graph, long long int *used, long long int *reserved);
+bool vertex_fits(long long int id, long long int timestamp);
+bool bulk_load_graph(Graph *graph, long long int vcount, long long int *ids, long long int *timestamps, long long int ecount, Edge *edges, int *error);
+void sort_adjacency(Graph *graph);
 void free_graph(Graph *graph);
+void freeze_graph(Graph *graph, FrozenGraph *frozen);
+void freeze_graph_by_time(Graph *graph, FrozenGraph *frozen);
+void freeze_graph_ordered(Graph *graph, FrozenGraph *frozen, bool by_time, int ordering);
+void free_frozen_graph(FrozenGraph *frozen);
+
+/* function prototypes for arena.c */
+Arena *create_arena(void);
+VertexId *arena_alloc_ids(Arena *arena, long long int count, long long int *capacity);
+void arena_free_ids(Arena *arena, VertexId *array, long long int capacity);
+void free_arena(Arena *arena);
+
+/* function prototypes for stream.c */
+void init_stream(Stream *stream, Graph *graph, long long int *time_deltas, long long int k);
+void stream_add_vertex(Stream *stream, long long int id, long long int timestamp, long long int *refs, long long int ref_count);
+double stream_cdindex(Stream *stream, long long int id, long long int horizon);
+void free_stream(Stream *stream);
+
+/* function prototypes for snapshot.c */
+bool save_frozen_graph(FrozenGraph *frozen, const char *path, int *error);
+bool map_frozen_graph(FrozenGraph *frozen, const char *path, int *error);
+void unmap_frozen_graph(FrozenGraph *frozen);
+
+/* function prototypes for compressed.c */
+void compress_graph(Graph *graph, CompressedGraph *compressed);
+long long int compressed_graph_memory(CompressedGraph *compressed);
+void free_compressed_graph(CompressedGraph *compressed);
+
+/* function prototypes for generator.c */
+void default_generator_options(GeneratorOptions *options);
+void generate_citations(GeneratorOptions *options, long long int *timestamps, Edge **edges, long long int *ecount);
 
 /* function prototypes for cdindex.c */
 double cdindex(Graph *graph, long long int id, long long int time_delta);
+void cdindex_multi(Graph *graph, long long int id, long long int *time_deltas, long long int k, double *out);
+void cdindex_multi_counts(Graph *graph, long long int id, long long int *time_deltas, long long int k, long long int *sums, long long int *counts);
+void cdindex_multi_components(Graph *graph, long long int id, long long int *time_deltas, long long int k, CDComponents *out);
+void cdindex_multi_components_as_of(Graph *graph, long long int id, long long int *time_deltas, long long int k, long long int cutoff, CDComponents *out);
+void cdindex_components(Graph *graph, long long int id, long long int time_delta, CDComponents *out);
 double mcdindex(Graph *graph, long long int id, long long int time_delta);
 long long int iindex(Graph *graph, long long int id, long long int time_delta);
+double frozen_cdindex(FrozenGraph *frozen, long long int id, long long int time_delta);
+void frozen_cdindex_multi(FrozenGraph *frozen, long long int id, long long int *time_deltas, long long int k, double *out);
+void frozen_cdindex_multi_components(FrozenGraph *frozen, long long int id, long long int *time_deltas, long long int k, CDComponents *out);
+void frozen_cdindex_multi_components_as_of(FrozenGraph *frozen, long long int id, long long int *time_deltas, long long int k, long long int cutoff, CDComponents *out);
+void frozen_cdindex_components(FrozenGraph *frozen, long long int id, long long int time_delta, CDComponents *out);
+double frozen_mcdindex(FrozenGraph *frozen, long long int id, long long int time_delta);
+long long int frozen_iindex(FrozenGraph *frozen, long long int id, long long int time_delta);
+void cdindex_batch(Graph *graph, long long int *ids, long long int n, long long int time_delta, double *out);
+void mcdindex_batch(Graph *graph, long long int *ids, long long int n, long long int time_delta, double *out);
+void iindex_batch(Graph *graph, long long int *ids, long long int n, long long int time_delta, long long int *out);
+void frozen_cdindex_batch(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, double *out);
+void frozen_mcdindex_batch(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, double *out);
+void frozen_iindex_batch(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, long long int *out);
+void cdindex_multi_batch(Graph *graph, long long int *ids, long long int n, long long int *time_deltas, long long int k, double *out);
+void frozen_cdindex_multi_batch(FrozenGraph *frozen, long long int *ids, long long int n, long long int *time_deltas, long long int k, double *out);
+double compressed_cdindex(CompressedGraph *compressed, long long int id, long long int time_delta);
+void compressed_cdindex_multi(CompressedGraph *compressed, long long int id, long long int *time_deltas, long long int k, double *out);
+void compressed_cdindex_multi_components(CompressedGraph *compressed, long long int id, long long int *time_deltas, long long int k, CDComponents *out);
+void compressed_cdindex_multi_components_as_of(CompressedGraph *compressed, long long int id, long long int *time_deltas, long long int k, long long int cutoff, CDComponents *out);
+void compressed_cdindex_components(CompressedGraph *compressed, long long int id, long long int time_delta, CDComponents *out);
+double compressed_mcdindex(CompressedGraph *compressed, long long int id, long long int time_delta);
+long long int compressed_iindex(CompressedGraph *compressed, long long int id, long long int time_delta);
+void compressed_cdindex_batch(CompressedGraph *compressed, long long int *ids, long long int n, long long int time_delta, double *out);
+void compressed_mcdindex_batch(CompressedGraph *compressed, long long int *ids, long long int n, long long int time_delta, double *out);
+void compressed_iindex_batch(CompressedGraph *compressed, long long int *ids, long long int n, long long int time_delta, long long int *out);
+void compressed_cdindex_multi_batch(CompressedGraph *compressed, long long int *ids, long long int n, long long int *time_deltas, long long int k, double *out);
+void cdindex_all_counts(Graph *graph, long long int *time_deltas, long long int k, long long int *n_f, long long int *n_b, long long int *n_r);
+void frozen_cdindex_all_counts(FrozenGraph *frozen, long long int *time_deltas, long long int k, long long int *n_f, long long int *n_b, long long int *n_r);
+void cdindex_all(Graph *graph, long long int *time_deltas, long long int k, double *out);
+void frozen_cdindex_all(FrozenGraph *frozen, long long int *time_deltas, long long int k, double *out);
+void frozen_cdindex_estimate(FrozenGraph *frozen, long long int id, long long int time_delta, double tolerance, double confidence, long long int exact_below, unsigned long long int seed, CDEstimate *out);
+void frozen_cdindex_estimate_as_of(FrozenGraph *frozen, long long int id, long long int time_delta, double tolerance, double confidence, long long int exact_below, unsigned long long int seed, long long int cutoff, CDEstimate *out);
+void view_cdindex_all_counts(GraphView *view, long long int *time_deltas, long long int k, long long int *n_f, long long int *n_b, long long int *n_r);
+void view_cdindex_all(GraphView *view, long long int *time_deltas, long long int k, double *out);
+
+/* function prototypes for parallel.c */
+void parallel_cdindex(Graph *graph, long long int *ids, long long int n, long long int time_delta, int threads, double *out);
+void parallel_mcdindex(Graph *graph, long long int *ids, long long int n, long long int time_delta, int threads, double *out);
+void parallel_iindex(Graph *graph, long long int *ids, long long int n, long long int time_delta, int threads, long long int *out);
+void frozen_parallel_cdindex(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, int threads, double *out);
+void frozen_parallel_mcdindex(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, int threads, double *out);
+void frozen_parallel_iindex(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, int threads, long long int *out);
+void parallel_cdindex_multi(Graph *graph, long long int *ids, long long int n, long long int *time_deltas, long long int k, int threads, double *out);
+void frozen_parallel_cdindex_multi(FrozenGraph *frozen, long long int *ids, long long int n, long long int *time_deltas, long long int k, int threads, double *out);
+void view_parallel_cdindex(GraphView *view, long long int *ids, long long int n, long long int time_delta, int threads, double *out);
+void view_parallel_mcdindex(GraphView *view, long long int *ids, long long int n, long long int time_delta, int threads, double *out);
+void view_parallel_iindex(GraphView *view, long long int *ids, long long int n, long long int time_delta, int threads, long long int *out);
+void view_parallel_cdindex_multi(GraphView *view, long long int *ids, long long int n, long long int *time_deltas, long long int k, int threads, double *out);
+
+/* function prototypes for view.c */
+long long int view_timestamp(GraphView *view, long long int id);
+bool view_has_vertex(GraphView *view, long long int id);
+void view_cdindex_multi_components(GraphView *view, long long int id, long long int *time_deltas, long long int k, CDComponents *out);
+void view_cdindex_components(GraphView *view, long long int id, long long int time_delta, CDComponents *out);
+void view_cdindex_multi(GraphView *view, long long int id, long long int *time_deltas, long long int k, double *out);
+double view_cdindex(GraphView *view, long long int id, long long int time_delta);
+double view_mcdindex(GraphView *view, long long int id, long long int time_delta);
+long long int view_iindex(GraphView *view, long long int id, long long int time_delta);
+void view_cdindex_estimate(GraphView *view, long long int id, long long int time_delta, double tolerance, double confidence, long long int exact_below, unsigned long long int seed, CDEstimate *out);
+void view_cdindex_batch(GraphView *view, long long int *ids, long long int n, long long int time_delta, double *out);
+void view_mcdindex_batch(GraphView *view, long long int *ids, long long int n, long long int time_delta, double *out);
+void view_iindex_batch(GraphView *view, long long int *ids, long long int n, long long int time_delta, long long int *out);
+void view_cdindex_multi_batch(GraphView *view, long long int *ids, long long int n, long long int *time_deltas, long long int k, double *out);
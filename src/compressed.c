@@ -0,0 +1,180 @@
+/*
+  cdindex library.
+  Copyright (C) 2017 Russell J. Funk <russellfunk@gmail.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "cdindex.h"
+
+/**
+ * \function encode_list
+ * \brief Encode a sorted list of vertex ids as varints of their gaps.
+ *
+ * Each varint holds 7 bits per byte, least significant first, with the high
+ * bit set on every byte but the last.
+ *
+ * \param ids The vertex ids, in increasing order.
+ * \param count The number of ids.
+ * \param out The buffer to write (or NULL to only measure the encoding).
+ *
+ * \return The number of bytes of the encoding.
+ */
+static long long int encode_list(VertexId *ids, long long int count, unsigned char *out) {
+  long long int bytes = 0;
+  unsigned long long int previous = 0;
+  for (long long int i = 0; i < count; i++) {
+    unsigned long long int gap = (unsigned long long int) ids[i] - previous;
+    previous = ids[i];
+    while (gap >= 0x80) {
+      if (out != NULL) {
+        out[bytes] = (unsigned char) (gap | 0x80);
+      }
+      gap >>= 7;
+      bytes++;
+    }
+    if (out != NULL) {
+      out[bytes] = (unsigned char) gap;
+    }
+    bytes++;
+  }
+  return bytes;
+}
+
+/**
+ * \function sorted_copy
+ * \brief Copy a list of vertex ids into a buffer and sort it.
+ *
+ * \param ids The vertex ids.
+ * \param count The number of ids.
+ * \param sorted The buffer (at least count ids).
+ * \param is_sorted Whether ids is already in increasing order.
+ *
+ * \return The sorted ids (ids itself if it was already sorted).
+ */
+static VertexId *sorted_copy(VertexId *ids, long long int count, VertexId *sorted, bool is_sorted) {
+  if (is_sorted) {
+    return ids;
+  }
+  memcpy(sorted, ids, count * sizeof(VertexId));
+  qsort(sorted, count, sizeof(VertexId), compare_id);
+  return sorted;
+}
+
+/**
+ * \function encode_direction
+ * \brief Encode the in or out edges of every vertex of a graph.
+ *
+ * The lists are measured in a first pass so the data is allocated once.
+ *
+ * \param graph The input graph.
+ * \param out_edges Whether to encode the out edges (otherwise the in edges).
+ * \param offsets The byte offsets to fill (vcount + 1).
+ * \param sorted A buffer holding as many ids as the largest list.
+ *
+ * \return The encoded lists.
+ */
+static unsigned char *encode_direction(Graph *graph, bool out_edges, long long int *offsets, VertexId *sorted) {
+  bool is_sorted = out_edges && graph->out_edges_sorted;
+  offsets[0] = 0;
+  for (long long int i = 0; i < graph->vcount; i++) {
+    VertexId *ids = out_edges ? graph->vs[i].out_edges : graph->vs[i].in_edges;
+    long long int count = out_edges ? graph->vs[i].out_degree : graph->vs[i].in_degree;
+    ids = sorted_copy(ids, count, sorted, is_sorted);
+    offsets[i+1] = offsets[i] + encode_list(ids, count, NULL);
+  }
+
+  unsigned char *data = malloc(offsets[graph->vcount] > 0 ? offsets[graph->vcount] : 1);
+  if (data==NULL) {
+    raise_error(0);
+  }
+  for (long long int i = 0; i < graph->vcount; i++) {
+    VertexId *ids = out_edges ? graph->vs[i].out_edges : graph->vs[i].in_edges;
+    long long int count = out_edges ? graph->vs[i].out_degree : graph->vs[i].in_degree;
+    ids = sorted_copy(ids, count, sorted, is_sorted);
+    encode_list(ids, count, data + offsets[i]);
+  }
+  return data;
+}
+
+/**
+ * \function compress_graph
+ * \brief Copy a graph into a compressed graph.
+ *
+ * Citation graphs have small gaps between the sorted neighbors of most
+ * vertices, so most ids take one or two bytes instead of sizeof(VertexId).
+ * The graph must not change during the call, and the compressed graph does
+ * not follow later changes to the graph.
+ *
+ * \param graph The input graph.
+ * \param compressed The compressed graph to fill (free with free_compressed_graph).
+ */
+void compress_graph(Graph *graph, CompressedGraph *compressed) {
+
+  compressed->vcount = graph->vcount;
+  compressed->ecount = graph->ecount;
+  compressed->timestamps = malloc((graph->vcount > 0 ? graph->vcount : 1) * sizeof(Timestamp));
+  compressed->in_offsets = malloc((graph->vcount + 1) * sizeof(long long int));
+  compressed->out_offsets = malloc((graph->vcount + 1) * sizeof(long long int));
+  long long int max_degree = 1;
+  for (long long int i = 0; i < graph->vcount; i++) {
+    max_degree = graph->vs[i].in_degree > max_degree ? graph->vs[i].in_degree : max_degree;
+    max_degree = graph->vs[i].out_degree > max_degree ? graph->vs[i].out_degree : max_degree;
+  }
+  VertexId *sorted = malloc(max_degree * sizeof(VertexId));
+  if (compressed->timestamps==NULL || compressed->in_offsets==NULL ||
+      compressed->out_offsets==NULL || sorted==NULL) {
+    raise_error(0);
+  }
+
+  for (long long int i = 0; i < graph->vcount; i++) {
+    compressed->timestamps[i] = graph->vs[i].timestamp;
+  }
+  compressed->in_data = encode_direction(graph, false, compressed->in_offsets, sorted);
+  compressed->out_data = encode_direction(graph, true, compressed->out_offsets, sorted);
+
+  free(sorted);
+}
+
+/**
+ * \function compressed_graph_memory
+ * \brief Report the memory taken by a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ *
+ * \return The bytes of its timestamps, offsets and encoded edges.
+ */
+long long int compressed_graph_memory(CompressedGraph *compressed) {
+  return compressed->vcount * sizeof(Timestamp) +
+         2 * (compressed->vcount + 1) * sizeof(long long int) +
+         compressed->in_offsets[compressed->vcount] +
+         compressed->out_offsets[compressed->vcount];
+}
+
+/**
+ * \function free_compressed_graph
+ * \brief Free memory taken by a compressed graph.
+ *
+ * \param compressed The input compressed graph.
+ */
+void free_compressed_graph(CompressedGraph *compressed) {
+  free(compressed->timestamps);
+  free(compressed->in_offsets);
+  free(compressed->in_data);
+  free(compressed->out_offsets);
+  free(compressed->out_data);
+}
@@ -0,0 +1,193 @@
+/*
+  cdindex library.
+  Copyright (C) 2017 Russell J. Funk <russellfunk@gmail.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include "cdindex.h"
+
+/**
+ * \function next_random
+ * \brief Advance a xorshift64 generator.
+ *
+ * \param state The generator state (not zero).
+ *
+ * \return The next 64 random bits.
+ */
+static unsigned long long int next_random(unsigned long long int *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+/**
+ * \function random_below
+ * \brief Draw a random integer in [0, n).
+ *
+ * \param state The generator state.
+ * \param n The upper bound (at least 1).
+ *
+ * \return The random integer.
+ */
+static long long int random_below(unsigned long long int *state, long long int n) {
+  return (long long int) (next_random(state) % (unsigned long long int) n);
+}
+
+/**
+ * \function random_unit
+ * \brief Draw a random real in (0, 1].
+ *
+ * \param state The generator state.
+ *
+ * \return The random real.
+ */
+static double random_unit(unsigned long long int *state) {
+  return ((next_random(state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * \function draw_reference_count
+ * \brief Draw the number of references of a vertex.
+ *
+ * \param options The generator options.
+ * \param state The generator state.
+ *
+ * \return The number of references, at most options->max_refs.
+ */
+static long long int draw_reference_count(GeneratorOptions *options, unsigned long long int *state) {
+  double count = options->mean_refs;
+  if (options->refs_distribution == REFS_GEOMETRIC) {
+    /* failures before the first success, with success probability 1 / (mean + 1) */
+    count = floor(log(random_unit(state)) / log(options->mean_refs / (options->mean_refs + 1.0)));
+  }
+  else if (options->refs_distribution == REFS_POWER_LAW) {
+    /* a Pareto draw, with the minimum that gives the mean before capping */
+    double exponent = options->refs_exponent;
+    double minimum = options->mean_refs * (exponent - 2.0) / (exponent - 1.0);
+    count = floor(minimum * pow(random_unit(state), -1.0 / (exponent - 1.0)));
+  }
+  long long int refs = (long long int) (count + 0.5);
+  return refs < options->max_refs ? refs : options->max_refs;
+}
+
+/**
+ * \function default_generator_options
+ * \brief Fill generator options with the defaults.
+ *
+ * The defaults give 100000 vertices over 50 periods citing 20 earlier
+ * vertices each, 80% of them by preferential attachment.
+ *
+ * \param options The options to fill.
+ */
+void default_generator_options(GeneratorOptions *options) {
+  options->vcount = 100000;
+  options->periods = 50;
+  options->mean_refs = 20.0;
+  options->refs_distribution = REFS_FIXED;
+  options->refs_exponent = 2.5;
+  options->max_refs = 1000;
+  options->attachment = 0.8;
+  options->recency = 0.0;
+  options->window = 5;
+  options->seed = 88172645463325252ULL;
+}
+
+/**
+ * \function generate_citations
+ * \brief Generate a time-stamped citation DAG.
+ *
+ * The vertices are split evenly over options->periods timestamps, in id
+ * order, and each cites earlier-period vertices only. The number of
+ * references of a vertex is drawn from options->refs_distribution. Each
+ * reference copies the target of a uniformly random earlier edge with
+ * probability options->attachment, so vertices are cited in proportion to
+ * their in degree and in degrees follow a power law with exponent about
+ * 1 + 1 / attachment. Otherwise the target is uniformly random among the
+ * vertices of the previous options->window periods with probability
+ * options->recency, and among all earlier vertices if not. Repeated
+ * references are dropped, so a vertex may cite fewer vertices than drawn.
+ * Generation takes time linear in the number of edges and is reproducible
+ * for a given seed.
+ *
+ * \param options The generator options.
+ * \param timestamps Filled with the timestamp of each vertex (vcount).
+ * \param edges Set to the edges, grouped by source in increasing order (free
+ *              with free).
+ * \param ecount Set to the number of edges.
+ */
+void generate_citations(GeneratorOptions *options, long long int *timestamps, Edge **edges, long long int *ecount) {
+
+  long long int vcount = options->vcount;
+  long long int per_period = options->periods > 0 && vcount / options->periods > 0 ? vcount / options->periods : 1;
+  long long int capacity = vcount * (long long int) ceil(options->mean_refs) + 16;
+  unsigned long long int state = options->seed != 0 ? options->seed : 1;
+  unsigned long long int *cited = calloc((vcount + 63) / 64 + 1, sizeof(unsigned long long int));
+  *edges = malloc(capacity * sizeof(Edge));
+  if (cited==NULL || *edges==NULL) {
+    raise_error(0);
+  }
+
+  long long int count = 0;
+  for (long long int i = 0; i < vcount; i++) {
+    timestamps[i] = i / per_period;
+    long long int earlier = i / per_period * per_period;
+    if (earlier == 0) {
+      continue;
+    }
+    long long int recent = (i / per_period - options->window) * per_period;
+    recent = recent > 0 ? recent : 0;
+    long long int refs = draw_reference_count(options, &state);
+    refs = refs < earlier ? refs : earlier;
+
+    long long int first_edge = count;
+    for (long long int r = 0; r < refs; r++) {
+      long long int target;
+      if (first_edge > 0 && random_unit(&state) <= options->attachment) {
+        target = (*edges)[random_below(&state, first_edge)].target_id;
+      }
+      else if (random_unit(&state) <= options->recency) {
+        target = recent + random_below(&state, earlier - recent);
+      }
+      else {
+        target = random_below(&state, earlier);
+      }
+      if (cited[target >> 6] & (1ULL << (target & 63))) {
+        continue;
+      }
+      cited[target >> 6] |= 1ULL << (target & 63);
+      if (count == capacity) {
+        capacity *= 2;
+        Edge *tmp = realloc(*edges, capacity * sizeof(Edge));
+        if (tmp==NULL) {
+          raise_error(0);
+        }
+        *edges = tmp;
+      }
+      (*edges)[count].source_id = i;
+      (*edges)[count].target_id = target;
+      count++;
+    }
+    for (long long int e = first_edge; e < count; e++) {
+      cited[(*edges)[e].target_id >> 6] = 0;
+    }
+  }
+
+  free(cited);
+  *ecount = count;
+}
@@ -19,8 +19,218 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
 #include "cdindex.h"
 
+/* The largest number of elements of a type an array can be asked to hold */
+#define MAX_ELEMENTS(type) ((long long int) (PTRDIFF_MAX / sizeof(type)))
+
+/* The largest initial edge array size a degree hint sets; arrays of vertices
+   with more edges grow geometrically as usual */
+#define MAX_DEGREE_HINT 1024LL
+
+/**
+ * \function allocate_array
+ * \brief Allocate an array, raising an error on failure.
+ *
+ * \param count The number of elements in the array.
+ * \param size The size of each element.
+ *
+ * \return The allocated array.
+ */
+static void *allocate_array(long long int count, size_t size) {
+  void *array = malloc((count > 0 ? count : 1) * size);
+  if (array==NULL) {
+    raise_error(0);
+  }
+  return array;
+}
+
+/**
+ * \function reserve_id_array
+ * \brief Make sure a vertex id array can hold a number of elements.
+ *
+ * The capacity at least doubles whenever the array grows, so appending one
+ * element at a time costs amortized constant time. Graphs with an arena
+ * take the memory from the arena instead of malloc.
+ *
+ * \param graph The graph the array belongs to.
+ * \param array The input array (unallocated if its capacity is 0).
+ * \param capacity The capacity of the input array, updated if it grows.
+ * \param needed The number of elements the array must hold.
+ */
+static void reserve_id_array(Graph *graph, VertexId **array, long long int *capacity, long long int needed) {
+  if (needed <= *capacity) {
+    return;
+  }
+  if (needed > MAX_ELEMENTS(VertexId)) {
+    raise_error(0);
+  }
+  long long int new_capacity = 2 * *capacity > needed ? 2 * *capacity : needed;
+  if (new_capacity > MAX_ELEMENTS(VertexId)) {
+    new_capacity = needed;
+  }
+  if (graph->arena != NULL) {
+    VertexId *tmp = arena_alloc_ids(graph->arena, new_capacity, &new_capacity);
+    if (*capacity > 0) {
+      memcpy(tmp, *array, *capacity * sizeof(VertexId));
+      arena_free_ids(graph->arena, *array, *capacity);
+    }
+    *array = tmp;
+    *capacity = new_capacity;
+    return;
+  }
+  VertexId *tmp = realloc(*capacity > 0 ? *array : NULL, new_capacity * sizeof(VertexId));
+  if (tmp==NULL) {
+    raise_error(0);
+  }
+  *array = tmp;
+  *capacity = new_capacity;
+}
+
+/**
+ * \function grow_vertex_array
+ * \brief Try to make the vertex array of a graph hold a number of vertices.
+ *
+ * \param graph The input graph.
+ * \param needed The number of vertices the array must hold.
+ *
+ * \return Whether the array holds them (it is unchanged if not).
+ */
+static bool grow_vertex_array(Graph *graph, long long int needed) {
+  if (needed <= graph->vcapacity) {
+    return true;
+  }
+  if (needed > MAX_ELEMENTS(Vertex)) {
+    return false;
+  }
+  long long int new_capacity = 2 * graph->vcapacity > needed ? 2 * graph->vcapacity : needed;
+  if (new_capacity > MAX_ELEMENTS(Vertex)) {
+    new_capacity = needed;
+  }
+  Vertex *tmp = realloc(graph->vcapacity > 0 ? graph->vs : NULL, new_capacity * sizeof(Vertex));
+  if (tmp==NULL) {
+    return false;
+  }
+  graph->vs = tmp;
+  graph->vcapacity = new_capacity;
+  return true;
+}
+
+/**
+ * \function reserve_vertex_array
+ * \brief Make sure the vertex array of a graph can hold a number of vertices.
+ *
+ * \param graph The input graph.
+ * \param needed The number of vertices the array must hold.
+ */
+static void reserve_vertex_array(Graph *graph, long long int needed) {
+  if (!grow_vertex_array(graph, needed)) {
+    raise_error(0);
+  }
+}
+
+/**
+ * \function init_vertex
+ * \brief Set up the next vertex of a graph, which must fit in its vertex array.
+ *
+ * \param graph The input graph.
+ * \param timestamp The new vertex timestamp.
+ */
+static void init_vertex(Graph *graph, long long int timestamp) {
+  Vertex *vertex = &graph->vs[graph->vcount];
+  vertex->id = graph->vcount;
+  vertex->timestamp = timestamp;
+  vertex->in_degree = 0;
+  vertex->out_degree = 0;
+  vertex->in_capacity = 0;
+  vertex->out_capacity = 0;
+  graph->vcount++;
+}
+
+/**
+ * \function graph_reserve
+ * \brief Reserve memory ahead of adding vertices and edges one at a time.
+ *
+ * Room is made for vcount vertices in total, and the average degree implied
+ * by ecount becomes the initial size of the edge arrays of vertices that
+ * have none, so that most of them never need to grow. The hint is capped at
+ * MAX_DEGREE_HINT and at vcount.
+ *
+ * \param graph The input graph.
+ * \param vcount The expected total number of vertices (not negative).
+ * \param ecount The expected total number of edges (not negative).
+ *
+ * \return Whether the memory could be reserved (the graph is unchanged if not).
+ */
+bool graph_reserve(Graph *graph, long long int vcount, long long int ecount) {
+  if (!grow_vertex_array(graph, vcount)) {
+    return false;
+  }
+  if (vcount > 0 && ecount > 0) {
+    long long int hint = ecount / vcount + (ecount % vcount != 0);
+    hint = hint < vcount ? hint : vcount;
+    graph->degree_hint = hint < MAX_DEGREE_HINT ? hint : MAX_DEGREE_HINT;
+  }
+  return true;
+}
+
+/**
+ * \function graph_use_arena
+ * \brief Make an empty graph take its edge arrays from an arena.
+ *
+ * The arrays are then carved from large chunks, which saves the overhead of
+ * a malloc per array and lets free_graph release a few chunks instead of
+ * every array.
+ *
+ * \param graph The input graph (must have no vertices).
+ */
+void graph_use_arena(Graph *graph) {
+  if (graph->vcount > 0) {
+    raise_error(6);
+  }
+  if (graph->arena == NULL) {
+    graph->arena = create_arena();
+  }
+}
+
+/**
+ * \function graph_memory_usage
+ * \brief Report the memory taken by the vertices and edge arrays of a graph.
+ *
+ * \param graph The input graph.
+ * \param used Set to the bytes holding vertices and edges.
+ * \param reserved Set to the bytes allocated for them, including spare capacity
+ *                 (and, with an arena, memory not yet handed out).
+ */
+void graph_memory_usage(Graph *graph, long long int *used, long long int *reserved) {
+  long long int capacity = 0;
+  for (long long int i = 0; i < graph->vcount; i++) {
+    capacity += graph->vs[i].in_capacity + graph->vs[i].out_capacity;
+  }
+  *used = graph->vcount * sizeof(Vertex) + 2 * graph->ecount * sizeof(VertexId);
+  *reserved = graph->vcapacity * sizeof(Vertex) +
+              (graph->arena != NULL ? graph->arena->reserved : capacity * (long long int) sizeof(VertexId));
+}
+
+/**
+ * \function vertex_reserve
+ * \brief Reserve memory for the edges of a vertex ahead of adding them.
+ *
+ * \param graph The input graph.
+ * \param id The vertex id.
+ * \param in_degree The expected total in degree of the vertex.
+ * \param out_degree The expected total out degree of the vertex.
+ */
+void vertex_reserve(Graph *graph, long long int id, long long int in_degree, long long int out_degree) {
+  if (id < 0 || id >= graph->vcount) {
+    raise_error(2);
+  }
+  reserve_id_array(graph, &graph->vs[id].in_edges, &graph->vs[id].in_capacity, in_degree);
+  reserve_id_array(graph, &graph->vs[id].out_edges, &graph->vs[id].out_capacity, out_degree);
+}
+
 /**
  * \function is_graph_sane
  * \brief Run a few basic (not comprehensive) checks on graph data structure.
@@ -53,6 +263,22 @@ bool is_graph_sane(Graph *graph) {
   return sane;
 }
 
+/**
+ * \function vertex_fits
+ * \brief See if a vertex id and timestamp fit the types of the graph.
+ *
+ * This only fails when compiled with CDINDEX_COMPACT, for ids of 2^32 and
+ * above and timestamps outside the 32 bit range.
+ *
+ * \param id The vertex id.
+ * \param timestamp The vertex timestamp.
+ *
+ * \return Whether the vertex can be stored.
+ */
+bool vertex_fits(long long int id, long long int timestamp) {
+  return id <= MAX_VERTEX_ID && timestamp >= MIN_TIMESTAMP && timestamp <= MAX_TIMESTAMP;
+}
+
 /**
  * \function add_vertex
  * \brief Add a vertex to a graph (note the graph must have memory allocated).
@@ -63,30 +289,73 @@ bool is_graph_sane(Graph *graph) {
  */
 void add_vertex(Graph *graph, long long int id, long long int timestamp) {
 
-  /* allocate memory for a vertex */
-  Vertex *tmp;
-  if (graph->vcount == 0) {
-    tmp = malloc(sizeof(Vertex));
+  /* the new vertex id should come at the end of the list */
+  if (id != graph->vcount) {
+    raise_error(1);
   }
-  else {
-    tmp = realloc(graph->vs, (graph->vcount + 1) * sizeof(Vertex));
+  if (!vertex_fits(id, timestamp)) {
+    raise_error(7);
   }
-  if (tmp==NULL) {
-    raise_error(0);
+
+  /* make room for the vertex, growing the array geometrically */
+  reserve_vertex_array(graph, graph->vcount + 1);
+  init_vertex(graph, timestamp);
+}
+
+/**
+ * \function try_add_edge
+ * \brief Add a edge to a graph, reporting invalid edges instead of exiting.
+ *
+ * The endpoints and the absence of the edge are checked once, here, so
+ * callers need not look up the out edges of the source beforehand.
+ *
+ * \param graph The input graph.
+ * \param source_id The source vertex id.
+ * \param target_id The target vertex id.
+ * \param error Set to the error code on failure (2 if a vertex is not in the
+ *              graph, 3 if the edge already is).
+ *
+ * \return True if the edge was added, False otherwise.
+ */
+bool try_add_edge(Graph *graph, long long int source_id, long long int target_id, int *error) {
+
+  /* confirm vertices are in graph */
+  if (source_id < 0 || source_id >= graph->vcount || target_id < 0 || target_id >= graph->vcount) {
+    *error = 2;
+    return false;
   }
-  else {
-    graph->vs = tmp;
+
+  /* confirm edge is not already in graph */
+  if (graph->out_edges_sorted ?
+      in_sorted_id_array(graph->vs[source_id].out_edges, graph->vs[source_id].out_degree, target_id) :
+      in_id_array(graph->vs[source_id].out_edges, graph->vs[source_id].out_degree, target_id)) {
+    *error = 3;
+    return false;
   }
 
-  /* the new vertex id should come at the end of the list */
-  if (id != graph->vcount) {
-    raise_error(1);
+  /* out edges stay sorted only if the new target comes last */
+  if (graph->vs[source_id].out_degree > 0 &&
+      graph->vs[source_id].out_edges[graph->vs[source_id].out_degree - 1] > target_id) {
+    graph->out_edges_sorted = false;
   }
-  graph->vs[graph->vcount].id = graph->vcount;
-	graph->vs[graph->vcount].timestamp = timestamp;
-  graph->vs[graph->vcount].in_degree = 0;
-  graph->vs[graph->vcount].out_degree = 0;
-  graph->vcount++;
+
+  /* make room for the new source_id and target_id, starting from the
+     degree hint and growing the arrays geometrically */
+  Vertex *source = &graph->vs[source_id];
+  Vertex *target = &graph->vs[target_id];
+  long long int initial = graph->degree_hint > 0 ? graph->degree_hint : 1;
+  reserve_id_array(graph, &source->out_edges, &source->out_capacity,
+                    source->out_capacity > 0 ? source->out_degree + 1 : initial);
+  reserve_id_array(graph, &target->in_edges, &target->in_capacity,
+                    target->in_capacity > 0 ? target->in_degree + 1 : initial);
+
+  /* append the new source_id and target_id, incrementing degree counts */
+  source->out_edges[source->out_degree++] = target_id;
+  target->in_edges[target->in_degree++] = source_id;
+
+  /* increment graph ecount */
+  graph->ecount++;
+  return true;
 }
 
 /**
@@ -98,62 +367,178 @@ void add_vertex(Graph *graph, long long int id, long long int timestamp) {
  * \param target_id The target vertex id.
  */
 void add_edge(Graph *graph, long long int source_id, long long int target_id) {
+  int error;
+  if (!try_add_edge(graph, source_id, target_id, &error)) {
+    raise_error(error);
+  }
+}
 
-  /* confirm vertices are in graph */
-  if (source_id >= graph->vcount || target_id >= graph->vcount) {
-    raise_error(2);
+/**
+ * \function bulk_load_graph
+ * \brief Add many vertices and edges to a graph at once.
+ *
+ * Edges are grouped by source with a counting sort and duplicates are found by
+ * sorting each group, so loading costs O(V + E log d) instead of the O(d^2)
+ * per vertex of repeated add_edge calls. The input is checked before the graph
+ * is touched, so on failure the graph is left unchanged. The new out edges of
+ * each vertex are appended in increasing id order, so the out edges of a graph
+ * loaded in a single call are sorted.
+ *
+ * \param graph The input graph.
+ * \param vcount The number of vertices to add.
+ * \param ids The new vertex ids (must continue sequentially from the graph vcount).
+ * \param timestamps The new vertex timestamps.
+ * \param ecount The number of edges to add.
+ * \param edges The new edges (between existing and/or new vertices).
+ * \param error Set to the error code (see raise_error) on failure.
+ *
+ * \return Whether the vertices and edges were added.
+ */
+bool bulk_load_graph(Graph *graph, long long int vcount, long long int *ids, long long int *timestamps, long long int ecount, Edge *edges, int *error) {
+
+  long long int i, j;
+  long long int total_vcount = graph->vcount + vcount;
+
+  /* the new vertex ids should come at the end of the list */
+  for (i = 0; i < vcount; i++) {
+    if (ids[i] != graph->vcount + i) {
+      *error = 1;
+      return false;
+    }
+    if (!vertex_fits(ids[i], timestamps[i])) {
+      *error = 7;
+      return false;
+    }
   }
 
   /* confirm vertices are in graph */
-  /*
-  long long int vs_ids[graph->vcount]; 
-  for (long long int i = 0; i < graph->vcount; i++) {
-     vs_ids[i] = graph->vs[i].id;
-  }
-  if (!in_int_array(vs_ids, graph->vcount, source_id) || !in_int_array(vs_ids, graph->vcount, target_id)) {
-    raise_error(2);
-  } 
-  */
-  
-  /* confirm edge is not already in graph */
-  else if (in_int_array(graph->vs[source_id].out_edges, graph->vs[source_id].out_degree, target_id)) {
-    raise_error(3);
+  for (i = 0; i < ecount; i++) {
+    if (edges[i].source_id < 0 || edges[i].source_id >= total_vcount ||
+        edges[i].target_id < 0 || edges[i].target_id >= total_vcount) {
+      *error = 2;
+      return false;
+    }
   }
-  else {
 
-    /* memory reallocation flags */
-    bool reallocate_out_edges = true;
-    bool reallocate_in_edges = true;
+  /* group targets by source with a counting sort */
+  long long int *offsets = allocate_array(total_vcount + 1, sizeof(long long int));
+  VertexId *targets = allocate_array(ecount, sizeof(VertexId));
+  long long int *counts = allocate_array(total_vcount, sizeof(long long int));
+  for (i = 0; i <= total_vcount; i++) {
+    offsets[i] = 0;
+  }
+  for (i = 0; i < ecount; i++) {
+    offsets[edges[i].source_id + 1]++;
+  }
+  for (i = 0; i < total_vcount; i++) {
+    offsets[i+1] += offsets[i];
+    counts[i] = offsets[i];
+  }
+  for (i = 0; i < ecount; i++) {
+    targets[counts[edges[i].source_id]++] = edges[i].target_id;
+  }
 
-    /* allocate memory for source_id out_edge record if needed */
-    if (graph->vs[source_id].out_degree == 0) {
-      graph->vs[source_id].out_edges = malloc(sizeof(long long int));
-      reallocate_out_edges = false;
+  /* confirm edges are not repeated in the input or already in graph; an
+     existing out degree never exceeds the vcount, so counts can hold a
+     sorted copy of the existing out edges if they are unsorted */
+  bool duplicate = false;
+  for (i = 0; i < total_vcount && !duplicate; i++) {
+    VertexId *group = targets + offsets[i];
+    long long int group_size = offsets[i+1] - offsets[i];
+    if (group_size == 0) {
+      continue;
     }
-
-    /* allocate memory for target_id in_edge record if needed */
-    if (graph->vs[target_id].in_degree == 0) {
-      graph->vs[target_id].in_edges = malloc(sizeof(long long int));
-      reallocate_in_edges = false;
+    qsort(group, group_size, sizeof(VertexId), compare_id);
+    for (j = 1; j < group_size; j++) {
+      if (group[j-1] == group[j]) {
+        duplicate = true;
+      }
     }
-
-    /* check for problems */
-    if (graph->vs[target_id].in_edges==NULL || graph->vs[source_id].out_edges==NULL) {
-      raise_error(0);
+    if (i < graph->vcount && graph->vs[i].out_degree > 0 && !duplicate) {
+      long long int out_degree = graph->vs[i].out_degree;
+      VertexId *existing = graph->vs[i].out_edges;
+      if (!graph->out_edges_sorted) {
+        memcpy(counts, existing, out_degree * sizeof(VertexId));
+        qsort(counts, out_degree, sizeof(VertexId), compare_id);
+        existing = (VertexId *) counts;
+      }
+      duplicate = sorted_id_arrays_intersect(existing, out_degree, group, group_size);
     }
+  }
+  if (duplicate) {
+    free(offsets);
+    free(targets);
+    free(counts);
+    *error = 3;
+    return false;
+  }
 
-    /* append the new source_id and target_id */
-    add_to_int_array(&graph->vs[source_id].out_edges, graph->vs[source_id].out_degree, target_id, reallocate_out_edges);
-    add_to_int_array(&graph->vs[target_id].in_edges,  graph->vs[target_id].in_degree, source_id, reallocate_in_edges);
+  /* allocate memory for the new vertices */
+  reserve_vertex_array(graph, total_vcount);
+  for (i = 0; i < vcount; i++) {
+    init_vertex(graph, timestamps[i]);
+  }
 
-    /* increment degree counts */
-    graph->vs[source_id].out_degree++;
-    graph->vs[target_id].in_degree++;
+  /* grow the edge arrays of each vertex once, then append the new edges */
+  for (i = 0; i < total_vcount; i++) {
+    counts[i] = 0;
+  }
+  for (i = 0; i < ecount; i++) {
+    counts[edges[i].target_id]++;
+  }
+  for (i = 0; i < total_vcount; i++) {
+    long long int group_size = offsets[i+1] - offsets[i];
+    if (group_size > 0) {
+      if (graph->vs[i].out_degree > 0 &&
+          graph->vs[i].out_edges[graph->vs[i].out_degree - 1] > targets[offsets[i]]) {
+        graph->out_edges_sorted = false;
+      }
+      reserve_id_array(graph, &graph->vs[i].out_edges, &graph->vs[i].out_capacity, graph->vs[i].out_degree + group_size);
+      memcpy(graph->vs[i].out_edges + graph->vs[i].out_degree, targets + offsets[i],
+             group_size * sizeof(VertexId));
+      graph->vs[i].out_degree += group_size;
+    }
+    if (counts[i] > 0) {
+      reserve_id_array(graph, &graph->vs[i].in_edges, &graph->vs[i].in_capacity, graph->vs[i].in_degree + counts[i]);
+    }
+  }
+  for (i = 0; i < total_vcount; i++) {
+    for (j = offsets[i]; j < offsets[i+1]; j++) {
+      Vertex *target = &graph->vs[targets[j]];
+      target->in_edges[target->in_degree++] = i;
+    }
+  }
+  graph->ecount += ecount;
 
-    /* increment graph ecount */
-	  graph->ecount++;
+  free(offsets);
+  free(targets);
+  free(counts);
+  return true;
+}
 
-	}
+/**
+ * \function sort_adjacency
+ * \brief Sort the out edges of every vertex in increasing id order.
+ *
+ * With sorted out edges the index functions test membership with binary
+ * searches and sorted-set intersections instead of linear scans. The graph
+ * keeps track of whether its out edges are sorted; add_edge and
+ * bulk_load_graph keep the order when edges arrive in increasing id order
+ * for each source, and otherwise mark the graph as unsorted until this
+ * function is called again.
+ *
+ * \param graph The input graph.
+ */
+void sort_adjacency(Graph *graph) {
+  if (graph->out_edges_sorted) {
+    return;
+  }
+  for (long long int i = 0; i < graph->vcount; i++) {
+    if (graph->vs[i].out_degree > 1) {
+      qsort(graph->vs[i].out_edges, graph->vs[i].out_degree, sizeof(VertexId), compare_id);
+    }
+  }
+  graph->out_edges_sorted = true;
 }
 
 /**
@@ -163,9 +548,338 @@ void add_edge(Graph *graph, long long int source_id, long long int target_id) {
  * \param graph The input graph.
  */
 void free_graph(Graph *graph) {
+  if (graph->arena != NULL) {
+    free_arena(graph->arena);
+    graph->arena = NULL;
+    if (graph->vcapacity > 0) free(graph->vs);
+    return;
+  }
   for (long long int i = 0; i < graph->vcount; i++) {
-   if (graph->vs[i].in_degree > 0) free(graph->vs[i].in_edges);
-   if (graph->vs[i].out_degree > 0) free(graph->vs[i].out_edges);
+   if (graph->vs[i].in_capacity > 0) free(graph->vs[i].in_edges);
+   if (graph->vs[i].out_capacity > 0) free(graph->vs[i].out_edges);
    }
-  free(graph->vs);
+  if (graph->vcapacity > 0) free(graph->vs);
+}
+
+/* a vertex id with its timestamp, for ordering vertices by time */
+typedef struct TimedId {
+  Timestamp timestamp;
+  VertexId id;
+} TimedId;
+
+/**
+ * \function compare_timed_id
+ * \brief Compare two vertices by timestamp, then id (for use with qsort).
+ *
+ * \param a Pointer to the first TimedId.
+ * \param b Pointer to the second TimedId.
+ *
+ * \return Negative, zero, or positive as a comes before, with, or after b.
+ */
+static int compare_timed_id(const void *a, const void *b) {
+  const TimedId *x = a, *y = b;
+  if (x->timestamp != y->timestamp) {
+    return (x->timestamp > y->timestamp) - (x->timestamp < y->timestamp);
+  }
+  return (x->id > y->id) - (x->id < y->id);
+}
+
+/* a vertex id with a sort key, for ordering vertices by degree */
+typedef struct KeyedId {
+  long long int key;
+  long long int id;
+} KeyedId;
+
+/**
+ * \function compare_keyed_id
+ * \brief Compare two vertices by key, then id (for use with qsort).
+ *
+ * \param a Pointer to the first KeyedId.
+ * \param b Pointer to the second KeyedId.
+ *
+ * \return Negative, zero, or positive as a comes before, with, or after b.
+ */
+static int compare_keyed_id(const void *a, const void *b) {
+  const KeyedId *x = a, *y = b;
+  if (x->key != y->key) {
+    return (x->key > y->key) - (x->key < y->key);
+  }
+  return (x->id > y->id) - (x->id < y->id);
+}
+
+/**
+ * \function order_by_rcm
+ * \brief Order the vertices of a graph by reverse Cuthill-McKee.
+ *
+ * Citations are taken as undirected. Each connected component is searched
+ * breadth first from its unvisited vertex of lowest degree, adding the
+ * neighbors of each vertex in increasing degree order, and the whole order
+ * is then reversed, so vertices that cite each other get nearby positions.
+ *
+ * \param graph The input graph.
+ * \param public_ids Filled with the id of the vertex at each position.
+ */
+static void order_by_rcm(Graph *graph, VertexId *public_ids) {
+
+  long long int vcount = graph->vcount;
+  long long int i, j, max_degree = 0;
+  KeyedId *starts = allocate_array(vcount, sizeof(KeyedId));
+  bool *visited = calloc(vcount > 0 ? vcount : 1, sizeof(bool));
+  if (visited==NULL) {
+    raise_error(0);
+  }
+  for (i = 0; i < vcount; i++) {
+    starts[i].key = graph->vs[i].in_degree + graph->vs[i].out_degree;
+    starts[i].id = i;
+    max_degree = starts[i].key > max_degree ? starts[i].key : max_degree;
+  }
+  qsort(starts, vcount, sizeof(KeyedId), compare_keyed_id);
+  KeyedId *neighbors = allocate_array(max_degree, sizeof(KeyedId));
+
+  /* public_ids doubles as the queue of the breadth first searches */
+  long long int head = 0, tail = 0;
+  for (long long int s = 0; s < vcount; s++) {
+    if (visited[starts[s].id]) {
+      continue;
+    }
+    visited[starts[s].id] = true;
+    public_ids[tail++] = starts[s].id;
+    while (head < tail) {
+      Vertex *v = &graph->vs[public_ids[head++]];
+      long long int count = 0;
+      for (j = 0; j < v->in_degree + v->out_degree; j++) {
+        long long int u = j < v->in_degree ? v->in_edges[j] : v->out_edges[j - v->in_degree];
+        if (!visited[u]) {
+          visited[u] = true;
+          neighbors[count].key = graph->vs[u].in_degree + graph->vs[u].out_degree;
+          neighbors[count].id = u;
+          count++;
+        }
+      }
+      qsort(neighbors, count, sizeof(KeyedId), compare_keyed_id);
+      for (j = 0; j < count; j++) {
+        public_ids[tail++] = neighbors[j].id;
+      }
+    }
+  }
+  for (i = 0; i < vcount / 2; i++) {
+    VertexId tmp = public_ids[i];
+    public_ids[i] = public_ids[vcount - 1 - i];
+    public_ids[vcount - 1 - i] = tmp;
+  }
+
+  free(neighbors);
+  free(visited);
+  free(starts);
+}
+
+/**
+ * \function order_vertices
+ * \brief Choose the storage position of each vertex of a frozen graph.
+ *
+ * \param graph The input graph.
+ * \param ordering The ordering (ORDER_TIME, ORDER_DEGREE or ORDER_RCM).
+ * \param public_ids Filled with the id of the vertex at each position.
+ */
+static void order_vertices(Graph *graph, int ordering, VertexId *public_ids) {
+
+  long long int i;
+
+  if (ordering == ORDER_RCM) {
+    order_by_rcm(graph, public_ids);
+    return;
+  }
+
+  /* timestamps ascending, or degrees descending so the heavily cited
+     vertices most traversals visit are packed together */
+  KeyedId *order = allocate_array(graph->vcount, sizeof(KeyedId));
+  for (i = 0; i < graph->vcount; i++) {
+    order[i].key = ordering == ORDER_TIME ? graph->vs[i].timestamp :
+                   -(graph->vs[i].in_degree + graph->vs[i].out_degree);
+    order[i].id = i;
+  }
+  qsort(order, graph->vcount, sizeof(KeyedId), compare_keyed_id);
+  for (i = 0; i < graph->vcount; i++) {
+    public_ids[i] = order[i].id;
+  }
+  free(order);
+}
+
+/**
+ * \function fill_frozen_graph
+ * \brief Copy a graph into a read-only compressed sparse row structure.
+ *
+ * The in lists are filled by scattering each source vertex into the lists of
+ * the vertices it cites, so visiting the sources in position order leaves the
+ * lists in position order, and visiting them in time order leaves the lists
+ * in time order.
+ *
+ * \param graph The input graph.
+ * \param frozen The frozen graph to fill (free with free_frozen_graph).
+ * \param by_time Whether to order the in edges by timestamp and fill in_times.
+ * \param ordering The order in which to store the vertices (ORDER_IDS to
+ *                 keep them in id order).
+ */
+static void fill_frozen_graph(Graph *graph, FrozenGraph *frozen, bool by_time, int ordering) {
+
+  long long int i, j, p;
+
+  frozen->vcount = graph->vcount;
+  frozen->ecount = graph->ecount;
+  frozen->mapping = NULL;
+  frozen->mapping_size = 0;
+  frozen->timestamps = allocate_array(graph->vcount, sizeof(Timestamp));
+  frozen->in_offsets = allocate_array(graph->vcount + 1, sizeof(long long int));
+  frozen->out_offsets = allocate_array(graph->vcount + 1, sizeof(long long int));
+  frozen->in_edges = allocate_array(graph->ecount, sizeof(VertexId));
+  frozen->out_edges = allocate_array(graph->ecount, sizeof(VertexId));
+  frozen->in_times = by_time ? allocate_array(graph->ecount, sizeof(Timestamp)) : NULL;
+
+  /* the id of the vertex at each position and the position of each id,
+     which are the identity in id order */
+  VertexId *public_ids = allocate_array(graph->vcount, sizeof(VertexId));
+  VertexId *internal_ids = allocate_array(graph->vcount, sizeof(VertexId));
+  if (ordering == ORDER_IDS) {
+    for (i = 0; i < graph->vcount; i++) {
+      public_ids[i] = i;
+    }
+  }
+  else {
+    order_vertices(graph, ordering, public_ids);
+  }
+  for (p = 0; p < graph->vcount; p++) {
+    internal_ids[public_ids[p]] = p;
+  }
+
+  /* copy timestamps and compute offsets from the vertex degrees */
+  frozen->in_offsets[0] = 0;
+  frozen->out_offsets[0] = 0;
+  for (p = 0; p < graph->vcount; p++) {
+    Vertex *v = &graph->vs[public_ids[p]];
+    frozen->timestamps[p] = v->timestamp;
+    frozen->in_offsets[p+1] = frozen->in_offsets[p] + v->in_degree;
+    frozen->out_offsets[p+1] = frozen->out_offsets[p] + v->out_degree;
+  }
+
+  /* the order in which to visit the sources */
+  TimedId *order = allocate_array(graph->vcount, sizeof(TimedId));
+  for (p = 0; p < graph->vcount; p++) {
+    order[p].timestamp = frozen->timestamps[p];
+    order[p].id = p;
+  }
+  if (by_time) {
+    qsort(order, graph->vcount, sizeof(TimedId), compare_timed_id);
+  }
+
+  /* scatter sources into the in lists of their targets */
+  long long int *cursor = allocate_array(graph->vcount, sizeof(long long int));
+  for (p = 0; p < graph->vcount; p++) {
+    cursor[p] = frozen->in_offsets[p];
+  }
+  for (long long int k = 0; k < graph->vcount; k++) {
+    p = order[k].id;
+    Vertex *v = &graph->vs[public_ids[p]];
+    for (j = 0; j < v->out_degree; j++) {
+      long long int position = cursor[internal_ids[v->out_edges[j]]]++;
+      frozen->in_edges[position] = p;
+      if (by_time) {
+        frozen->in_times[position] = order[k].timestamp;
+      }
+    }
+  }
+  free(order);
+
+  /* scatter targets into the out lists of their sources, in position order */
+  for (p = 0; p < graph->vcount; p++) {
+    cursor[p] = frozen->out_offsets[p];
+  }
+  for (p = 0; p < graph->vcount; p++) {
+    Vertex *v = &graph->vs[public_ids[p]];
+    for (j = 0; j < v->in_degree; j++) {
+      frozen->out_edges[cursor[internal_ids[v->in_edges[j]]]++] = p;
+    }
+  }
+  free(cursor);
+
+  if (ordering == ORDER_IDS) {
+    free(public_ids);
+    free(internal_ids);
+    public_ids = NULL;
+    internal_ids = NULL;
+  }
+  frozen->public_ids = public_ids;
+  frozen->internal_ids = internal_ids;
+}
+
+/**
+ * \function freeze_graph
+ * \brief Copy a graph into a read-only compressed sparse row structure.
+ *
+ * The neighbors of each vertex are written in increasing id order. The
+ * original graph is left untouched and may be freed afterward.
+ *
+ * \param graph The input graph.
+ * \param frozen The frozen graph to fill (free with free_frozen_graph).
+ */
+void freeze_graph(Graph *graph, FrozenGraph *frozen) {
+  fill_frozen_graph(graph, frozen, false, ORDER_IDS);
+}
+
+/**
+ * \function freeze_graph_by_time
+ * \brief Copy a graph into a frozen graph with in edges ordered by time.
+ *
+ * The in edges of each vertex are ordered by the timestamp of their source,
+ * and the timestamps are stored alongside them, so the citers in a time window
+ * are found with two binary searches instead of a scan of the whole list. The
+ * out edges are in increasing id order, as with freeze_graph.
+ *
+ * \param graph The input graph.
+ * \param frozen The frozen graph to fill (free with free_frozen_graph).
+ */
+void freeze_graph_by_time(Graph *graph, FrozenGraph *frozen) {
+  fill_frozen_graph(graph, frozen, true, ORDER_IDS);
+}
+
+/**
+ * \function freeze_graph_ordered
+ * \brief Copy a graph into a frozen graph that stores its vertices in another order.
+ *
+ * Vertices are ids in insertion order, so the neighbors a traversal visits
+ * are scattered across the arrays when insertion order has little to do with
+ * who cites whom. Storing the vertices by timestamp, by decreasing degree, or
+ * by reverse Cuthill-McKee (which places vertices next to the vertices they
+ * cite and are cited by) makes those visits hit nearby memory. The index
+ * functions take and return the original ids, translating through the id
+ * mapping of the frozen graph; only the arrays themselves are in the new
+ * order.
+ *
+ * \param graph The input graph.
+ * \param frozen The frozen graph to fill (free with free_frozen_graph).
+ * \param by_time Whether to order the in edges by time, as with freeze_graph_by_time.
+ * \param ordering ORDER_IDS, ORDER_TIME, ORDER_DEGREE or ORDER_RCM.
+ */
+void freeze_graph_ordered(Graph *graph, FrozenGraph *frozen, bool by_time, int ordering) {
+  fill_frozen_graph(graph, frozen, by_time, ordering);
+}
+
+/**
+ * \function free_frozen_graph
+ * \brief Free memory taken by a frozen graph, or unmap its snapshot.
+ *
+ * \param frozen The input frozen graph.
+ */
+void free_frozen_graph(FrozenGraph *frozen) {
+  if (frozen->mapping != NULL) {
+    unmap_frozen_graph(frozen);
+    return;
+  }
+  free(frozen->timestamps);
+  free(frozen->in_offsets);
+  free(frozen->in_edges);
+  free(frozen->out_offsets);
+  free(frozen->out_edges);
+  free(frozen->in_times);
+  free(frozen->public_ids);
+  free(frozen->internal_ids);
 }
@@ -75,7 +75,15 @@ int main() {
   /* compute mcdindex measure */
   printf("mCD index: %f\n", mcdindex(&g, 4, 157852800));
 
-  /* free memory use by the graph */
+  /* freeze the graph and compute the measures on the frozen copy */
+  FrozenGraph fg;
+  freeze_graph(&g, &fg);
+  printf("CD index (frozen): %f\n", frozen_cdindex(&fg, 4, 157852800));
+  printf("mCD index (frozen): %f\n", frozen_mcdindex(&fg, 4, 157852800));
+  free_frozen_graph(&fg);
+
+  /* free memory use by the graph and the index functions */
+  free_thread_scratch();
   free_graph(&g);
 
   return 0;
@@ -0,0 +1,481 @@
+/*
+  cdindex library.
+  Copyright (C) 2017 Russell J. Funk <russellfunk@gmail.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "cdindex.h"
+
+/* measures computed by the parallel engine */
+enum { PARALLEL_CDINDEX, PARALLEL_MCDINDEX, PARALLEL_IINDEX, PARALLEL_CDINDEX_MULTI };
+
+/* work shared by the threads of a parallel computation; exactly one of
+   graph and frozen is set, and view is set (over the same graph) when the
+   measures are taken as of a cutoff */
+typedef struct ParallelJob {
+  Graph *graph;
+  FrozenGraph *frozen;
+  GraphView *view;
+  int measure;
+  long long int *ids;
+  long long int n;
+  long long int *time_deltas;
+  long long int k;
+  void *out;
+  int threads;
+  long long int *order;
+  atomic_llong next;
+} ParallelJob;
+
+/**
+ * \function job_vertex
+ * \brief Get the focal vertex id at a position of a job.
+ *
+ * \param job The parallel job.
+ * \param position The position in the job's ids (or in the graph if ids is NULL).
+ *
+ * \return The focal vertex id.
+ */
+static inline long long int job_vertex(ParallelJob *job, long long int position) {
+  return job->ids == NULL ? position : job->ids[position];
+}
+
+/**
+ * \function vertex_cost
+ * \brief Estimate the work of computing the CD index of a vertex.
+ *
+ * The estimate is the number of in edges the computation scans: those of the
+ * focal vertex and those of each of its out edges.
+ *
+ * \param job The parallel job.
+ * \param id The focal vertex id.
+ *
+ * \return The estimated cost.
+ */
+static long long int vertex_cost(ParallelJob *job, long long int id) {
+  long long int cost = 0;
+  if (job->view != NULL && !view_has_vertex(job->view, id)) {
+    return 0;
+  }
+  if (job->frozen != NULL) {
+    FrozenGraph *fg = job->frozen;
+    id = fg->internal_ids != NULL ? fg->internal_ids[id] : id;
+    cost = fg->in_offsets[id+1] - fg->in_offsets[id];
+    for (long long int i = fg->out_offsets[id]; i < fg->out_offsets[id+1]; i++) {
+      cost += fg->in_offsets[fg->out_edges[i]+1] - fg->in_offsets[fg->out_edges[i]];
+    }
+  }
+  else {
+    Vertex *vs = job->graph->vs;
+    cost = vs[id].in_degree;
+    for (long long int i = 0; i < vs[id].out_degree; i++) {
+      cost += vs[vs[id].out_edges[i]].in_degree;
+    }
+  }
+  return cost;
+}
+
+/**
+ * \function order_by_cost
+ * \brief Order the positions of a job from most to least expensive.
+ *
+ * Positions are bucketed by the base 2 logarithm of their estimated cost with
+ * a counting sort, which is enough to hand out the few very expensive
+ * vertices of a skewed citation graph first.
+ *
+ * \param job The parallel job (its order array is filled).
+ */
+static void order_by_cost(ParallelJob *job) {
+  long long int counts[66] = {0};
+  unsigned char *buckets = malloc(job->n > 0 ? job->n : 1);
+  if (buckets==NULL) {
+    raise_error(0);
+  }
+
+  /* bucket 0 holds the most expensive vertices */
+  for (long long int k = 0; k < job->n; k++) {
+    long long int cost = vertex_cost(job, job_vertex(job, k));
+    int bucket = 64;
+    while (cost > 0) {
+      cost >>= 1;
+      bucket--;
+    }
+    buckets[k] = bucket;
+    counts[bucket + 1]++;
+  }
+  for (int b = 0; b < 65; b++) {
+    counts[b+1] += counts[b];
+  }
+  for (long long int k = 0; k < job->n; k++) {
+    job->order[counts[buckets[k]]++] = k;
+  }
+
+  free(buckets);
+}
+
+/**
+ * \function view_job_vertex
+ * \brief Compute the measure of a job for one focal vertex of its view.
+ *
+ * \param job The parallel job (its view is set).
+ * \param position The position of the vertex in the job.
+ * \param id The focal vertex id.
+ */
+static void view_job_vertex(ParallelJob *job, long long int position, long long int id) {
+  switch (job->measure) {
+    case PARALLEL_CDINDEX:
+      ((double *) job->out)[position] = view_cdindex(job->view, id, job->time_deltas[0]);
+      break;
+    case PARALLEL_MCDINDEX:
+      ((double *) job->out)[position] = view_mcdindex(job->view, id, job->time_deltas[0]);
+      break;
+    case PARALLEL_IINDEX:
+      ((long long int *) job->out)[position] = view_iindex(job->view, id, job->time_deltas[0]);
+      break;
+    case PARALLEL_CDINDEX_MULTI:
+      view_cdindex_multi(job->view, id, job->time_deltas, job->k, (double *) job->out + position * job->k);
+      break;
+  }
+}
+
+/**
+ * \function parallel_worker
+ * \brief Compute measures for chunks of a job until none are left.
+ *
+ * Chunks are claimed from a shared counter over the cost-ordered positions.
+ * They hold a single vertex at the expensive start of the order and grow
+ * toward the cheap end, which keeps the threads balanced without paying for
+ * an atomic operation per cheap vertex.
+ *
+ * \param arg The parallel job.
+ *
+ * \return NULL.
+ */
+static void *parallel_worker(void *arg) {
+  ParallelJob *job = arg;
+  long long int chunk_scale = 64LL * job->threads;
+
+  while (true) {
+    long long int chunk = 1 + atomic_load_explicit(&job->next, memory_order_relaxed) / chunk_scale;
+    if (chunk > 256) {
+      chunk = 256;
+    }
+    long long int start = atomic_fetch_add_explicit(&job->next, chunk, memory_order_relaxed);
+    if (start >= job->n) {
+      break;
+    }
+    long long int end = start + chunk < job->n ? start + chunk : job->n;
+    for (long long int k = start; k < end; k++) {
+      long long int position = job->order[k];
+      long long int id = job_vertex(job, position);
+      if (job->view != NULL) {
+        view_job_vertex(job, position, id);
+        continue;
+      }
+      switch (job->measure) {
+        case PARALLEL_CDINDEX:
+          ((double *) job->out)[position] = job->frozen != NULL ?
+            frozen_cdindex(job->frozen, id, job->time_deltas[0]) :
+            cdindex(job->graph, id, job->time_deltas[0]);
+          break;
+        case PARALLEL_MCDINDEX:
+          ((double *) job->out)[position] = job->frozen != NULL ?
+            frozen_mcdindex(job->frozen, id, job->time_deltas[0]) :
+            mcdindex(job->graph, id, job->time_deltas[0]);
+          break;
+        case PARALLEL_IINDEX:
+          ((long long int *) job->out)[position] = job->frozen != NULL ?
+            frozen_iindex(job->frozen, id, job->time_deltas[0]) :
+            iindex(job->graph, id, job->time_deltas[0]);
+          break;
+        case PARALLEL_CDINDEX_MULTI:
+          if (job->frozen != NULL) {
+            frozen_cdindex_multi(job->frozen, id, job->time_deltas, job->k, (double *) job->out + position * job->k);
+          }
+          else {
+            cdindex_multi(job->graph, id, job->time_deltas, job->k, (double *) job->out + position * job->k);
+          }
+          break;
+      }
+    }
+  }
+  return NULL;
+}
+
+/**
+ * \function run_parallel
+ * \brief Run a parallel job on the calling thread and threads - 1 others.
+ *
+ * If a thread cannot be created, the remaining threads pick up its share.
+ *
+ * \param job The parallel job.
+ */
+static void run_parallel(ParallelJob *job) {
+
+  if (job->threads <= 0) {
+    long long int online = sysconf(_SC_NPROCESSORS_ONLN);
+    job->threads = online > 0 ? (int) online : 1;
+  }
+  if (job->threads > job->n) {
+    job->threads = job->n > 0 ? (int) job->n : 1;
+  }
+
+  job->order = malloc((job->n > 0 ? job->n : 1) * sizeof(long long int));
+  if (job->order==NULL) {
+    raise_error(0);
+  }
+  order_by_cost(job);
+  atomic_init(&job->next, 0);
+
+  pthread_t *workers = malloc(job->threads * sizeof(pthread_t));
+  bool *started = calloc(job->threads, sizeof(bool));
+  if (workers==NULL || started==NULL) {
+    raise_error(0);
+  }
+  for (int t = 1; t < job->threads; t++) {
+    started[t] = pthread_create(&workers[t], NULL, parallel_worker, job) == 0;
+  }
+  parallel_worker(job);
+  for (int t = 1; t < job->threads; t++) {
+    if (started[t]) {
+      pthread_join(workers[t], NULL);
+    }
+  }
+
+  free(workers);
+  free(started);
+  free(job->order);
+}
+
+/**
+ * \function start_job
+ * \brief Fill in and run a parallel job.
+ *
+ * \param graph The input graph (or NULL if frozen is set).
+ * \param frozen The input frozen graph (or NULL if graph is set).
+ * \param view A view of the input graph to take the measure in (or NULL).
+ * \param measure The measure to compute.
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas (1 except for PARALLEL_CDINDEX_MULTI).
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, k per focal vertex.
+ */
+static void start_job(Graph *graph, FrozenGraph *frozen, GraphView *view, int measure, long long int *ids, long long int n, long long int *time_deltas, long long int k, int threads, void *out) {
+  ParallelJob job;
+  job.graph = graph;
+  job.frozen = frozen;
+  job.view = view;
+  job.measure = measure;
+  job.ids = ids;
+  job.n = ids != NULL ? n : (frozen != NULL ? frozen->vcount : graph->vcount);
+  job.time_deltas = time_deltas;
+  job.k = k;
+  job.out = out;
+  job.threads = threads;
+  run_parallel(&job);
+}
+
+/**
+ * \function parallel_cdindex
+ * \brief Computes the CD Index of many focal vertices with several threads.
+ *
+ * \param graph The input graph (must not be modified during the call).
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, one per focal vertex (NAN where the index is undefined).
+ */
+void parallel_cdindex(Graph *graph, long long int *ids, long long int n, long long int time_delta, int threads, double *out) {
+  start_job(graph, NULL, NULL, PARALLEL_CDINDEX, ids, n, &time_delta, 1, threads, out);
+}
+
+/**
+ * \function parallel_mcdindex
+ * \brief Computes the mCD Index of many focal vertices with several threads.
+ *
+ * \param graph The input graph (must not be modified during the call).
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, one per focal vertex (NAN where the index is undefined).
+ */
+void parallel_mcdindex(Graph *graph, long long int *ids, long long int n, long long int time_delta, int threads, double *out) {
+  start_job(graph, NULL, NULL, PARALLEL_MCDINDEX, ids, n, &time_delta, 1, threads, out);
+}
+
+/**
+ * \function parallel_iindex
+ * \brief Computes the I Index of many focal vertices with several threads.
+ *
+ * \param graph The input graph (must not be modified during the call).
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, one per focal vertex.
+ */
+void parallel_iindex(Graph *graph, long long int *ids, long long int n, long long int time_delta, int threads, long long int *out) {
+  start_job(graph, NULL, NULL, PARALLEL_IINDEX, ids, n, &time_delta, 1, threads, out);
+}
+
+/**
+ * \function parallel_cdindex_multi
+ * \brief Computes the CD Index of many focal vertices at several time deltas with several threads.
+ *
+ * \param graph The input graph (must not be modified during the call).
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, k per focal vertex (NAN where the index is undefined).
+ */
+void parallel_cdindex_multi(Graph *graph, long long int *ids, long long int n, long long int *time_deltas, long long int k, int threads, double *out) {
+  start_job(graph, NULL, NULL, PARALLEL_CDINDEX_MULTI, ids, n, time_deltas, k, threads, out);
+}
+
+/**
+ * \function frozen_parallel_cdindex
+ * \brief Computes the CD Index of many focal vertices of a frozen graph with several threads.
+ *
+ * \param frozen The input frozen graph.
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, one per focal vertex (NAN where the index is undefined).
+ */
+void frozen_parallel_cdindex(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, int threads, double *out) {
+  start_job(NULL, frozen, NULL, PARALLEL_CDINDEX, ids, n, &time_delta, 1, threads, out);
+}
+
+/**
+ * \function frozen_parallel_mcdindex
+ * \brief Computes the mCD Index of many focal vertices of a frozen graph with several threads.
+ *
+ * \param frozen The input frozen graph.
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, one per focal vertex (NAN where the index is undefined).
+ */
+void frozen_parallel_mcdindex(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, int threads, double *out) {
+  start_job(NULL, frozen, NULL, PARALLEL_MCDINDEX, ids, n, &time_delta, 1, threads, out);
+}
+
+/**
+ * \function frozen_parallel_iindex
+ * \brief Computes the I Index of many focal vertices of a frozen graph with several threads.
+ *
+ * \param frozen The input frozen graph.
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, one per focal vertex.
+ */
+void frozen_parallel_iindex(FrozenGraph *frozen, long long int *ids, long long int n, long long int time_delta, int threads, long long int *out) {
+  start_job(NULL, frozen, NULL, PARALLEL_IINDEX, ids, n, &time_delta, 1, threads, out);
+}
+
+/**
+ * \function frozen_parallel_cdindex_multi
+ * \brief Computes the CD Index of many focal vertices of a frozen graph at several time deltas with several threads.
+ *
+ * \param frozen The input frozen graph.
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, k per focal vertex (NAN where the index is undefined).
+ */
+void frozen_parallel_cdindex_multi(FrozenGraph *frozen, long long int *ids, long long int n, long long int *time_deltas, long long int k, int threads, double *out) {
+  start_job(NULL, frozen, NULL, PARALLEL_CDINDEX_MULTI, ids, n, time_deltas, k, threads, out);
+}
+
+/**
+ * \function view_parallel_cdindex
+ * \brief Computes the CD Index of many focal vertices of a view with several threads.
+ *
+ * \param view The input view (of a graph or a frozen graph).
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, one per focal vertex (NAN where the
+ *            index is undefined or the vertex is hidden).
+ */
+void view_parallel_cdindex(GraphView *view, long long int *ids, long long int n, long long int time_delta, int threads, double *out) {
+  start_job(view->graph, view->frozen, view, PARALLEL_CDINDEX, ids, n, &time_delta, 1, threads, out);
+}
+
+/**
+ * \function view_parallel_mcdindex
+ * \brief Computes the mCD Index of many focal vertices of a view with several threads.
+ *
+ * \param view The input view (of a graph or a frozen graph).
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, one per focal vertex (NAN where the
+ *            index is undefined or the vertex is hidden).
+ */
+void view_parallel_mcdindex(GraphView *view, long long int *ids, long long int n, long long int time_delta, int threads, double *out) {
+  start_job(view->graph, view->frozen, view, PARALLEL_MCDINDEX, ids, n, &time_delta, 1, threads, out);
+}
+
+/**
+ * \function view_parallel_iindex
+ * \brief Computes the I Index of many focal vertices of a view with several threads.
+ *
+ * \param view The input view (of a graph or a frozen graph).
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, one per focal vertex (0 where the vertex is hidden).
+ */
+void view_parallel_iindex(GraphView *view, long long int *ids, long long int n, long long int time_delta, int threads, long long int *out) {
+  start_job(view->graph, view->frozen, view, PARALLEL_IINDEX, ids, n, &time_delta, 1, threads, out);
+}
+
+/**
+ * \function view_parallel_cdindex_multi
+ * \brief Computes the CD Index of many focal vertices of a view at several time deltas with several threads.
+ *
+ * \param view The input view (of a graph or a frozen graph).
+ * \param ids The focal vertex ids (or NULL for every vertex of the graph).
+ * \param n The number of focal vertices (ignored if ids is NULL).
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param threads The number of threads (0 for one per online processor).
+ * \param out Array of values to fill, k per focal vertex (NAN where the
+ *            index is undefined or the vertex is hidden).
+ */
+void view_parallel_cdindex_multi(GraphView *view, long long int *ids, long long int n, long long int *time_deltas, long long int k, int threads, double *out) {
+  start_job(view->graph, view->frozen, view, PARALLEL_CDINDEX_MULTI, ids, n, time_deltas, k, threads, out);
+}
@@ -0,0 +1,423 @@
+/*
+  cdindex library.
+  Copyright (C) 2017 Russell J. Funk <russellfunk@gmail.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "cdindex.h"
+
+/* The vectorized kernels are compiled for their instruction sets with target
+   attributes, so the library itself is built for the baseline and the best
+   kernels the CPU supports are chosen when the library is loaded. Other
+   compilers and architectures use the scalar kernels only. */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+#ifdef SIMD_X86
+#ifdef CDINDEX_COMPACT
+#define AVX2_LANES 8
+#define AVX2_SET1(v) _mm256_set1_epi32((int) (v))
+#define AVX2_CMPEQ(x, y) _mm256_cmpeq_epi32(x, y)
+#define AVX2_ROTATE(v) _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0))
+#define AVX512_LANES 16
+#define AVX512_SET1(v) _mm512_set1_epi32((int) (v))
+#define AVX512_CMPEQ(x, y) _mm512_cmpeq_epi32_mask(x, y)
+#define AVX512_ROTATE(v) _mm512_alignr_epi32(v, v, 1)
+#else
+#define AVX2_LANES 4
+#define AVX2_SET1(v) _mm256_set1_epi64x(v)
+#define AVX2_CMPEQ(x, y) _mm256_cmpeq_epi64(x, y)
+#define AVX2_ROTATE(v) _mm256_permute4x64_epi64(v, _MM_SHUFFLE(0, 3, 2, 1))
+#define AVX512_LANES 8
+#define AVX512_SET1(v) _mm512_set1_epi64(v)
+#define AVX512_CMPEQ(x, y) _mm512_cmpeq_epi64_mask(x, y)
+#define AVX512_ROTATE(v) _mm512_alignr_epi64(v, v, 1)
+#endif
+#endif
+
+/* arrays at least this many times longer than the other array of an
+   intersection are galloped through rather than merged */
+#define GALLOP_RATIO 32
+
+/**
+ * \function scalar_in_id_array
+ * \brief See if a vertex id is in a vertex id array (scalar kernel).
+ *
+ * \param array The input array.
+ * \param sizeof_array The size of the input array.
+ * \param value The value to look for in the input array.
+ *
+ * \return Whether value is in the array.
+ */
+static bool scalar_in_id_array(VertexId *array, long long int sizeof_array, VertexId value) {
+  for (long long int i = 0; i < sizeof_array; i++) {
+    if (array[i] == value) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * \function merge_from
+ * \brief See if two sorted vertex id arrays intersect by merging them from
+ *        the given positions.
+ *
+ * Both positions are advanced by comparison results rather than branches,
+ * since which array advances is close to random.
+ *
+ * \param a The first array, in increasing order.
+ * \param i The position in the first array to start from.
+ * \param sizeof_a The size of the first array.
+ * \param b The second array, in increasing order.
+ * \param j The position in the second array to start from.
+ * \param sizeof_b The size of the second array.
+ *
+ * \return Whether the arrays intersect past the given positions.
+ */
+static bool merge_from(VertexId *a, long long int i, long long int sizeof_a,
+                       VertexId *b, long long int j, long long int sizeof_b) {
+  while (i < sizeof_a && j < sizeof_b) {
+    VertexId x = a[i], y = b[j];
+    if (x == y) {
+      return true;
+    }
+    i += x < y;
+    j += y < x;
+  }
+  return false;
+}
+
+/**
+ * \function scalar_merge_intersect
+ * \brief See if two sorted vertex id arrays intersect by merging them
+ *        (scalar kernel).
+ *
+ * \param a The first array, in increasing order.
+ * \param sizeof_a The size of the first array.
+ * \param b The second array, in increasing order.
+ * \param sizeof_b The size of the second array.
+ *
+ * \return Whether the arrays intersect.
+ */
+static bool scalar_merge_intersect(VertexId *a, long long int sizeof_a, VertexId *b, long long int sizeof_b) {
+  return merge_from(a, 0, sizeof_a, b, 0, sizeof_b);
+}
+
+#ifdef SIMD_X86
+
+/**
+ * \function avx2_in_id_array
+ * \brief See if a vertex id is in a vertex id array (AVX2 kernel).
+ *
+ * Two vectors are compared per step, and the scan stops at the first step
+ * with a match; the remainder takes one more vector and then single ids.
+ *
+ * \param array The input array.
+ * \param sizeof_array The size of the input array.
+ * \param value The value to look for in the input array.
+ *
+ * \return Whether value is in the array.
+ */
+__attribute__((target("avx2")))
+static bool avx2_in_id_array(VertexId *array, long long int sizeof_array, VertexId value) {
+  __m256i v = AVX2_SET1(value);
+  long long int i = 0;
+  for (; i + 2 * AVX2_LANES <= sizeof_array; i += 2 * AVX2_LANES) {
+    __m256i x = _mm256_loadu_si256((const __m256i *) (array + i));
+    __m256i y = _mm256_loadu_si256((const __m256i *) (array + i + AVX2_LANES));
+    __m256i eq = _mm256_or_si256(AVX2_CMPEQ(x, v), AVX2_CMPEQ(y, v));
+    if (!_mm256_testz_si256(eq, eq)) {
+      return true;
+    }
+  }
+  if (i + AVX2_LANES <= sizeof_array) {
+    __m256i eq = AVX2_CMPEQ(_mm256_loadu_si256((const __m256i *) (array + i)), v);
+    if (!_mm256_testz_si256(eq, eq)) {
+      return true;
+    }
+    i += AVX2_LANES;
+  }
+  return scalar_in_id_array(array + i, sizeof_array - i, value);
+}
+
+/**
+ * \function avx2_merge_intersect
+ * \brief See if two sorted vertex id arrays intersect by merging them
+ *        (AVX2 kernel).
+ *
+ * A block of each array is loaded per step and every pair of ids is compared
+ * by rotating one block through all lane positions; then the block with the
+ * smaller last id is passed, since none of its ids can match later blocks of
+ * the other array. The remainders are merged one id at a time.
+ *
+ * \param a The first array, in increasing order.
+ * \param sizeof_a The size of the first array.
+ * \param b The second array, in increasing order.
+ * \param sizeof_b The size of the second array.
+ *
+ * \return Whether the arrays intersect.
+ */
+__attribute__((target("avx2")))
+static bool avx2_merge_intersect(VertexId *a, long long int sizeof_a, VertexId *b, long long int sizeof_b) {
+  long long int i = 0, j = 0;
+  while (i + AVX2_LANES <= sizeof_a && j + AVX2_LANES <= sizeof_b) {
+    __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+    __m256i y = _mm256_loadu_si256((const __m256i *) (b + j));
+    __m256i eq = AVX2_CMPEQ(x, y);
+    for (int r = 1; r < AVX2_LANES; r++) {
+      y = AVX2_ROTATE(y);
+      eq = _mm256_or_si256(eq, AVX2_CMPEQ(x, y));
+    }
+    if (!_mm256_testz_si256(eq, eq)) {
+      return true;
+    }
+    VertexId a_last = a[i + AVX2_LANES - 1], b_last = b[j + AVX2_LANES - 1];
+    i += a_last <= b_last ? AVX2_LANES : 0;
+    j += b_last <= a_last ? AVX2_LANES : 0;
+  }
+  return merge_from(a, i, sizeof_a, b, j, sizeof_b);
+}
+
+/**
+ * \function avx512_in_id_array
+ * \brief See if a vertex id is in a vertex id array (AVX-512 kernel).
+ *
+ * Arrays shorter than two vectors are left to the AVX2 kernel, which wastes
+ * fewer ids on the scalar remainder.
+ *
+ * \param array The input array.
+ * \param sizeof_array The size of the input array.
+ * \param value The value to look for in the input array.
+ *
+ * \return Whether value is in the array.
+ */
+__attribute__((target("avx512f")))
+static bool avx512_in_id_array(VertexId *array, long long int sizeof_array, VertexId value) {
+  if (sizeof_array < 2 * AVX512_LANES) {
+    return avx2_in_id_array(array, sizeof_array, value);
+  }
+  __m512i v = AVX512_SET1(value);
+  long long int i = 0;
+  for (; i + 2 * AVX512_LANES <= sizeof_array; i += 2 * AVX512_LANES) {
+    __m512i x = _mm512_loadu_si512((const void *) (array + i));
+    __m512i y = _mm512_loadu_si512((const void *) (array + i + AVX512_LANES));
+    if (AVX512_CMPEQ(x, v) | AVX512_CMPEQ(y, v)) {
+      return true;
+    }
+  }
+  return scalar_in_id_array(array + i, sizeof_array - i, value);
+}
+
+/**
+ * \function avx512_merge_intersect
+ * \brief See if two sorted vertex id arrays intersect by merging them
+ *        (AVX-512 kernel, blocked like avx2_merge_intersect).
+ *
+ * Intersections with an array shorter than two vectors are left to the AVX2
+ * kernel.
+ *
+ * \param a The first array, in increasing order.
+ * \param sizeof_a The size of the first array.
+ * \param b The second array, in increasing order.
+ * \param sizeof_b The size of the second array.
+ *
+ * \return Whether the arrays intersect.
+ */
+__attribute__((target("avx512f")))
+static bool avx512_merge_intersect(VertexId *a, long long int sizeof_a, VertexId *b, long long int sizeof_b) {
+  if (sizeof_a < 2 * AVX512_LANES) {
+    return avx2_merge_intersect(a, sizeof_a, b, sizeof_b);
+  }
+  long long int i = 0, j = 0;
+  while (i + AVX512_LANES <= sizeof_a && j + AVX512_LANES <= sizeof_b) {
+    __m512i x = _mm512_loadu_si512((const void *) (a + i));
+    __m512i y = _mm512_loadu_si512((const void *) (b + j));
+    unsigned int eq = AVX512_CMPEQ(x, y);
+    for (int r = 1; r < AVX512_LANES; r++) {
+      y = AVX512_ROTATE(y);
+      eq |= AVX512_CMPEQ(x, y);
+    }
+    if (eq) {
+      return true;
+    }
+    VertexId a_last = a[i + AVX512_LANES - 1], b_last = b[j + AVX512_LANES - 1];
+    i += a_last <= b_last ? AVX512_LANES : 0;
+    j += b_last <= a_last ? AVX512_LANES : 0;
+  }
+  return merge_from(a, i, sizeof_a, b, j, sizeof_b);
+}
+
+#endif
+
+/* the kernels in use, set by set_simd_level */
+static int active_level = SIMD_SCALAR;
+static bool (*membership_kernel)(VertexId *, long long int, VertexId) = scalar_in_id_array;
+static bool (*merge_kernel)(VertexId *, long long int, VertexId *, long long int) = scalar_merge_intersect;
+
+/**
+ * \function simd_supported_level
+ * \brief Find the best kernels the CPU supports.
+ *
+ * \return SIMD_AVX512, SIMD_AVX2 or SIMD_SCALAR.
+ */
+int simd_supported_level(void) {
+#ifdef SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SIMD_AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return SIMD_AVX2;
+  }
+#endif
+  return SIMD_SCALAR;
+}
+
+/**
+ * \function simd_level
+ * \brief Get the kernels in use.
+ *
+ * \return SIMD_AVX512, SIMD_AVX2 or SIMD_SCALAR.
+ */
+int simd_level(void) {
+  return active_level;
+}
+
+/**
+ * \function set_simd_level
+ * \brief Choose the membership and intersection kernels.
+ *
+ * The best supported kernels are chosen when the library is loaded, so this
+ * is only needed to compare kernels. It must not be called while other
+ * threads compute indices.
+ *
+ * \param level SIMD_AVX512, SIMD_AVX2 or SIMD_SCALAR (lowered to the best
+ *              level the CPU supports).
+ *
+ * \return The level chosen.
+ */
+int set_simd_level(int level) {
+  int supported = simd_supported_level();
+  level = level < supported ? level : supported;
+  membership_kernel = scalar_in_id_array;
+  merge_kernel = scalar_merge_intersect;
+#ifdef SIMD_X86
+  if (level == SIMD_AVX2) {
+    membership_kernel = avx2_in_id_array;
+    merge_kernel = avx2_merge_intersect;
+  }
+  else if (level == SIMD_AVX512) {
+    membership_kernel = avx512_in_id_array;
+    merge_kernel = avx512_merge_intersect;
+  }
+#endif
+  active_level = level;
+  return level;
+}
+
+#ifdef SIMD_X86
+/**
+ * \function select_simd_kernels
+ * \brief Choose the best supported kernels when the library is loaded.
+ */
+__attribute__((constructor))
+static void select_simd_kernels(void) {
+  set_simd_level(SIMD_AVX512);
+}
+#endif
+
+/**
+ * \function in_id_array
+ * \brief See if a vertex id is in a vertex id array.
+ *
+ * \param array The input array.
+ * \param sizeof_array The size of the input array.
+ * \param value The value to look for in the input array.
+ *
+ * \return Whether value is in the array.
+ */
+bool in_id_array(VertexId *array, long long int sizeof_array, long long int value) {
+  if ((VertexId) value != value) {
+    return false;
+  }
+  return membership_kernel(array, sizeof_array, (VertexId) value);
+}
+
+/**
+ * \function sorted_id_arrays_intersect
+ * \brief See if two sorted vertex id arrays have an element in common.
+ *
+ * Arrays of similar size are merged; when one array is much longer than the
+ * other, each element of the shorter array is located in the longer one with
+ * a galloping (exponential) search starting from the previous match position.
+ * Both strategies stop at the first common element.
+ *
+ * \param a The first array, in increasing order.
+ * \param sizeof_a The size of the first array.
+ * \param b The second array, in increasing order.
+ * \param sizeof_b The size of the second array.
+ *
+ * \return Whether the arrays intersect.
+ */
+bool sorted_id_arrays_intersect(VertexId *a, long long int sizeof_a, VertexId *b, long long int sizeof_b) {
+
+  /* make a the shorter array */
+  if (sizeof_a > sizeof_b) {
+    VertexId *tmp_array = a;
+    long long int tmp_size = sizeof_a;
+    a = b;
+    sizeof_a = sizeof_b;
+    b = tmp_array;
+    sizeof_b = tmp_size;
+  }
+  if (sizeof_a == 0 || a[sizeof_a - 1] < b[0] || b[sizeof_b - 1] < a[0]) {
+    return false;
+  }
+
+  /* merge arrays of similar size */
+  if (sizeof_b < GALLOP_RATIO * sizeof_a) {
+    return merge_kernel(a, sizeof_a, b, sizeof_b);
+  }
+
+  /* gallop through the longer array otherwise */
+  long long int j = 0;
+  for (long long int i = 0; i < sizeof_a && j < sizeof_b; i++) {
+    long long int step = 1;
+    while (j + step < sizeof_b && b[j + step] < a[i]) {
+      step *= 2;
+    }
+    long long int lo = j + step / 2;
+    long long int hi = j + step < sizeof_b ? j + step + 1 : sizeof_b;
+    while (lo < hi) {
+      long long int mid = lo + (hi - lo) / 2;
+      if (b[mid] < a[i]) {
+        lo = mid + 1;
+      }
+      else {
+        hi = mid;
+      }
+    }
+    if (lo < sizeof_b && b[lo] == a[i]) {
+      return true;
+    }
+    j = lo;
+  }
+  return false;
+}
@@ -0,0 +1,265 @@
+/*
+  cdindex library.
+  Copyright (C) 2017 Russell J. Funk <russellfunk@gmail.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cdindex.h"
+
+/* A snapshot is a 64 byte header followed by the five arrays of a frozen
+   graph, stored as native integers in this order: timestamps (vcount),
+   in_offsets (vcount + 1), in_edges (ecount), out_offsets (vcount + 1) and
+   out_edges (ecount), then in_times (ecount) if the in edges are ordered by
+   time, then public_ids and internal_ids (vcount each) if the vertices are
+   stored out of id order. Offsets are 64 bit; ids and timestamps have the widths
+   recorded in the header (a width of 0 means 64 bit), so a snapshot only
+   maps into a build with the same types. Every array is padded to a
+   multiple of 8 bytes, so a mapped file is used in place. */
+#define SNAPSHOT_MAGIC "CDINDEXG"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_IN_TIMES 1
+#define SNAPSHOT_ORDERED 2
+
+typedef struct SnapshotHeader {
+  char magic[8];
+  unsigned int version;
+  unsigned int byte_order;
+  long long int vcount;
+  long long int ecount;
+  unsigned int id_size;
+  unsigned int timestamp_size;
+  long long int flags;
+  long long int reserved[2];
+} SnapshotHeader;
+
+/**
+ * \function section_size
+ * \brief Compute the padded size of an array in a snapshot.
+ *
+ * \param count The number of elements.
+ * \param size The size of an element.
+ *
+ * \return The size in bytes, rounded up to a multiple of 8.
+ */
+static long long int section_size(long long int count, long long int size) {
+  return (count * size + 7) / 8 * 8;
+}
+
+/**
+ * \function snapshot_size
+ * \brief Compute the size of a snapshot file.
+ *
+ * \param vcount The number of vertices.
+ * \param ecount The number of edges.
+ * \param flags The snapshot flags.
+ *
+ * \return The size in bytes.
+ */
+static long long int snapshot_size(long long int vcount, long long int ecount, long long int flags) {
+  return sizeof(SnapshotHeader) + section_size(vcount, sizeof(Timestamp)) +
+         2 * section_size(vcount + 1, sizeof(long long int)) + 2 * section_size(ecount, sizeof(VertexId)) +
+         (flags & SNAPSHOT_IN_TIMES ? section_size(ecount, sizeof(Timestamp)) : 0) +
+         (flags & SNAPSHOT_ORDERED ? 2 * section_size(vcount, sizeof(VertexId)) : 0);
+}
+
+/**
+ * \function point_into_snapshot
+ * \brief Set the arrays of a frozen graph to the sections of a snapshot.
+ *
+ * \param frozen The frozen graph (vcount and ecount must be set).
+ * \param data The start of the snapshot.
+ * \param flags The snapshot flags.
+ */
+static void point_into_snapshot(FrozenGraph *frozen, char *data, long long int flags) {
+  char *section = data + sizeof(SnapshotHeader);
+  frozen->timestamps = (Timestamp *) section;
+  section += section_size(frozen->vcount, sizeof(Timestamp));
+  frozen->in_offsets = (long long int *) section;
+  section += section_size(frozen->vcount + 1, sizeof(long long int));
+  frozen->in_edges = (VertexId *) section;
+  section += section_size(frozen->ecount, sizeof(VertexId));
+  frozen->out_offsets = (long long int *) section;
+  section += section_size(frozen->vcount + 1, sizeof(long long int));
+  frozen->out_edges = (VertexId *) section;
+  section += section_size(frozen->ecount, sizeof(VertexId));
+  frozen->in_times = NULL;
+  if (flags & SNAPSHOT_IN_TIMES) {
+    frozen->in_times = (Timestamp *) section;
+    section += section_size(frozen->ecount, sizeof(Timestamp));
+  }
+  frozen->public_ids = NULL;
+  frozen->internal_ids = NULL;
+  if (flags & SNAPSHOT_ORDERED) {
+    frozen->public_ids = (VertexId *) section;
+    section += section_size(frozen->vcount, sizeof(VertexId));
+    frozen->internal_ids = (VertexId *) section;
+  }
+}
+
+/**
+ * \function write_section
+ * \brief Write an array to a snapshot file, followed by its padding.
+ *
+ * \param file The snapshot file.
+ * \param array The array.
+ * \param count The number of elements.
+ * \param size The size of an element.
+ *
+ * \return True if the array was written, False otherwise.
+ */
+static bool write_section(FILE *file, const void *array, long long int count, long long int size) {
+  static const char padding[8] = {0};
+  long long int padding_size = section_size(count, size) - count * size;
+  return fwrite(array, size, count, file) == (size_t) count &&
+         fwrite(padding, 1, padding_size, file) == (size_t) padding_size;
+}
+
+/**
+ * \function save_frozen_graph
+ * \brief Write a frozen graph to a snapshot file.
+ *
+ * \param frozen The input frozen graph.
+ * \param path The file to write (replaced if it exists).
+ * \param error Set to the error code on failure (errno describes the cause).
+ *
+ * \return True if the snapshot was written, False otherwise.
+ */
+bool save_frozen_graph(FrozenGraph *frozen, const char *path, int *error) {
+
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(SnapshotHeader));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.byte_order = SNAPSHOT_BYTE_ORDER;
+  header.vcount = frozen->vcount;
+  header.ecount = frozen->ecount;
+  header.id_size = sizeof(VertexId) == 8 ? 0 : sizeof(VertexId);
+  header.timestamp_size = sizeof(Timestamp) == 8 ? 0 : sizeof(Timestamp);
+  header.flags = (frozen->in_times != NULL ? SNAPSHOT_IN_TIMES : 0) |
+                 (frozen->public_ids != NULL ? SNAPSHOT_ORDERED : 0);
+
+  FILE *file = fopen(path, "wb");
+  if (file==NULL) {
+    *error = 4;
+    return false;
+  }
+  bool written =
+    fwrite(&header, sizeof(SnapshotHeader), 1, file) == 1 &&
+    write_section(file, frozen->timestamps, frozen->vcount, sizeof(Timestamp)) &&
+    write_section(file, frozen->in_offsets, frozen->vcount + 1, sizeof(long long int)) &&
+    write_section(file, frozen->in_edges, frozen->ecount, sizeof(VertexId)) &&
+    write_section(file, frozen->out_offsets, frozen->vcount + 1, sizeof(long long int)) &&
+    write_section(file, frozen->out_edges, frozen->ecount, sizeof(VertexId)) &&
+    (frozen->in_times == NULL || write_section(file, frozen->in_times, frozen->ecount, sizeof(Timestamp))) &&
+    (frozen->public_ids == NULL ||
+     (write_section(file, frozen->public_ids, frozen->vcount, sizeof(VertexId)) &&
+      write_section(file, frozen->internal_ids, frozen->vcount, sizeof(VertexId))));
+  if (fclose(file) != 0 || !written) {
+    *error = 4;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * \function map_frozen_graph
+ * \brief Load a frozen graph from a snapshot file by mapping it into memory.
+ *
+ * Nothing is copied or parsed: the arrays of the frozen graph point into a
+ * read-only shared mapping of the file, so processes mapping the same file
+ * share one copy of it in the page cache. Only the header and the offset
+ * totals are checked.
+ *
+ * \param frozen The frozen graph to fill (free with free_frozen_graph).
+ * \param path The snapshot file.
+ * \param error Set to the error code on failure (errno describes the cause
+ *              when it is 4).
+ *
+ * \return True if the snapshot was mapped, False otherwise.
+ */
+bool map_frozen_graph(FrozenGraph *frozen, const char *path, int *error) {
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    *error = 4;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    *error = 4;
+    return false;
+  }
+  if (st.st_size < (off_t) sizeof(SnapshotHeader)) {
+    close(fd);
+    *error = 5;
+    return false;
+  }
+  char *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    *error = 4;
+    return false;
+  }
+
+  /* check the header and that the arrays fill the file exactly */
+  SnapshotHeader *header = (SnapshotHeader *) data;
+  bool valid = memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 &&
+               header->version == SNAPSHOT_VERSION &&
+               header->byte_order == SNAPSHOT_BYTE_ORDER &&
+               header->id_size == (sizeof(VertexId) == 8 ? 0 : sizeof(VertexId)) &&
+               header->timestamp_size == (sizeof(Timestamp) == 8 ? 0 : sizeof(Timestamp)) &&
+               header->vcount >= 0 && header->vcount <= st.st_size / 8 &&
+               header->ecount >= 0 && header->ecount <= st.st_size / 8 &&
+               (header->flags & ~(SNAPSHOT_IN_TIMES | SNAPSHOT_ORDERED)) == 0 &&
+               snapshot_size(header->vcount, header->ecount, header->flags) == st.st_size;
+  if (valid) {
+    frozen->vcount = header->vcount;
+    frozen->ecount = header->ecount;
+    point_into_snapshot(frozen, data, header->flags);
+    valid = frozen->in_offsets[0] == 0 && frozen->in_offsets[frozen->vcount] == frozen->ecount &&
+            frozen->out_offsets[0] == 0 && frozen->out_offsets[frozen->vcount] == frozen->ecount;
+  }
+  if (!valid) {
+    munmap(data, st.st_size);
+    *error = 5;
+    return false;
+  }
+
+  frozen->mapping = data;
+  frozen->mapping_size = st.st_size;
+  return true;
+}
+
+/**
+ * \function unmap_frozen_graph
+ * \brief Release the mapping of a frozen graph loaded with map_frozen_graph.
+ *
+ * \param frozen The input frozen graph.
+ */
+void unmap_frozen_graph(FrozenGraph *frozen) {
+  munmap(frozen->mapping, frozen->mapping_size);
+  frozen->mapping = NULL;
+  frozen->mapping_size = 0;
+}
@@ -0,0 +1,287 @@
+/*
+  cdindex library.
+  Copyright (C) 2017 Russell J. Funk <russellfunk@gmail.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "cdindex.h"
+
+/* The counters of each thread are kept in a block of its own, so recording
+   a call takes no lock and shares no cache line with other threads. Only the
+   owning thread writes a block, with relaxed loads and stores, so readers
+   summing the blocks see every counter whole. A block goes back to a free
+   list when its thread exits, keeping its totals, and is reused by the next
+   new thread, so there are never more blocks than threads that ran at once. */
+typedef struct StatsBlock {
+  struct StatsBlock *next;
+  bool in_use;
+  atomic_llong calls;
+  atomic_llong vertices_visited;
+  atomic_llong in_edges_scanned;
+  atomic_llong in_edges_in_window;
+  atomic_llong it_vertices;
+  atomic_llong membership_probes;
+  atomic_llong nanoseconds;
+  atomic_llong it_histogram[STATS_BUCKETS];
+  atomic_llong time_histogram[STATS_BUCKETS];
+} StatsBlock;
+
+static StatsBlock *stats_blocks = NULL;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local StatsBlock *thread_block = NULL;
+static pthread_key_t thread_block_key;
+static pthread_once_t thread_block_once = PTHREAD_ONCE_INIT;
+
+/**
+ * \function release_thread_block
+ * \brief Return the stats block of a thread for reuse when the thread exits.
+ *
+ * \param block The block.
+ */
+static void release_thread_block(void *block) {
+  pthread_mutex_lock(&stats_lock);
+  ((StatsBlock *) block)->in_use = false;
+  pthread_mutex_unlock(&stats_lock);
+}
+
+/**
+ * \function create_thread_block_key
+ * \brief Create the key that releases thread stats blocks (run once).
+ */
+static void create_thread_block_key(void) {
+  pthread_key_create(&thread_block_key, release_thread_block);
+}
+
+/**
+ * \function get_thread_block
+ * \brief Get the stats block of the calling thread.
+ *
+ * \return The block, claimed from the free blocks or allocated on first use.
+ */
+static StatsBlock *get_thread_block(void) {
+  if (thread_block == NULL) {
+    pthread_once(&thread_block_once, create_thread_block_key);
+    pthread_mutex_lock(&stats_lock);
+    StatsBlock *block = stats_blocks;
+    while (block != NULL && block->in_use) {
+      block = block->next;
+    }
+    if (block == NULL) {
+      block = calloc(1, sizeof(StatsBlock));
+      if (block==NULL) {
+        raise_error(0);
+      }
+      block->next = stats_blocks;
+      stats_blocks = block;
+    }
+    block->in_use = true;
+    pthread_mutex_unlock(&stats_lock);
+    pthread_setspecific(thread_block_key, block);
+    thread_block = block;
+  }
+  return thread_block;
+}
+
+/**
+ * \function stats_bucket
+ * \brief Find the histogram bucket of a value.
+ *
+ * Values below 8 have a bucket each; above, each power of two is split into
+ * four buckets, so a bucket spans at most a quarter of its values.
+ *
+ * \param value The value (negative values count as 0).
+ *
+ * \return The bucket, below STATS_BUCKETS.
+ */
+static int stats_bucket(long long int value) {
+  if (value < 8) {
+    return value > 0 ? (int) value : 0;
+  }
+  int log = 3;
+  while (value >> (log + 1)) {
+    log++;
+  }
+  return 4 * (log - 1) + (int) ((value >> (log - 2)) & 3);
+}
+
+/**
+ * \function stats_bucket_start
+ * \brief Find the smallest value of a histogram bucket.
+ *
+ * \param bucket The bucket.
+ *
+ * \return The smallest value counted in the bucket.
+ */
+static double stats_bucket_start(int bucket) {
+  if (bucket < 8) {
+    return bucket;
+  }
+  return ldexp(4 + bucket % 4, bucket / 4 - 1);
+}
+
+/**
+ * \function add_relaxed
+ * \brief Add to a counter only the calling thread writes.
+ *
+ * \param counter The counter.
+ * \param value The value to add.
+ */
+static inline void add_relaxed(atomic_llong *counter, long long int value) {
+  atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+                        memory_order_relaxed);
+}
+
+/**
+ * \function stats_enabled
+ * \brief See if the library was built with the stats counters.
+ *
+ * \return Whether the index computations are counted (built with CDINDEX_STATS).
+ */
+bool stats_enabled(void) {
+#ifdef CDINDEX_STATS
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * \function stats_start_call
+ * \brief Start counting an index computation.
+ *
+ * \param call The counters of the computation.
+ */
+void stats_start_call(CallStats *call) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  memset(call, 0, sizeof(CallStats));
+  call->start = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * \function stats_end_call
+ * \brief Add the counters of a finished computation to the calling thread's
+ *        totals and histograms.
+ *
+ * \param call The counters of the computation.
+ */
+void stats_end_call(CallStats *call) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  long long int nanoseconds = ts.tv_sec * 1000000000LL + ts.tv_nsec - call->start;
+  StatsBlock *block = get_thread_block();
+  add_relaxed(&block->calls, 1);
+  add_relaxed(&block->vertices_visited, call->vertices_visited);
+  add_relaxed(&block->in_edges_scanned, call->in_edges_scanned);
+  add_relaxed(&block->in_edges_in_window, call->in_edges_in_window);
+  add_relaxed(&block->it_vertices, call->it_vertices);
+  add_relaxed(&block->membership_probes, call->membership_probes);
+  add_relaxed(&block->nanoseconds, nanoseconds);
+  add_relaxed(&block->it_histogram[stats_bucket(call->it_vertices)], 1);
+  add_relaxed(&block->time_histogram[stats_bucket(nanoseconds)], 1);
+}
+
+/**
+ * \function get_stats
+ * \brief Sum the counters of every thread since the last reset.
+ *
+ * Calls still running in other threads are not included.
+ *
+ * \param stats The stats to fill.
+ */
+void get_stats(IndexStats *stats) {
+  memset(stats, 0, sizeof(IndexStats));
+  pthread_mutex_lock(&stats_lock);
+  for (StatsBlock *block = stats_blocks; block != NULL; block = block->next) {
+    stats->calls += atomic_load_explicit(&block->calls, memory_order_relaxed);
+    stats->vertices_visited += atomic_load_explicit(&block->vertices_visited, memory_order_relaxed);
+    stats->in_edges_scanned += atomic_load_explicit(&block->in_edges_scanned, memory_order_relaxed);
+    stats->in_edges_in_window += atomic_load_explicit(&block->in_edges_in_window, memory_order_relaxed);
+    stats->it_vertices += atomic_load_explicit(&block->it_vertices, memory_order_relaxed);
+    stats->membership_probes += atomic_load_explicit(&block->membership_probes, memory_order_relaxed);
+    stats->nanoseconds += atomic_load_explicit(&block->nanoseconds, memory_order_relaxed);
+    for (int b = 0; b < STATS_BUCKETS; b++) {
+      stats->it_histogram[b] += atomic_load_explicit(&block->it_histogram[b], memory_order_relaxed);
+      stats->time_histogram[b] += atomic_load_explicit(&block->time_histogram[b], memory_order_relaxed);
+    }
+  }
+  pthread_mutex_unlock(&stats_lock);
+}
+
+/**
+ * \function reset_stats
+ * \brief Zero the counters of every thread.
+ *
+ * This should be called while no index is being computed: a call finishing
+ * during the reset may keep part of its counts.
+ */
+void reset_stats(void) {
+  pthread_mutex_lock(&stats_lock);
+  for (StatsBlock *block = stats_blocks; block != NULL; block = block->next) {
+    atomic_store_explicit(&block->calls, 0, memory_order_relaxed);
+    atomic_store_explicit(&block->vertices_visited, 0, memory_order_relaxed);
+    atomic_store_explicit(&block->in_edges_scanned, 0, memory_order_relaxed);
+    atomic_store_explicit(&block->in_edges_in_window, 0, memory_order_relaxed);
+    atomic_store_explicit(&block->it_vertices, 0, memory_order_relaxed);
+    atomic_store_explicit(&block->membership_probes, 0, memory_order_relaxed);
+    atomic_store_explicit(&block->nanoseconds, 0, memory_order_relaxed);
+    for (int b = 0; b < STATS_BUCKETS; b++) {
+      atomic_store_explicit(&block->it_histogram[b], 0, memory_order_relaxed);
+      atomic_store_explicit(&block->time_histogram[b], 0, memory_order_relaxed);
+    }
+  }
+  pthread_mutex_unlock(&stats_lock);
+}
+
+/**
+ * \function stats_percentile
+ * \brief Estimate a percentile of a stats histogram.
+ *
+ * \param histogram The histogram (STATS_BUCKETS counts).
+ * \param fraction The percentile as a fraction (e.g., 0.99).
+ *
+ * \return The middle of the bucket holding the percentile (NAN if the
+ *         histogram is empty); values below 8 are exact.
+ */
+double stats_percentile(long long int *histogram, double fraction) {
+  long long int total = 0;
+  for (int b = 0; b < STATS_BUCKETS; b++) {
+    total += histogram[b];
+  }
+  if (total == 0) {
+    return NAN;
+  }
+  long long int rank = (long long int) ceil(fraction * total);
+  rank = rank > 0 ? rank : 1;
+  long long int seen = 0;
+  int b = 0;
+  for (; b < STATS_BUCKETS - 1; b++) {
+    seen += histogram[b];
+    if (seen >= rank) {
+      break;
+    }
+  }
+  if (b < 8) {
+    return b;
+  }
+  return (stats_bucket_start(b) + stats_bucket_start(b + 1)) / 2.0;
+}
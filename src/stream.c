@@ -0,0 +1,203 @@
+/*
+  cdindex library.
+  Copyright (C) 2017 Russell J. Funk <russellfunk@gmail.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "cdindex.h"
+
+/**
+ * \function reserve_stream
+ * \brief Make sure a stream has accumulators for vcount vertices.
+ *
+ * \param stream The input stream.
+ * \param vcount The number of vertices.
+ */
+static void reserve_stream(Stream *stream, long long int vcount) {
+  if (vcount <= stream->capacity) {
+    return;
+  }
+  long long int capacity = stream->capacity > 0 ? stream->capacity : 64;
+  while (capacity < vcount) {
+    capacity *= 2;
+  }
+  long long int *sums = realloc(stream->sums, capacity * stream->k * sizeof(long long int));
+  if (sums==NULL) {
+    raise_error(0);
+  }
+  stream->sums = sums;
+  long long int *counts = realloc(stream->counts, capacity * stream->k * sizeof(long long int));
+  if (counts==NULL) {
+    raise_error(0);
+  }
+  stream->counts = counts;
+  stream->capacity = capacity;
+}
+
+/**
+ * \function init_stream
+ * \brief Start streaming CD index updates for a graph.
+ *
+ * The accumulators of the vertices already in the graph are computed from
+ * scratch. From then on, vertices must only be added to the graph with
+ * stream_add_vertex, which keeps the accumulators up to date.
+ *
+ * \param stream The stream to fill (free with free_stream).
+ * \param graph The graph, which the stream uses but does not own.
+ * \param time_deltas Times beyond stamp of focal vertex to track.
+ * \param k The number of time deltas (at least 1).
+ */
+void init_stream(Stream *stream, Graph *graph, long long int *time_deltas, long long int k) {
+  stream->graph = graph;
+  stream->k = k;
+  stream->time_deltas = malloc(k * sizeof(long long int));
+  if (stream->time_deltas==NULL) {
+    raise_error(0);
+  }
+  memcpy(stream->time_deltas, time_deltas, k * sizeof(long long int));
+  stream->sums = NULL;
+  stream->counts = NULL;
+  stream->capacity = 0;
+  reserve_stream(stream, graph->vcount);
+  for (long long int i = 0; i < graph->vcount; i++) {
+    cdindex_multi_counts(graph, i, time_deltas, k, stream->sums + i * k, stream->counts + i * k);
+  }
+}
+
+/**
+ * \function stream_add_vertex
+ * \brief Add a vertex and its out edges to the graph of a stream.
+ *
+ * The new vertex is an "it" vertex only for the vertices it cites and the
+ * vertices that cite them, and only those accumulators change: each gains
+ * the new vertex's contribution in the horizons its timestamp falls within.
+ * The accumulators of the new vertex itself are computed from scratch,
+ * because earlier-added vertices with later timestamps may already cite its
+ * references. The out edges of existing vertices must not change.
+ *
+ * \param stream The input stream.
+ * \param id The id of the new vertex (the number of vertices in the graph).
+ * \param timestamp The timestamp of the new vertex.
+ * \param refs The ids of the distinct vertices the new vertex cites.
+ * \param ref_count The number of references.
+ */
+void stream_add_vertex(Stream *stream, long long int id, long long int timestamp, long long int *refs, long long int ref_count) {
+
+  Graph *graph = stream->graph;
+  long long int k = stream->k;
+  long long int i, j;
+
+  add_vertex(graph, id, timestamp);
+  for (i = 0; i < ref_count; i++) {
+    add_edge(graph, id, refs[i]);
+  }
+  reserve_stream(stream, graph->vcount);
+
+  /* the references of the new vertex, sorted for searches and intersections */
+  VertexId *cited = malloc((ref_count > 0 ? ref_count : 1) * sizeof(VertexId));
+  if (cited==NULL) {
+    raise_error(0);
+  }
+  for (i = 0; i < ref_count; i++) {
+    cited[i] = refs[i];
+  }
+  qsort(cited, ref_count, sizeof(VertexId), compare_id);
+
+  /* collect the affected focal vertices once each: the references of the
+     new vertex and the vertices that cite them */
+  Scratch *scratch = get_thread_scratch(graph->vcount);
+  long long int affected_count = 0;
+  for (i = 0; i < ref_count; i++) {
+    Vertex *ref = &graph->vs[cited[i]];
+    for (j = -1; j < ref->in_degree; j++) {
+      long long int focal = j < 0 ? cited[i] : ref->in_edges[j];
+      unsigned long long int bit = 1ULL << (focal & 63);
+      if (focal == id || (scratch->visited[focal >> 6] & bit)) {
+        continue;
+      }
+      scratch->visited[focal >> 6] |= bit;
+      if (affected_count == scratch->it_capacity) {
+        long long int *tmp = realloc(scratch->it, 2 * scratch->it_capacity * sizeof(long long int));
+        if (tmp==NULL) {
+          raise_error(0);
+        }
+        scratch->it = tmp;
+        scratch->it_capacity *= 2;
+      }
+      scratch->it[affected_count++] = focal;
+    }
+  }
+
+  /* add the contribution of the new vertex to each affected focal vertex */
+  for (i = 0; i < affected_count; i++) {
+    long long int focal = scratch->it[i];
+    Vertex *f = &graph->vs[focal];
+    scratch->visited[focal >> 6] = 0;
+    if (timestamp <= f->timestamp) {
+      continue;
+    }
+    long long int f_it = in_sorted_id_array(cited, ref_count, focal);
+    long long int b_it = 0;
+    if (f_it && graph->out_edges_sorted) {
+      b_it = sorted_id_arrays_intersect(f->out_edges, f->out_degree, cited, ref_count);
+    }
+    else {
+      for (j = 0; j < f->out_degree && f_it && !b_it; j++) {
+        b_it = in_sorted_id_array(cited, ref_count, f->out_edges[j]);
+      }
+    }
+    long long int contribution = -2*f_it*b_it + f_it;
+    for (long long int h = 0; h < k; h++) {
+      if (timestamp - f->timestamp <= stream->time_deltas[h]) {
+        stream->sums[focal * k + h] += contribution;
+        stream->counts[focal * k + h]++;
+      }
+    }
+  }
+
+  cdindex_multi_counts(graph, id, stream->time_deltas, k, stream->sums + id * k, stream->counts + id * k);
+  free(cited);
+}
+
+/**
+ * \function stream_cdindex
+ * \brief Get the CD Index of a vertex at one of the tracked time deltas.
+ *
+ * \param stream The input stream.
+ * \param id The focal vertex id.
+ * \param horizon The position of the time delta in the stream's time deltas.
+ *
+ * \return The value of the CD index (NAN if there are no "it" vertices).
+ */
+double stream_cdindex(Stream *stream, long long int id, long long int horizon) {
+  long long int count = stream->counts[id * stream->k + horizon];
+  return count > 0 ? (double) stream->sums[id * stream->k + horizon] / count : NAN;
+}
+
+/**
+ * \function free_stream
+ * \brief Free memory taken by a stream (but not its graph).
+ *
+ * \param stream The input stream.
+ */
+void free_stream(Stream *stream) {
+  free(stream->time_deltas);
+  free(stream->sums);
+  free(stream->counts);
+}
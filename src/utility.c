@@ -19,21 +19,46 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include "cdindex.h"
+
+/* scratch used by the index functions of the calling thread; the key frees
+   it when a thread that used it exits */
+static _Thread_local Scratch *thread_scratch = NULL;
+static pthread_key_t thread_scratch_key;
+static pthread_once_t thread_scratch_once = PTHREAD_ONCE_INIT;
 
 /**
- * \function raise_error
- * \brief Raise an error.
+ * \function error_message
+ * \brief Get the message for an error code.
  *
  * \param code The error code.
+ *
+ * \return The error message.
  */
-void raise_error(int code) {
-  const char *error[4];
+const char *error_message(int code) {
+  const char *error[8];
   error[0] = "Problem (re)allocating memory";
   error[1] = "Vertex ids must be added sequentially from 0";
   error[2] = "One or more vertices are not in the graph";
   error[3] = "The edge being added is already in the graph";
+  error[4] = "Could not read or write the graph snapshot file";
+  error[5] = "The file is not a graph snapshot of a supported version";
+  error[6] = "An arena can only be added to an empty graph";
+  error[7] = "The vertex id or timestamp does not fit the compact graph types";
+
+  return error[code];
+}
 
-  fprintf(stderr, "%s\n", error[code]);
+/**
+ * \function raise_error
+ * \brief Raise an error.
+ *
+ * \param code The error code.
+ */
+void raise_error(int code) {
+  fprintf(stderr, "%s\n", error_message(code));
   exit(EXIT_FAILURE);
 }
 
@@ -48,13 +73,12 @@ void raise_error(int code) {
  * \return Whether value is in the array.
  */
 bool in_int_array(long long int *array, long long int sizeof_array, long long int value) {
-  bool in_array = false;
   for (long long int i = 0; i < sizeof_array; i++) {
     if (array[i] == value) {
-      in_array = true;
+      return true;
     }
   }
-  return in_array;
+  return false;
 }
 
 /**
@@ -79,3 +103,205 @@ long long int *tmp;
   }
   (*array)[sizeof_array] = value;
 }
+
+/**
+ * \function compare_int
+ * \brief Compare two integers (for use with qsort).
+ *
+ * \param a Pointer to the first integer.
+ * \param b Pointer to the second integer.
+ *
+ * \return Negative, zero, or positive as a is less than, equal to, or greater than b.
+ */
+int compare_int(const void *a, const void *b) {
+  long long int x = *(const long long int *) a;
+  long long int y = *(const long long int *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * \function compare_id
+ * \brief Compare two vertex ids (for use with qsort).
+ *
+ * \param a Pointer to the first vertex id.
+ * \param b Pointer to the second vertex id.
+ *
+ * \return Negative, zero, or positive as a is less than, equal to, or greater than b.
+ */
+int compare_id(const void *a, const void *b) {
+  VertexId x = *(const VertexId *) a;
+  VertexId y = *(const VertexId *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * \function reserve_scratch
+ * \brief Make sure a scratch can be used on a graph with vcount vertices.
+ *
+ * The visited bitset is only ever grown, and new words are cleared; the index
+ * functions clear the bits they set before returning, so a scratch can be
+ * reused across calls without being reset.
+ *
+ * \param scratch The input scratch (zero initialized before first use).
+ * \param vcount The number of vertices in the graph.
+ */
+void reserve_scratch(Scratch *scratch, long long int vcount) {
+  if (vcount > scratch->vcount) {
+    long long int old_words = (scratch->vcount + 63) / 64;
+    long long int new_words = (vcount + 63) / 64;
+    unsigned long long int *tmp = realloc(scratch->visited, new_words * sizeof(unsigned long long int));
+    if (tmp==NULL) {
+      raise_error(0);
+    }
+    memset(tmp + old_words, 0, (new_words - old_words) * sizeof(unsigned long long int));
+    scratch->visited = tmp;
+    scratch->vcount = vcount;
+  }
+  if (scratch->it == NULL) {
+    scratch->it = malloc(64 * sizeof(long long int));
+    if (scratch->it==NULL) {
+      raise_error(0);
+    }
+    scratch->it_capacity = 64;
+  }
+}
+
+/**
+ * \function reserve_scratch_horizons
+ * \brief Make sure a scratch can hold the components of k horizons.
+ *
+ * \param scratch The input scratch.
+ * \param k The number of horizons.
+ */
+void reserve_scratch_horizons(Scratch *scratch, long long int k) {
+  if (k > scratch->horizon_capacity) {
+    CDComponents *horizons = realloc(scratch->horizons, k * sizeof(CDComponents));
+    if (horizons==NULL) {
+      raise_error(0);
+    }
+    scratch->horizons = horizons;
+    scratch->horizon_capacity = k;
+  }
+}
+
+/**
+ * \function reserve_scratch_neighbors
+ * \brief Make sure a scratch can hold count decoded neighbors.
+ *
+ * \param scratch The input scratch.
+ * \param count The number of neighbors.
+ */
+void reserve_scratch_neighbors(Scratch *scratch, long long int count) {
+  if (count > scratch->neighbors_capacity) {
+    long long int capacity = scratch->neighbors_capacity > 0 ? scratch->neighbors_capacity : 64;
+    while (capacity < count) {
+      capacity *= 2;
+    }
+    VertexId *tmp = realloc(scratch->neighbors, capacity * sizeof(VertexId));
+    if (tmp==NULL) {
+      raise_error(0);
+    }
+    scratch->neighbors = tmp;
+    scratch->neighbors_capacity = capacity;
+  }
+}
+
+/**
+ * \function free_scratch
+ * \brief Free memory taken by a scratch.
+ *
+ * \param scratch The input scratch.
+ */
+void free_scratch(Scratch *scratch) {
+  free(scratch->visited);
+  free(scratch->it);
+  free(scratch->horizons);
+  free(scratch->neighbors);
+  scratch->vcount = 0;
+  scratch->visited = NULL;
+  scratch->it = NULL;
+  scratch->it_capacity = 0;
+  scratch->horizons = NULL;
+  scratch->horizon_capacity = 0;
+  scratch->neighbors = NULL;
+  scratch->neighbors_capacity = 0;
+}
+
+/**
+ * \function destroy_thread_scratch
+ * \brief Free a thread scratch when its thread exits.
+ *
+ * \param scratch The scratch.
+ */
+static void destroy_thread_scratch(void *scratch) {
+  free_scratch(scratch);
+  free(scratch);
+}
+
+/**
+ * \function create_thread_scratch_key
+ * \brief Create the key that frees thread scratches (run once).
+ */
+static void create_thread_scratch_key(void) {
+  pthread_key_create(&thread_scratch_key, destroy_thread_scratch);
+}
+
+/**
+ * \function get_thread_scratch
+ * \brief Get the scratch of the calling thread, sized for vcount vertices.
+ *
+ * The scratch is created on first use and freed when the thread exits (or by
+ * free_thread_scratch), so index functions can be called from any thread.
+ *
+ * \param vcount The number of vertices in the graph.
+ *
+ * \return The scratch of the calling thread.
+ */
+Scratch *get_thread_scratch(long long int vcount) {
+  if (thread_scratch == NULL) {
+    pthread_once(&thread_scratch_once, create_thread_scratch_key);
+    thread_scratch = calloc(1, sizeof(Scratch));
+    if (thread_scratch==NULL) {
+      raise_error(0);
+    }
+    pthread_setspecific(thread_scratch_key, thread_scratch);
+  }
+  reserve_scratch(thread_scratch, vcount);
+  return thread_scratch;
+}
+
+/**
+ * \function free_thread_scratch
+ * \brief Free memory taken by the scratch of the calling thread.
+ */
+void free_thread_scratch(void) {
+  if (thread_scratch != NULL) {
+    pthread_setspecific(thread_scratch_key, NULL);
+    destroy_thread_scratch(thread_scratch);
+    thread_scratch = NULL;
+  }
+}
+
+/**
+ * \function in_sorted_id_array
+ * \brief See if a vertex id is in a sorted vertex id array (binary search).
+ *
+ * \param array The input array, in increasing order.
+ * \param sizeof_array The size of the input array.
+ * \param value The value to look for in the input array.
+ *
+ * \return Whether value is in the array.
+ */
+bool in_sorted_id_array(VertexId *array, long long int sizeof_array, long long int value) {
+  long long int lo = 0, hi = sizeof_array;
+  while (lo < hi) {
+    long long int mid = lo + (hi - lo) / 2;
+    if (array[mid] < value) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo < sizeof_array && array[lo] == value;
+}
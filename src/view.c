@@ -0,0 +1,343 @@
+/*
+  cdindex library.
+  Copyright (C) 2017 Russell J. Funk <russellfunk@gmail.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include "cdindex.h"
+
+/* A view needs no index of its own. The citers a focal vertex f counts are
+   in the window (t_f, t_f + time_delta], so they are visible exactly when
+   the window is shortened to min(time_delta, cutoff - t_f). The references
+   of f can be later than f, and those after the cutoff are dropped by the
+   *_as_of functions of the underlying graph, which the functions below hand
+   the shortened horizons to. The I index only counts citers, so it needs
+   the shortened horizon alone. */
+
+/* horizons shortened on the stack before falling back to the heap */
+#define VIEW_STACK_HORIZONS 16
+
+/**
+ * \function view_timestamp
+ * \brief Get the timestamp of a vertex of the graph under a view.
+ *
+ * \param view The input view.
+ * \param id The vertex id.
+ *
+ * \return The timestamp of the vertex.
+ */
+long long int view_timestamp(GraphView *view, long long int id) {
+  if (view->frozen != NULL) {
+    FrozenGraph *frozen = view->frozen;
+    return frozen->timestamps[frozen->internal_ids != NULL ? frozen->internal_ids[id] : id];
+  }
+  if (view->compressed != NULL) {
+    return view->compressed->timestamps[id];
+  }
+  return view->graph->vs[id].timestamp;
+}
+
+/**
+ * \function view_has_vertex
+ * \brief See if a vertex is visible in a view.
+ *
+ * \param view The input view.
+ * \param id The vertex id.
+ *
+ * \return True if the vertex is no later than the cutoff, False otherwise.
+ */
+bool view_has_vertex(GraphView *view, long long int id) {
+  return view_timestamp(view, id) <= view->cutoff;
+}
+
+/**
+ * \function view_vcount
+ * \brief Get the number of vertices of the graph under a view, hidden or not.
+ *
+ * \param view The input view.
+ *
+ * \return The number of vertices.
+ */
+static inline long long int view_vcount(GraphView *view) {
+  if (view->frozen != NULL) {
+    return view->frozen->vcount;
+  }
+  if (view->compressed != NULL) {
+    return view->compressed->vcount;
+  }
+  return view->graph->vcount;
+}
+
+/**
+ * \function clamp_time_delta
+ * \brief Shorten a time delta so its window ends by the cutoff of a view.
+ *
+ * \param view The input view.
+ * \param t_f The timestamp of a visible focal vertex.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ *
+ * \return The time delta, or cutoff - t_f if the window would pass the cutoff.
+ */
+static inline long long int clamp_time_delta(GraphView *view, long long int t_f, long long int time_delta) {
+  return time_delta > view->cutoff - t_f ? view->cutoff - t_f : time_delta;
+}
+
+/**
+ * \function view_cdindex_multi_components
+ * \brief Computes the components of the CD Index of a vertex of a view at several time deltas.
+ *
+ * \param view The input view.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of k components to fill (all zero, with NAN indices, if
+ *            the focal vertex is hidden).
+ */
+void view_cdindex_multi_components(GraphView *view, long long int id, long long int *time_deltas, long long int k, CDComponents *out) {
+
+  long long int t_f = view_timestamp(view, id);
+  if (t_f > view->cutoff) {
+    for (long long int h = 0; h < k; h++) {
+      out[h] = (CDComponents) {0, 0, 0, 0, NAN, NAN};
+    }
+    return;
+  }
+
+  long long int stack_deltas[VIEW_STACK_HORIZONS];
+  long long int *deltas = stack_deltas;
+  if (k > VIEW_STACK_HORIZONS) {
+    deltas = malloc(k * sizeof(long long int));
+    if (deltas==NULL) {
+      raise_error(0);
+    }
+  }
+  for (long long int h = 0; h < k; h++) {
+    deltas[h] = clamp_time_delta(view, t_f, time_deltas[h]);
+  }
+
+  if (view->frozen != NULL) {
+    frozen_cdindex_multi_components_as_of(view->frozen, id, deltas, k, view->cutoff, out);
+  }
+  else if (view->compressed != NULL) {
+    compressed_cdindex_multi_components_as_of(view->compressed, id, deltas, k, view->cutoff, out);
+  }
+  else {
+    cdindex_multi_components_as_of(view->graph, id, deltas, k, view->cutoff, out);
+  }
+
+  if (deltas != stack_deltas) {
+    free(deltas);
+  }
+}
+
+/**
+ * \function view_cdindex_components
+ * \brief Computes the components of the CD Index of a vertex of a view.
+ *
+ * \param view The input view.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out The components to fill.
+ */
+void view_cdindex_components(GraphView *view, long long int id, long long int time_delta, CDComponents *out) {
+  view_cdindex_multi_components(view, id, &time_delta, 1, out);
+}
+
+/**
+ * \function view_cdindex_multi
+ * \brief Computes the CD Index of a vertex of a view at several time deltas.
+ *
+ * \param view The input view.
+ * \param id The focal vertex id.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of k values to fill (NAN where the index is undefined or
+ *            the focal vertex is hidden).
+ */
+void view_cdindex_multi(GraphView *view, long long int id, long long int *time_deltas, long long int k, double *out) {
+
+  if (k <= 0) {
+    return;
+  }
+
+  Scratch *scratch = get_thread_scratch(view_vcount(view));
+  reserve_scratch_horizons(scratch, k);
+  view_cdindex_multi_components(view, id, time_deltas, k, scratch->horizons);
+  for (long long int h = 0; h < k; h++) {
+    out[h] = scratch->horizons[h].cdindex;
+  }
+}
+
+/**
+ * \function view_cdindex
+ * \brief Computes the CD Index of a vertex of a view.
+ *
+ * \param view The input view.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ *
+ * \return The value of the CD index (NAN if it is undefined or the focal
+ *         vertex is hidden).
+ */
+double view_cdindex(GraphView *view, long long int id, long long int time_delta) {
+  CDComponents components;
+  view_cdindex_components(view, id, time_delta, &components);
+  return components.cdindex;
+}
+
+/**
+ * \function view_mcdindex
+ * \brief Computes the mCD Index of a vertex of a view.
+ *
+ * \param view The input view.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ *
+ * \return The value of the mCD index (NAN if it is undefined or the focal
+ *         vertex is hidden).
+ */
+double view_mcdindex(GraphView *view, long long int id, long long int time_delta) {
+  CDComponents components;
+  view_cdindex_components(view, id, time_delta, &components);
+  return components.mcdindex;
+}
+
+/**
+ * \function view_iindex
+ * \brief Computes the I Index of a vertex of a view.
+ *
+ * \param view The input view.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ *
+ * \return The value of the I index (0 if the focal vertex is hidden).
+ */
+long long int view_iindex(GraphView *view, long long int id, long long int time_delta) {
+  long long int t_f = view_timestamp(view, id);
+  if (t_f > view->cutoff) {
+    return 0;
+  }
+  time_delta = clamp_time_delta(view, t_f, time_delta);
+  if (view->frozen != NULL) {
+    return frozen_iindex(view->frozen, id, time_delta);
+  }
+  if (view->compressed != NULL) {
+    return compressed_iindex(view->compressed, id, time_delta);
+  }
+  return iindex(view->graph, id, time_delta);
+}
+
+/**
+ * \function view_cdindex_estimate
+ * \brief Estimates the CD Index of a vertex of a view from a sample of its "it" vertices.
+ *
+ * Only frozen graphs are sampled (see frozen_cdindex_estimate); on views of
+ * other graphs the index is computed exactly.
+ *
+ * \param view The input view.
+ * \param id The focal vertex id.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param tolerance The largest half width of the confidence interval.
+ * \param confidence The confidence level of the interval, in (0, 1).
+ * \param exact_below The number of "it" vertices below which the index is computed exactly.
+ * \param seed The seed of the sample.
+ * \param out The estimate to fill (NAN values if the focal vertex is hidden).
+ */
+void view_cdindex_estimate(GraphView *view, long long int id, long long int time_delta, double tolerance, double confidence, long long int exact_below, unsigned long long int seed, CDEstimate *out) {
+  long long int t_f = view_timestamp(view, id);
+  if (t_f <= view->cutoff && view->frozen != NULL) {
+    frozen_cdindex_estimate_as_of(view->frozen, id, clamp_time_delta(view, t_f, time_delta), tolerance,
+                                  confidence, exact_below, seed, view->cutoff, out);
+    return;
+  }
+  CDComponents c;
+  view_cdindex_components(view, id, time_delta, &c);
+  out->cdindex = c.cdindex;
+  out->lower = c.cdindex;
+  out->upper = c.cdindex;
+  out->sampled = c.n_f + c.n_b + c.n_r;
+  out->exact = true;
+}
+
+/**
+ * \function view_cdindex_batch
+ * \brief Computes the CD Index of many focal vertices of a view.
+ *
+ * \param view The input view.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill (NAN where the index is undefined or
+ *            the vertex is hidden).
+ */
+void view_cdindex_batch(GraphView *view, long long int *ids, long long int n, long long int time_delta, double *out) {
+  for (long long int i = 0; i < n; i++) {
+    out[i] = view_cdindex(view, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function view_mcdindex_batch
+ * \brief Computes the mCD Index of many focal vertices of a view.
+ *
+ * \param view The input view.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill (NAN where the index is undefined or
+ *            the vertex is hidden).
+ */
+void view_mcdindex_batch(GraphView *view, long long int *ids, long long int n, long long int time_delta, double *out) {
+  for (long long int i = 0; i < n; i++) {
+    out[i] = view_mcdindex(view, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function view_iindex_batch
+ * \brief Computes the I Index of many focal vertices of a view.
+ *
+ * \param view The input view.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_delta Time beyond stamp of focal vertex to consider in measure.
+ * \param out Array of n values to fill (0 where the vertex is hidden).
+ */
+void view_iindex_batch(GraphView *view, long long int *ids, long long int n, long long int time_delta, long long int *out) {
+  for (long long int i = 0; i < n; i++) {
+    out[i] = view_iindex(view, ids[i], time_delta);
+  }
+}
+
+/**
+ * \function view_cdindex_multi_batch
+ * \brief Computes the CD Index of many focal vertices of a view at several time deltas.
+ *
+ * \param view The input view.
+ * \param ids The focal vertex ids.
+ * \param n The number of focal vertices.
+ * \param time_deltas Times beyond stamp of focal vertex to consider in measure.
+ * \param k The number of time deltas.
+ * \param out Array of n * k values to fill, k per focal vertex (NAN where the
+ *            index is undefined or the vertex is hidden).
+ */
+void view_cdindex_multi_batch(GraphView *view, long long int *ids, long long int n, long long int *time_deltas, long long int k, double *out) {
+  for (long long int i = 0; i < n; i++) {
+    view_cdindex_multi(view, ids[i], time_deltas, k, out + i * k);
+  }
+}
@@ -8,6 +8,12 @@ __copyright__ = "Copyright (C) 2024"
 
 # built in modules
 import datetime
+import threading
+import tempfile
+import shutil
+import os
+import array
+import random
 
 # custom modules
 import cdindex.cdindex
@@ -73,6 +79,21 @@ pyedges = [{"source": "4Z", "target": "2Z"},
 TEST_TIME = 157852800
 TEST_TIME_PY = datetime.timedelta(days=1827)
 
+# compare two results, treating nan as equal to nan
+def same_value(a, b):
+  """Compare two measures, where nan (an undefined index) matches nan."""
+  return a == b or (a != a and b != b)
+
+# the undefined index as the python functions (None) and arrays (nan) give it
+def none_to_nan(value):
+  """Turn None (an undefined index) into nan, to compare with batch results."""
+  return float("nan") if value is None else value
+
+# the random graph most tests compare their results on
+def random_graph():
+  """Create a random graph of 43 vertices over 8 generations with half the possible edges."""
+  return cdindex.RandomGraph(generations=(2,3,4,5,6,7,7,9), edge_fraction=0.5)
+
 # tests for the c extension
 def c_tests():
   """Run tests for c extension."""
@@ -137,6 +158,746 @@ def py_tests():
            "in edges", graph.in_edges(vertex),
            "out edges", graph.out_edges(vertex)))
 
+# tests for the frozen graph
+def frozen_tests():
+  """Run tests comparing the frozen graph with the mutable graph."""
+
+  # create graph
+  graph = _cdindex.Graph()
+  for id, time in enumerate(ctimes):
+    _cdindex.add_vertex(graph, id, time)
+  for source, target in cedges:
+    _cdindex.add_edge(graph, source, target)
+
+  # freeze the graph
+  frozen = _cdindex.freeze_graph(graph)
+
+  # compare measures on every vertex
+  matches = True
+  for vertex in _cdindex.get_vertices(graph):
+    for mutable_f, frozen_f in ((_cdindex.cdindex, _cdindex.frozen_cdindex),
+                                (_cdindex.mcdindex, _cdindex.frozen_mcdindex),
+                                (_cdindex.iindex, _cdindex.frozen_iindex)):
+      expected = mutable_f(graph, vertex, TEST_TIME)
+      actual = frozen_f(frozen, vertex, TEST_TIME)
+      if not same_value(expected, actual):
+        matches = False
+  print("Frozen graph matches: %s" % (matches))
+
+  # the same with in edges ordered by time, also after a snapshot round trip
+  by_time = _cdindex.freeze_graph(graph, True)
+  directory = tempfile.mkdtemp()
+  path = os.path.join(directory, "by_time.cdg")
+  _cdindex.save_frozen_graph(by_time, path)
+  mapped = _cdindex.map_frozen_graph(path)
+  matches = True
+  for vertex in _cdindex.get_vertices(graph):
+    for time_delta in (0, TEST_TIME, 10 * TEST_TIME):
+      for frozen_f in (_cdindex.frozen_cdindex, _cdindex.frozen_mcdindex, _cdindex.frozen_iindex):
+        expected = frozen_f(frozen, vertex, time_delta)
+        if (not same_value(expected, frozen_f(by_time, vertex, time_delta)) or
+            not same_value(expected, frozen_f(mapped, vertex, time_delta))):
+          matches = False
+  print("Time-ordered frozen graph matches: %s" % (matches))
+  del mapped
+  shutil.rmtree(directory)
+
+# tests for bulk loading
+def bulk_tests():
+  """Run tests comparing a bulk loaded graph with an incrementally built graph."""
+
+  # create graphs, reserving room for the incrementally built one and
+  # building a copy of it with an arena
+  graph = _cdindex.Graph()
+  _cdindex.graph_reserve(graph, len(ctimes), len(cedges))
+  for id, time in enumerate(ctimes):
+    _cdindex.add_vertex(graph, id, time)
+  for source, target in cedges:
+    _cdindex.add_edge(graph, source, target)
+  bulk_graph = _cdindex.Graph()
+  _cdindex.bulk_load_graph(bulk_graph, range(len(ctimes)), ctimes, cedges)
+  arena_graph = _cdindex.Graph(True)
+  for id, time in enumerate(ctimes):
+    _cdindex.add_vertex(arena_graph, id, time)
+  for source, target in cedges:
+    _cdindex.add_edge(arena_graph, source, target)
+
+  # compare the graphs
+  matches = (_cdindex.get_ecount(graph) == _cdindex.get_ecount(bulk_graph) and
+             _cdindex.get_memory_usage(arena_graph)[0] == _cdindex.get_memory_usage(graph)[0])
+  for vertex in _cdindex.get_vertices(graph):
+    if (_cdindex.get_vertex_in_edges(graph, vertex) != _cdindex.get_vertex_in_edges(arena_graph, vertex) or
+        _cdindex.get_vertex_out_edges(graph, vertex) != _cdindex.get_vertex_out_edges(arena_graph, vertex) or
+        sorted(_cdindex.get_vertex_in_edges(graph, vertex)) != sorted(_cdindex.get_vertex_in_edges(bulk_graph, vertex)) or
+        sorted(_cdindex.get_vertex_out_edges(graph, vertex)) != sorted(_cdindex.get_vertex_out_edges(bulk_graph, vertex)) or
+        not same_value(_cdindex.cdindex(graph, vertex, TEST_TIME), _cdindex.cdindex(bulk_graph, vertex, TEST_TIME))):
+      matches = False
+  print("Bulk loaded graph matches: %s" % (matches))
+
+  # duplicate edges are rejected without changing the graph
+  try:
+    _cdindex.bulk_load_graph(bulk_graph, [], [], [(4, 2)])
+    rejected = False
+  except ValueError:
+    rejected = _cdindex.get_ecount(bulk_graph) == len(cedges)
+  print("Bulk loaded duplicate rejected: %s" % (rejected))
+
+  # bogus reserve hints are refused, and a huge degree hint only sets a
+  # bounded initial edge array size
+  rejected = True
+  for vcount, ecount, error in ((-1, 0, ValueError), (0, -1, ValueError), (2**58 + 1, 0, MemoryError)):
+    graph = cdindex.Graph(names=False)
+    try:
+      graph.reserve(vcount, ecount)
+      rejected = False
+    except error:
+      pass
+    for vertex in range(4):
+      graph.add_vertex(vertex, vertex)
+    if graph.vcount() != 4:
+      rejected = False
+  graph = cdindex.Graph(names=False)
+  graph.reserve(1, 2**61)
+  graph.add_vertex(0, 0)
+  graph.add_vertex(1, 1)
+  graph.add_edge(1, 0)
+  if graph.ecount() != 1 or graph.memory_usage()[1] > 2**20:
+    rejected = False
+  print("Bogus reserve hints rejected: %s" % (rejected))
+
+  # the constructor takes generators as well as lists
+  listed = cdindex.Graph(vertices=[{"name": id, "time": time} for id, time in enumerate(ctimes)],
+                         edges=[{"source": source, "target": target} for source, target in cedges])
+  generated = cdindex.Graph(vertices=({"name": id, "time": time} for id, time in enumerate(ctimes)),
+                            edges=({"source": source, "target": target} for source, target in cedges))
+  matches = (generated.vcount() == listed.vcount() and generated.ecount() == listed.ecount() and
+             all(generated.out_edges(vertex) == listed.out_edges(vertex) for vertex in listed.vertices()))
+  print("Graph from generators matches: %s" % (matches))
+
+# tests for sorted adjacency
+def sorted_tests():
+  """Run tests comparing a graph before and after sorting its out edges."""
+
+  # create graph with unsorted out edges
+  graph = _cdindex.Graph()
+  for id, time in enumerate(ctimes):
+    _cdindex.add_vertex(graph, id, time)
+  for source, target in cedges:
+    _cdindex.add_edge(graph, source, target)
+  unsorted = [_cdindex.cdindex(graph, vertex, TEST_TIME) for vertex in _cdindex.get_vertices(graph)]
+
+  # sort the out edges and compare
+  _cdindex.sort_adjacency(graph)
+  matches = _cdindex.get_vertex_out_edges(graph, 4) == [0, 1, 2, 3]
+  for vertex in _cdindex.get_vertices(graph):
+    if not same_value(unsorted[vertex], _cdindex.cdindex(graph, vertex, TEST_TIME)):
+      matches = False
+  print("Sorted adjacency matches: %s" % (matches))
+
+# tests for the batch functions
+def batch_tests():
+  """Run tests comparing the batch functions with one call per vertex."""
+
+  # create graph
+  graph = _cdindex.Graph()
+  _cdindex.bulk_load_graph(graph, range(len(ctimes)), ctimes, cedges)
+  frozen = _cdindex.freeze_graph(graph)
+  vertices = _cdindex.get_vertices(graph)
+
+  # compare with the single vertex functions
+  matches = True
+  for single_f, batch_f, frozen_batch_f in ((_cdindex.cdindex, _cdindex.cdindex_batch, _cdindex.frozen_cdindex_batch),
+                                            (_cdindex.mcdindex, _cdindex.mcdindex_batch, _cdindex.frozen_mcdindex_batch),
+                                            (_cdindex.iindex, _cdindex.iindex_batch, _cdindex.frozen_iindex_batch)):
+    batch = batch_f(graph, vertices, TEST_TIME)
+    frozen_batch = frozen_batch_f(frozen, vertices, TEST_TIME)
+    parallel = batch_f(graph, None, TEST_TIME, 4)
+    frozen_parallel = frozen_batch_f(frozen, None, TEST_TIME, 4)
+    for vertex in vertices:
+      expected = single_f(graph, vertex, TEST_TIME)
+      for results in (batch, frozen_batch, parallel, frozen_parallel):
+        if not same_value(expected, results[vertex]):
+          matches = False
+  print("Batch functions match: %s" % (matches))
+
+# tests for the multi-horizon cd index
+def multi_tests():
+  """Run tests comparing the multi-horizon cd index with one call per time delta."""
+
+  # create graph
+  graph = _cdindex.Graph()
+  _cdindex.bulk_load_graph(graph, range(len(ctimes)), ctimes, cedges)
+  frozen = _cdindex.freeze_graph(graph)
+  vertices = _cdindex.get_vertices(graph)
+  deltas = [TEST_TIME, 1, 0, 3*TEST_TIME]
+
+  # compare with the single horizon functions
+  matches = True
+  for results in (_cdindex.cdindex_multi_batch(graph, vertices, deltas),
+                  _cdindex.frozen_cdindex_multi_batch(frozen, vertices, deltas),
+                  _cdindex.cdindex_multi_batch(graph, None, deltas, 4),
+                  _cdindex.frozen_cdindex_multi_batch(frozen, None, deltas, 4)):
+    for vertex in vertices:
+      for h, delta in enumerate(deltas):
+        if not same_value(_cdindex.cdindex(graph, vertex, delta), results[vertex, h]):
+          matches = False
+  print("Multi-horizon cd index matches: %s" % (matches))
+
+# tests for binary snapshots
+def snapshot_tests():
+  """Run tests comparing a mapped snapshot with the graph it was saved from."""
+
+  # create graph and save it
+  graph = random_graph()
+  directory = tempfile.mkdtemp()
+  path = os.path.join(directory, "graph.cdg")
+  graph.save_snapshot(path)
+  mapped = cdindex.MappedGraph(path)
+
+  # compare the measures
+  matches = mapped.vcount() == graph.vcount() and mapped.ecount() == graph.ecount()
+  batch = mapped.cdindex_batch(None, 2)
+  for number, vertex in enumerate(graph.vertices()):
+    for t_delta in (1, 2, 5):
+      if (mapped.cdindex(number, t_delta) != graph.cdindex(vertex, t_delta) or
+          mapped.iindex(number, t_delta) != graph.iindex(vertex, t_delta)):
+        matches = False
+    expected = mapped.cdindex(number, 2)
+    if not same_value(batch[number], none_to_nan(expected)):
+      matches = False
+  print("Mapped snapshot matches: %s" % (matches))
+
+  # a file that is not a snapshot is rejected
+  with open(path, "wb") as f:
+    f.write(b"not a snapshot")
+  try:
+    cdindex.MappedGraph(path)
+    rejected = False
+  except ValueError:
+    rejected = True
+  print("Invalid snapshot rejected: %s" % (rejected))
+  del mapped
+  shutil.rmtree(directory)
+
+# tests for streaming updates
+def stream_tests():
+  """Run tests comparing a streamed graph with a graph built at once."""
+
+  # build a graph paper by paper, starting from half of it
+  graph = random_graph()
+  vertices = list(graph.vertices())
+  start = [{"name": vertex, "time": graph.timestamp(vertex)} for vertex in vertices[:len(vertices)//2]]
+  start_edges = [{"source": vertex, "target": target} for vertex in vertices[:len(vertices)//2]
+                 for target in graph.out_edges(vertex)]
+  streamed = cdindex.StreamingGraph([1, 2, 5], start, start_edges)
+  for vertex in vertices[len(vertices)//2:]:
+    streamed.add_paper(vertex, graph.timestamp(vertex), graph.out_edges(vertex))
+
+  # compare the measures
+  matches = True
+  for vertex in vertices:
+    for t_delta in (1, 2, 5):
+      if streamed.cdindex(vertex, t_delta) != graph.cdindex(vertex, t_delta):
+        matches = False
+  print("Streamed cd index matches: %s" % (matches))
+
+# tests for computing from several python threads
+def thread_tests():
+  """Run tests computing on one graph from several python threads."""
+
+  # create graph
+  graph = random_graph()
+  vertices = list(graph.vertices())
+  expected = [graph.cdindex(vertex, 2) for vertex in vertices]
+
+  # compute from several threads at once
+  results = {}
+  def compute(thread_id):
+    results[thread_id] = list(graph.cdindex_batch(vertices, 2))
+  threads = [threading.Thread(target=compute, args=(t,)) for t in range(4)]
+  for thread in threads:
+    thread.start()
+  for thread in threads:
+    thread.join()
+
+  matches = True
+  for thread_id in range(4):
+    for a, b in zip(expected, results[thread_id]):
+      if not same_value(none_to_nan(a), b):
+        matches = False
+  print("Threaded computations match: %s" % (matches))
+
+  # a mutation attempted while another thread reads is refused and changes nothing
+  rng = random.Random(3)
+  large = cdindex.Graph(vertices=[{"name": "v%d" % i, "time": i // 100} for i in range(20000)],
+                        edges=[{"source": "v%d" % i, "target": "v%d" % j} for i in range(100, 20000)
+                               for j in set(rng.randrange(i // 100 * 100) for _ in range(10))])
+  stop = threading.Event()
+  def read():
+    while not stop.is_set():
+      large.cdindex_batch(None, 1000)
+  reader = threading.Thread(target=read)
+  reader.start()
+  refused = 0
+  unchanged = True
+  for attempt in range(200):
+    before = (large.vcount(), list(large.vertices()), large.ecount())
+    for mutate in (lambda: large.add_vertex("new%d" % attempt, 500),
+                   lambda: large.add_edge("v19999", "v%d" % attempt)):
+      try:
+        mutate()
+        before = (large.vcount(), list(large.vertices()), large.ecount())
+      except RuntimeError:
+        refused += 1
+        if (large.vcount(), list(large.vertices()), large.ecount()) != before:
+          unchanged = False
+      except ValueError:
+        pass
+    if refused >= 10:
+      break
+  stop.set()
+  reader.join()
+  print("Mutation during computation refused: %s" % (refused > 0 and unchanged))
+
+# tests for compact graphs
+def compact_tests():
+  """Run tests comparing a compact graph with a default one."""
+
+  # build the same graph in both modes
+  graph = random_graph()
+  vertices = [{"name": vertex, "time": graph.timestamp(vertex)} for vertex in graph.vertices()]
+  edges = [{"source": vertex, "target": target} for vertex in graph.vertices()
+           for target in graph.out_edges(vertex)]
+  compact = cdindex.Graph(vertices, edges, compact=True)
+
+  # compare the measures
+  matches = compact.memory_usage()[0] < graph.memory_usage()[0]
+  for vertex in graph.vertices():
+    for t_delta in (1, 2, 5):
+      if (compact.cdindex(vertex, t_delta) != graph.cdindex(vertex, t_delta) or
+          compact.mcdindex(vertex, t_delta) != graph.mcdindex(vertex, t_delta)):
+        matches = False
+  directory = tempfile.mkdtemp()
+  path = os.path.join(directory, "compact.cdg")
+  compact.save_snapshot(path)
+  mapped = cdindex.MappedGraph(path, compact=True)
+  for number, vertex in enumerate(graph.vertices()):
+    if mapped.cdindex(number, 2) != graph.cdindex(vertex, 2):
+      matches = False
+  print("Compact cd index matches: %s" % (matches))
+
+  # a snapshot only maps with its own widths, and timestamps must fit
+  try:
+    cdindex.MappedGraph(path)
+    rejected = False
+  except ValueError:
+    rejected = True
+  vcount = compact.vcount()
+  try:
+    compact.add_vertex("late", 2**40)
+    rejected = False
+  except ValueError:
+    pass
+  if "late" in compact.vertices() or compact.vcount() != vcount:
+    rejected = False
+  print("Compact range checked: %s" % (rejected))
+  del mapped
+  shutil.rmtree(directory)
+
+# tests for compressed graphs
+def compressed_tests():
+  """Run tests comparing a compressed graph with the mutable graph."""
+
+  # create graph and compress it
+  graph = random_graph()
+  vertices = list(graph.vertices())
+  expected = {(vertex, t_delta): (graph.cdindex(vertex, t_delta), graph.mcdindex(vertex, t_delta),
+                                  graph.iindex(vertex, t_delta))
+              for vertex in vertices for t_delta in (1, 2, 5)}
+  compressed_bytes = graph.compress()
+
+  # compare the measures
+  matches = compressed_bytes > 0
+  for vertex in vertices:
+    for t_delta in (1, 2, 5):
+      if (graph.cdindex(vertex, t_delta), graph.mcdindex(vertex, t_delta),
+          graph.iindex(vertex, t_delta)) != expected[vertex, t_delta]:
+        matches = False
+  batch = graph.cdindex_batch(vertices, 2)
+  multi = graph.cdindex_multi_batch(vertices, [1, 5])
+  for number, vertex in enumerate(vertices):
+    value = expected[vertex, 2][0]
+    if not same_value(batch[number], none_to_nan(value)):
+      matches = False
+    for h, t_delta in enumerate((1, 5)):
+      value = expected[vertex, t_delta][0]
+      if not same_value(multi[number, h], none_to_nan(value)):
+        matches = False
+  print("Compressed graph matches: %s" % (matches))
+
+# tests for the computation counters
+def stats_tests():
+  """Run tests checking the counters of the CD index computations."""
+
+  # count a known number of computations on each kind of graph
+  graph = random_graph()
+  vertices = list(graph.vertices())
+  cdindex.reset_stats()
+  for vertex in vertices:
+    graph.cdindex(vertex, 5)
+  graph.freeze()
+  graph.cdindex_batch(vertices, 5)
+  stats = cdindex.stats()
+
+  # the counters are consistent, or all zero if they are compiled out
+  if stats["enabled"]:
+    matches = (stats["calls"] == 2 * len(vertices) and
+               stats["in_edges_in_window"] <= stats["in_edges_scanned"] and
+               stats["it_vertices"] <= stats["in_edges_in_window"] and
+               stats["it_vertices"] <= stats["membership_probes"] and
+               stats["it_p50"] <= stats["it_p90"] <= stats["it_p99"] and
+               stats["seconds_p50"] <= stats["seconds_p99"])
+  else:
+    matches = stats["calls"] == 0 and stats["it_vertices"] == 0
+  cdindex.reset_stats()
+  matches = matches and cdindex.stats()["calls"] == 0
+  print("Stats counters match: %s" % (matches))
+
+# tests for the all-vertex sweep
+def sweep_tests():
+  """Run tests comparing the all-vertex sweep with the per-vertex computation."""
+
+  # compare on a random graph, unfrozen and frozen with time-ordered in edges
+  graph = random_graph()
+  vertices = list(graph.vertices())
+  t_deltas = [1, 3, 5]
+  expected = graph.cdindex_multi_batch(None, t_deltas)
+  results = [graph.cdindex_all(t_deltas), graph.cdindex_all(5)]
+  n_f, n_b, n_r = graph.cdindex_all_counts(5)
+  graph.freeze(by_time=True)
+  results.append(graph.cdindex_all(t_deltas))
+  matches = len(results[1]) == len(vertices)
+  for number, vertex in enumerate(vertices):
+    for h, t_delta in enumerate(t_deltas):
+      if (not same_value(results[0][number, h], expected[number, h]) or
+          not same_value(results[2][number, h], expected[number, h])):
+        matches = False
+    value = graph.cdindex(vertex, 5)
+    it_count = n_f[number] + n_b[number] + n_r[number]
+    if (not same_value(results[1][number], none_to_nan(value)) or
+        (it_count > 0 and not same_value((n_f[number] - n_b[number]) / it_count, value))):
+      matches = False
+  print("All-vertex sweep matches: %s" % (matches))
+
+# tests for the components of the cd index
+def components_tests():
+  """Run tests comparing the CD index components with the separate measures."""
+
+  # compare on every kind of graph, including vertices cited before their time
+  graph = random_graph()
+  vertices = list(graph.vertices())
+  n_f, n_b, n_r = graph.cdindex_all_counts(3)
+  matches = True
+  for kind in ("graph", "frozen", "by_time", "compressed"):
+    if kind == "frozen":
+      graph.freeze()
+    elif kind == "by_time":
+      graph.freeze(by_time=True)
+    elif kind == "compressed":
+      graph.compress()
+    for number, vertex in enumerate(vertices):
+      for t_delta in (-1, 0, 3):
+        result = graph.cdindex_components(vertex, t_delta)
+        if (result["cdindex"] != graph.cdindex(vertex, t_delta) or
+            result["iindex"] != graph.iindex(vertex, t_delta) or
+            result["mcdindex"] != (None if result["cdindex"] is None else
+                                   result["cdindex"] * result["iindex"])):
+          matches = False
+      result = graph.cdindex_components(vertex, 3)
+      if (result["n_f"], result["n_b"], result["n_r"]) != (n_f[number], n_b[number], n_r[number]):
+        matches = False
+  print("CD components match: %s" % (matches))
+
+# tests for reordered frozen graphs
+def ordering_tests():
+  """Run tests comparing frozen graphs stored in other vertex orders with the graph."""
+
+  graph = random_graph()
+  vertices = list(graph.vertices())
+  t_deltas = [1, 3, 5]
+  expected = [graph.cdindex_batch(None, 3), graph.mcdindex_batch(None, 3),
+              graph.iindex_batch(None, 3), graph.cdindex_multi_batch(None, t_deltas),
+              graph.cdindex_all(t_deltas)]
+  directory = tempfile.mkdtemp()
+  path = os.path.join(directory, "graph.cdg")
+  matches = True
+  for order in ("time", "degree", "rcm"):
+    for by_time in (False, True):
+      graph.freeze(by_time=by_time, order=order)
+      arrays = graph.arrays()
+      if sorted(arrays["public_ids"]) != list(range(len(vertices))):
+        matches = False
+      graph.save_snapshot(path)
+      mapped = cdindex.MappedGraph(path)
+      for measures in (graph, mapped):
+        results = [measures.cdindex_batch(None, 3), measures.mcdindex_batch(None, 3, threads=2),
+                   measures.iindex_batch(None, 3), measures.cdindex_multi_batch(None, t_deltas),
+                   measures.cdindex_all(t_deltas)]
+        for number in range(len(vertices)):
+          for result, values in zip(results[:3], expected[:3]):
+            if not same_value(result[number], values[number]):
+              matches = False
+          for h in range(len(t_deltas)):
+            for result, values in zip(results[3:], expected[3:]):
+              if not same_value(result[number, h], values[number, h]):
+                matches = False
+      for number, vertex in enumerate(vertices):
+        if (graph.cdindex_components(vertex, 3)["iindex"] != expected[2][number] or
+            mapped.cdindex(number, 3) != graph.cdindex(vertex, 3)):
+          matches = False
+      del mapped
+  shutil.rmtree(directory)
+  print("Reordered graph matches: %s" % (matches))
+
+# tests for sampled estimates of the cd index
+def estimate_tests():
+  """Run tests comparing sampled estimates of the CD index with the exact values."""
+
+  # a focal vertex with many citers, some of which also cite its references
+  rng = random.Random(7)
+  graph = cdindex.Graph(names=False)
+  for reference in range(30):
+    graph.add_vertex(reference, 0)
+  graph.add_vertex(30, 1)
+  for reference in range(30):
+    graph.add_edge(30, reference)
+  for citer in range(31, 6031):
+    graph.add_vertex(citer, 2 + citer % 5)
+    cites_focal = rng.random() < 0.4
+    if cites_focal:
+      graph.add_edge(citer, 30)
+    if not cites_focal or rng.random() < 0.5:
+      for reference in rng.sample(range(30), rng.randint(1, 4)):
+        graph.add_edge(citer, reference)
+  exact = graph.cdindex(30, 10)
+
+  # unfrozen graphs and small vertices get the exact value
+  matches = graph.cdindex_estimate(30, 10)["exact"]
+  for by_time in (False, True):
+    graph.freeze(by_time=by_time)
+    result = graph.cdindex_estimate(30, 10, exact_below=100000)
+    if not result["exact"] or result["cdindex"] != exact or result["lower"] != exact:
+      matches = False
+    if graph.cdindex_estimate(31, 10, exact_below=0)["cdindex"] != graph.cdindex(31, 10):
+      matches = False
+
+    # larger ones are sampled until the interval is within the tolerance
+    for seed in (1, 2, 3):
+      result = graph.cdindex_estimate(30, 10, tolerance=0.05, exact_below=0, seed=seed)
+      if (result["exact"] or result["upper"] - result["lower"] > 0.1 + 1e-12 or
+          not result["lower"] <= exact <= result["upper"] or result["sampled"] >= 6000):
+        matches = False
+  print("Sampled cd index estimate matches: %s" % (matches))
+
+# tests for views of a graph as of a cutoff
+def view_tests():
+  """Run tests comparing views of a graph as of a cutoff with graphs rebuilt up to the cutoff."""
+
+  # some vertices also cite later ones, which a view must hide with them
+  base = random_graph()
+  vertices = list(base.vertices())
+  for vertex in vertices:
+    if base.timestamp(vertex) <= 3:
+      for later in vertices[-3:]:
+        base.add_edge(vertex, later)
+  t_deltas = [1, 3, 10]
+
+  def rebuild(kept):
+    kept_set = set(kept)
+    return cdindex.Graph(vertices=[{"name": vertex, "time": base.timestamp(vertex)} for vertex in kept],
+                         edges=[{"source": vertex, "target": target}
+                                for vertex in kept for target in base.out_edges(vertex)
+                                if target in kept_set])
+
+  # a snapshot of the whole graph, whose vertices are numbered as in vertices
+  directory = tempfile.mkdtemp()
+  path = os.path.join(directory, "graph.cdg")
+  rebuild(vertices).save_snapshot(path)
+
+  matches = True
+  for cutoff in (-1, 2, 4, 6):
+    kept = [vertex for vertex in vertices if base.timestamp(vertex) <= cutoff]
+    rebuilt = rebuild(kept)
+    expected = dict((vertex, [rebuilt.cdindex_components(vertex, t_delta) for t_delta in t_deltas])
+                    for vertex in kept)
+    if sorted(base.as_of(cutoff).vertices()) != sorted(kept):
+      matches = False
+    if sorted(cdindex.MappedGraph(path).as_of(cutoff).vertices()) != sorted(vertices.index(vertex) for vertex in kept):
+      matches = False
+    for kind in ("graph", "frozen", "ordered", "compressed", "mapped"):
+      graph = rebuild(vertices)
+      keys = vertices
+      if kind == "mapped":
+        graph = cdindex.MappedGraph(path)
+        keys = list(range(len(vertices)))
+      elif kind == "frozen":
+        graph.freeze()
+      elif kind == "ordered":
+        graph.freeze(by_time=True, order="rcm")
+      elif kind == "compressed":
+        graph.compress()
+      view = graph.as_of(cutoff)
+      results = [view.cdindex_batch(keys, 3), view.mcdindex_batch(keys, 3, threads=2),
+                 view.iindex_batch(keys, 3, threads=2),
+                 view.cdindex_multi_batch(keys, t_deltas, threads=2)]
+      if kind != "compressed":
+        counts = view.cdindex_all_counts(t_deltas)
+        sweep = view.cdindex_all(t_deltas)
+      for number, vertex in enumerate(vertices):
+
+        # hidden vertices are nan in batches and refused one at a time
+        if vertex not in expected:
+          if (results[0][number] == results[0][number] or results[2][number] != 0 or
+              (kind != "compressed" and (counts[0][number, 0] != 0 or sweep[number, 2] == sweep[number, 2]))):
+            matches = False
+          try:
+            view.cdindex(keys[number], 3)
+            matches = False
+          except ValueError:
+            pass
+          continue
+
+        for h, t_delta in enumerate(t_deltas):
+          components = expected[vertex][h]
+          value = none_to_nan(components["cdindex"])
+          key = keys[number]
+          if (view.cdindex_components(key, t_delta) != components or
+              view.cdindex(key, t_delta) != components["cdindex"] or
+              view.iindex(key, t_delta) != components["iindex"] or
+              view.cdindex_estimate(key, t_delta)["cdindex"] != components["cdindex"] or
+              not same_value(results[3][number, h], value)):
+            matches = False
+          if kind != "compressed" and (counts[0][number, h] != components["n_f"] or
+                                       counts[1][number, h] != components["n_b"] or
+                                       counts[2][number, h] != components["n_r"] or
+                                       not same_value(sweep[number, h], value)):
+            matches = False
+        components = expected[vertex][1]
+        if (not same_value(results[0][number], none_to_nan(components["cdindex"])) or
+            not same_value(results[1][number], none_to_nan(components["mcdindex"])) or
+            results[2][number] != components["iindex"]):
+          matches = False
+  print("Graph view matches: %s" % (matches))
+
+  # a reference after the cutoff is hidden: f cites a and the later r, and
+  # p cites f and r, so as of 3 p cites f but none of its references
+  graph = cdindex.Graph(vertices=[{"name": "a", "time": 0}, {"name": "f", "time": 1},
+                                  {"name": "p", "time": 2}, {"name": "r", "time": 5}],
+                        edges=[{"source": "f", "target": "a"}, {"source": "f", "target": "r"},
+                               {"source": "p", "target": "f"}, {"source": "p", "target": "r"}])
+  components = graph.as_of(3).cdindex_components("f", 2)
+  print("Graph view hides later references: %s" %
+        (components["n_f"] == 1 and components["n_b"] == 0 and components["cdindex"] == 1.0 and
+         graph.cdindex_components("f", 2)["cdindex"] == -1.0))
+
+# tests for graphs without vertex names
+def integer_id_tests():
+  """Run tests comparing a graph named by integer ids with a named graph."""
+
+  # build a named graph and the same graph with vertices named by their ids
+  graph = cdindex.Graph()
+  integer_graph = cdindex.Graph(names=False)
+  ids = {}
+  for vertex in pyvertices:
+    ids[vertex["name"]] = len(ids)
+    graph.add_vertex(vertex["name"], cdindex.timestamp_from_datetime(vertex["time"]))
+    integer_graph.add_vertex(ids[vertex["name"]], cdindex.timestamp_from_datetime(vertex["time"]))
+  for edge in pyedges:
+    graph.add_edge(edge["source"], edge["target"])
+    integer_graph.add_edge(ids[edge["source"]], ids[edge["target"]])
+
+  # compare the graphs
+  t_delta = int(TEST_TIME_PY.total_seconds())
+  matches = (list(integer_graph.vertices()) == list(range(len(pyvertices))) and
+             integer_graph.ecount() == graph.ecount())
+  for name, vertex in ids.items():
+    if (integer_graph.cdindex(vertex, t_delta) != graph.cdindex(name, t_delta) or
+        integer_graph.out_edges(vertex) != [ids[target] for target in graph.out_edges(name)] or
+        integer_graph.timestamp(vertex) != graph.timestamp(name)):
+      matches = False
+  batch = integer_graph.cdindex_batch(array.array("q", ids.values()), t_delta)
+  expected = graph.cdindex_batch(list(ids.keys()), t_delta)
+  for vertex in ids.values():
+    if not same_value(batch[vertex], expected[vertex]):
+      matches = False
+  print("Integer id graph matches: %s" % (matches))
+
+  # invalid vertices and repeated edges are rejected by the C extension
+  rejected = 0
+  for add in (lambda: integer_graph.add_vertex(0, 0),
+              lambda: integer_graph.add_edge(4, 2),
+              lambda: integer_graph.add_edge(4, len(pyvertices)),
+              lambda: graph.add_edge("4Z", "2Z"),
+              lambda: integer_graph.cdindex(len(pyvertices), t_delta)):
+    try:
+      add()
+    except (ValueError, KeyError):
+      rejected += 1
+  print("Integer id graph invalid input rejected: %s" % (rejected == 5 and integer_graph.ecount() == len(pyedges)))
+
+# tests for building graphs from arrays and viewing their arrays
+def array_tests():
+  """Run tests comparing graphs built from arrays with graphs built from lists."""
+
+  # build the same graph from lists, 64 bit arrays and a 32 bit edge array
+  graph = _cdindex.Graph()
+  _cdindex.bulk_load_graph(graph, range(len(ctimes)), ctimes, cedges)
+  flat_edges = [vertex for edge in cedges for vertex in edge]
+  array_graph = cdindex.cdindex.Graph()
+  array_graph.bulk_load_arrays(array.array("q", ctimes), array.array("q", flat_edges))
+  narrow_graph = _cdindex.Graph()
+  _cdindex.bulk_load_arrays(narrow_graph, array.array("q", range(len(ctimes))),
+                            array.array("q", ctimes),
+                            memoryview(array.array("i", flat_edges)).cast("B").cast("i", (len(cedges), 2)))
+  matches = (array_graph.vcount() == len(ctimes) and array_graph.ecount() == len(cedges) and
+             _cdindex.get_ecount(narrow_graph) == len(cedges))
+  for vertex in _cdindex.get_vertices(graph):
+    expected = _cdindex.cdindex(graph, vertex, TEST_TIME)
+    value = array_graph.cdindex(vertex, TEST_TIME)
+    if (not same_value(none_to_nan(value), expected) or
+        not same_value(_cdindex.cdindex(narrow_graph, vertex, TEST_TIME), expected)):
+      matches = False
+
+  # the arrays of the frozen graph hold its edges, and ids may be an array
+  arrays = array_graph.arrays(by_time=True)
+  in_offsets, in_edges = arrays["in_offsets"], arrays["in_edges"]
+  for vertex in _cdindex.get_vertices(graph):
+    if (sorted(in_edges[in_offsets[vertex]:in_offsets[vertex + 1]]) !=
+        sorted(_cdindex.get_vertex_in_edges(graph, vertex))):
+      matches = False
+  batch = array_graph.cdindex_batch(array.array("q", range(len(ctimes))), TEST_TIME)
+  for vertex in _cdindex.get_vertices(graph):
+    if not same_value(batch[vertex], _cdindex.cdindex(graph, vertex, TEST_TIME)):
+      matches = False
+  matches = (matches and list(arrays["timestamps"]) == list(ctimes) and arrays["in_edges"].readonly and
+             len(arrays["in_times"]) == len(cedges) and arrays["out_offsets"][-1] == len(cedges))
+
+  # the views stay valid after the graph changes
+  array_graph.bulk_load_arrays(array.array("q", [ctimes[-1]]), array.array("q", [len(ctimes), 0]))
+  matches = (matches and array_graph.vcount() == len(ctimes) + 1 and
+             len(arrays["timestamps"]) == len(ctimes) and arrays["in_offsets"][-1] == len(cedges))
+  print("Array bridge matches: %s" % (matches))
+
+  # arrays of other types and odd edge counts are rejected
+  rejected = 0
+  for timestamps, edges in ((array.array("d", ctimes), array.array("q")),
+                            (array.array("q", ctimes), array.array("q", [0]))):
+    try:
+      _cdindex.bulk_load_arrays(_cdindex.Graph(), None, timestamps, edges)
+    except (TypeError, ValueError):
+      rejected += 1
+  print("Array bridge invalid arrays rejected: %s" % (rejected == 2))
+
 def main():
 
   # run c tests
@@ -145,6 +906,60 @@ def main():
   # run python tests
   py_tests()
 
+  # run frozen graph tests
+  frozen_tests()
+
+  # run bulk loading tests
+  bulk_tests()
+
+  # run sorted adjacency tests
+  sorted_tests()
+
+  # run batch function tests
+  batch_tests()
+
+  # run multi-horizon tests
+  multi_tests()
+
+  # run snapshot tests
+  snapshot_tests()
+
+  # run streaming tests
+  stream_tests()
+
+  # run threaded computation tests
+  thread_tests()
+
+  # run compact graph tests
+  compact_tests()
+
+  # run compressed graph tests
+  compressed_tests()
+
+  # run computation counter tests
+  stats_tests()
+
+  # run array bridge tests
+  array_tests()
+
+  # run integer id graph tests
+  integer_id_tests()
+
+  # run all-vertex sweep tests
+  sweep_tests()
+
+  # run cd index components tests
+  components_tests()
+
+  # run reordered graph tests
+  ordering_tests()
+
+  # run sampled estimate tests
+  estimate_tests()
+
+  # run graph view tests
+  view_tests()
+
   # generate random graph
   g = cdindex.RandomGraph(generations=(2,3,4,5,6,7,7,9), edge_fraction=1)
   